@@ -94,6 +94,10 @@ static uint64_t *alloc_pte(void)
 
 	return (void *)get_ttb() + idx * GRANULE_SIZE;
 }
+
+static void free_pte(uint64_t *table)
+{
+}
 #else
 static uint64_t *alloc_pte(void)
 {
@@ -104,6 +108,18 @@ static uint64_t *alloc_pte(void)
 
 	return new_table;
 }
+
+static void free_pte(uint64_t *table)
+{
+	void *early_ttb = get_ttb();
+
+	/* tables handed out from the early page table area stay there */
+	if ((void *)table >= early_ttb &&
+	    (void *)table < early_ttb + ARM_EARLY_PAGETABLE_SIZE)
+		return;
+
+	free(table);
+}
 #endif
 
 /**
@@ -192,12 +208,52 @@ static void split_block(uint64_t *pte, int level, bool bbm)
 	set_pte_range(level, pte, (uint64_t)new_table, 1, PTE_TYPE_TABLE, bbm);
 }
 
+/*
+ * Replaces the table @pte points to by a single block entry, if all its
+ * entries map one naturally aligned region with identical attributes.
+ * Changing the block size of a live mapping needs break-before-make,
+ * which is still missing, so this must only be used while the MMU is
+ * off. Later remaps would otherwise have to split blocks barebox is
+ * using, like its heap, stack and page tables.
+ */
+static bool coalesce_table(uint64_t *pte, int level)
+{
+	uint64_t *table = get_level_table(pte);
+	size_t granularity = granule_size(level + 1);
+	uint64_t first = table[0];
+	uint64_t type = (level + 1 == 3) ? PTE_TYPE_PAGE : PTE_TYPE_BLOCK;
+	int i;
+
+	/* 4k granule has no level 0 blocks */
+	if (level < 1)
+		return false;
+
+	if ((first & PTE_TYPE_MASK) != type ||
+	    !IS_ALIGNED(first & XLAT_ADDR_MASK, granule_size(level)))
+		return false;
+
+	for (i = 1; i < MAX_PTE_ENTRIES; i++)
+		if (table[i] != first + i * granularity)
+			return false;
+
+	set_pte_range(level, pte, first & XLAT_ADDR_MASK, 1,
+		      (first & ~(XLAT_ADDR_MASK | PTE_TYPE_MASK)) | PTE_TYPE_BLOCK,
+		      false);
+
+	/* walk caches may still reference the table until invalidated */
+	tlb_invalidate();
+	free_pte(table);
+
+	return true;
+}
+
 static int __arch_remap_range(uint64_t virt, uint64_t phys, uint64_t size,
 			      maptype_t map_type, bool bbm)
 {
 	bool force_pages = map_type & ARCH_MAP_FLAG_PAGEWISE;
 	unsigned long attr = get_pte_attrs(map_type);
 	uint64_t *ttb = get_ttb();
+	uint64_t *ptes[4];
 	uint64_t block_size;
 	uint64_t block_shift;
 	uint64_t *pte;
@@ -205,6 +261,7 @@ static int __arch_remap_range(uint64_t virt, uint64_t phys, uint64_t size,
 	uint64_t addr;
 	uint64_t *table;
 	uint64_t type;
+	uint64_t count;
 	int level;
 
 	addr = virt;
@@ -229,6 +286,7 @@ static int __arch_remap_range(uint64_t virt, uint64_t phys, uint64_t size,
 			block_size = (1ULL << block_shift);
 
 			pte = table + idx;
+			ptes[level] = pte;
 
 			block_aligned = size >= block_size &&
 				        IS_ALIGNED(addr, block_size) &&
@@ -238,10 +296,26 @@ static int __arch_remap_range(uint64_t virt, uint64_t phys, uint64_t size,
 				type = (level == 3) ?
 					PTE_TYPE_PAGE : PTE_TYPE_BLOCK;
 
-				set_pte_range(level, pte, phys, 1, attr | type, bbm);
-				addr += block_size;
-				phys += block_size;
-				size -= block_size;
+				/*
+				 * Write all entries of this table the range
+				 * covers at once, so the table is flushed once
+				 */
+				count = min_t(uint64_t, size >> block_shift,
+					      MAX_PTE_ENTRIES - idx);
+
+				set_pte_range(level, pte, phys, count, attr | type, bbm);
+				addr += count * block_size;
+				phys += count * block_size;
+				size -= count * block_size;
+
+				/*
+				 * merge the tables back into blocks when
+				 * possible, bbm is only requested for
+				 * changes to the live page tables
+				 */
+				while (level-- > 1 && !force_pages && !bbm &&
+				       coalesce_table(ptes[level], level))
+					;
 				break;
 			} else {
 				split_block(pte, level, bbm);
@@ -286,7 +360,11 @@ int arch_remap_range(void *virt_addr, phys_addr_t phys_addr, size_t size, maptyp
 {
 	map_type = arm_mmu_maybe_skip_permissions(map_type);
 
-	if (!maptype_is_compatible(map_type, MAP_CACHED))
+	/*
+	 * Only ranges that stop being cacheable need flushing, remapping
+	 * between the cached variants leaves the cache contents valid.
+	 */
+	if (!pte_is_cacheable(get_pte_attrs(map_type), 0))
 		flush_cacheable_pages(virt_addr, size);
 
 	return __arch_remap_range((uint64_t)virt_addr, phys_addr, (uint64_t)size, map_type, true);
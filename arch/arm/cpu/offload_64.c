@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Start secondary CPUs over PSCI and park them in the offload loop
+ */
+
+#define pr_fmt(fmt) "offload: " fmt
+
+#include <common.h>
+#include <init.h>
+#include <clock.h>
+#include <malloc.h>
+#include <offload.h>
+#include <of.h>
+#include <asm/cache.h>
+#include <asm/psci.h>
+#include <asm/system.h>
+#include <linux/sizes.h>
+
+#define MPIDR_HWID_BITMASK	0xff00ffffffUL
+#define OFFLOAD_STACK_SIZE	SZ_32K
+
+/* read with MMU off by offload-entry_64.S, keep in sync */
+struct arm_offload_ctx {
+	u64 mair;
+	u64 tcr;
+	u64 ttbr0;
+	u64 sctlr;
+	u64 vbar;
+	u64 sp;
+};
+
+struct arm_offload_cpu {
+	struct arm_offload_ctx ctx;
+	struct offload_cpu cpu;
+	struct list_head list;
+	u64 mpidr;
+	void *stack;
+};
+
+static LIST_HEAD(arm_offload_cpus);
+
+void arm_offload_secondary_entry(void);
+extern char arm_offload_secondary_entry_end[];
+
+void __noreturn arm_offload_secondary_main(struct arm_offload_ctx *ctx);
+
+void __noreturn arm_offload_secondary_main(struct arm_offload_ctx *ctx)
+{
+	struct arm_offload_cpu *acpu = container_of(ctx, struct arm_offload_cpu, ctx);
+
+	offload_cpu_main(&acpu->cpu);
+
+	psci_invoke(ARM_PSCI_0_2_FN_CPU_OFF, 0, 0, 0, NULL);
+
+	while (1)
+		asm volatile("wfe");
+}
+
+static void arm_offload_ctx_init(struct arm_offload_ctx *ctx)
+{
+	switch (current_el()) {
+	case 2:
+		asm volatile("mrs %0, mair_el2" : "=r" (ctx->mair));
+		asm volatile("mrs %0, tcr_el2" : "=r" (ctx->tcr));
+		asm volatile("mrs %0, ttbr0_el2" : "=r" (ctx->ttbr0));
+		asm volatile("mrs %0, vbar_el2" : "=r" (ctx->vbar));
+		asm volatile("mrs %0, sctlr_el2" : "=r" (ctx->sctlr));
+		break;
+	case 1:
+		asm volatile("mrs %0, mair_el1" : "=r" (ctx->mair));
+		asm volatile("mrs %0, tcr_el1" : "=r" (ctx->tcr));
+		asm volatile("mrs %0, ttbr0_el1" : "=r" (ctx->ttbr0));
+		asm volatile("mrs %0, vbar_el1" : "=r" (ctx->vbar));
+		asm volatile("mrs %0, sctlr_el1" : "=r" (ctx->sctlr));
+		break;
+	}
+}
+
+static int arm_offload_cpu_up(u64 mpidr, unsigned int id)
+{
+	struct arm_offload_cpu *acpu;
+	u64 start;
+	int ret;
+
+	acpu = xmemalign(L1_CACHE_BYTES, ALIGN(sizeof(*acpu), L1_CACHE_BYTES));
+	memset(acpu, 0, sizeof(*acpu));
+
+	acpu->mpidr = mpidr;
+	acpu->cpu.id = id;
+	acpu->stack = xmemalign(16, OFFLOAD_STACK_SIZE);
+
+	arm_offload_ctx_init(&acpu->ctx);
+	acpu->ctx.sp = (ulong)acpu->stack + OFFLOAD_STACK_SIZE;
+
+	/* The secondary reads these with MMU and caches disabled */
+	v8_flush_dcache_range((ulong)&acpu->ctx, (ulong)(&acpu->ctx + 1));
+	v8_flush_dcache_range((ulong)arm_offload_secondary_entry,
+			      (ulong)arm_offload_secondary_entry_end);
+
+	ret = psci_invoke(ARM_PSCI_0_2_FN64_CPU_ON, mpidr,
+			  (ulong)arm_offload_secondary_entry,
+			  (ulong)&acpu->ctx, NULL);
+	if (ret) {
+		pr_debug("CPU 0x%llx: CPU_ON failed: %pe\n", mpidr, ERR_PTR(ret));
+		goto err_free;
+	}
+
+	start = get_time_ns();
+	while (!READ_ONCE(acpu->cpu.running)) {
+		if (is_timeout(start, 100 * MSECOND)) {
+			/* CPU may still come up later, so don't free its stack */
+			pr_warn("CPU 0x%llx did not come up\n", mpidr);
+			return -ETIMEDOUT;
+		}
+	}
+
+	list_add_tail(&acpu->list, &arm_offload_cpus);
+	offload_cpu_register(&acpu->cpu);
+
+	return 0;
+
+err_free:
+	free(acpu->stack);
+	free(acpu);
+
+	return ret;
+}
+
+static int arm_offload_init(void)
+{
+	struct device_node *cpus, *np;
+	u64 self = read_mpidr() & MPIDR_HWID_BITMASK;
+	unsigned int id = 1;
+	int ret;
+
+	if (current_el() == 3)
+		return 0;
+
+	if (psci_get_version() < ARM_PSCI_VER(0, 2))
+		return 0;
+
+	cpus = of_find_node_by_path("/cpus");
+	if (!cpus)
+		return 0;
+
+	for_each_child_of_node(cpus, np) {
+		const __be32 *reg;
+		const char *type, *method;
+		u64 mpidr;
+		int len;
+
+		if (of_property_read_string(np, "device_type", &type) ||
+		    strcmp(type, "cpu") || !of_device_is_available(np))
+			continue;
+
+		if (of_property_read_string(np, "enable-method", &method) ||
+		    strcmp(method, "psci"))
+			continue;
+
+		reg = of_get_property(np, "reg", &len);
+		if (!reg || len < of_n_addr_cells(np) * sizeof(*reg))
+			continue;
+
+		mpidr = of_read_number(reg, of_n_addr_cells(np)) & MPIDR_HWID_BITMASK;
+		if (mpidr == self)
+			continue;
+
+		ret = arm_offload_cpu_up(mpidr, id);
+		if (!ret)
+			id++;
+	}
+
+	if (id > 1)
+		pr_info("%u secondary CPUs parked\n", id - 1);
+
+	return 0;
+}
+late_initcall(arm_offload_init);
+
+static void arm_offload_shutdown(void)
+{
+	struct arm_offload_cpu *acpu;
+	ulong state;
+	u64 start;
+
+	offload_cpus_stop();
+
+	list_for_each_entry(acpu, &arm_offload_cpus, list) {
+		start = get_time_ns();
+
+		do {
+			psci_invoke(ARM_PSCI_0_2_FN64_AFFINITY_INFO, acpu->mpidr,
+				    0, 0, &state);
+			if (state == PSCI_AFFINITY_LEVEL_OFF)
+				break;
+		} while (!is_timeout_non_interruptible(start, 100 * MSECOND));
+
+		if (state != PSCI_AFFINITY_LEVEL_OFF)
+			pr_warn("CPU 0x%llx did not power down\n", acpu->mpidr);
+	}
+}
+prearchshutdown_exitcall(arm_offload_shutdown);
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * crc32-ce-glue.c - CRC32 using the ARMv8 CRC32 instructions
+ */
+
+#include <common.h>
+#include <digest.h>
+#include <init.h>
+#include <asm/byteorder.h>
+#include <asm/unaligned.h>
+#include <asm/sysreg.h>
+
+#include <crc.h>
+#include <crypto/crc.h>
+#include <crypto/internal.h>
+
+static bool crc32_ce_supported;
+
+static u32 crc32_arm64_le(u32 crc, const u8 *p, unsigned long len)
+{
+	while (len >= 8) {
+		crc = __builtin_aarch64_crc32x(crc, get_unaligned_le64(p));
+		p += 8;
+		len -= 8;
+	}
+
+	if (len & 4) {
+		crc = __builtin_aarch64_crc32w(crc, get_unaligned_le32(p));
+		p += 4;
+	}
+
+	if (len & 2) {
+		crc = __builtin_aarch64_crc32h(crc, get_unaligned_le16(p));
+		p += 2;
+	}
+
+	if (len & 1)
+		crc = __builtin_aarch64_crc32b(crc, *p);
+
+	return crc;
+}
+
+uint32_t crc32_le_arch(uint32_t crc, const void *buf, unsigned int len)
+{
+	if (!crc32_ce_supported)
+		return crc32_le_base(crc, buf, len);
+
+	return crc32_arm64_le(crc, buf, len);
+}
+
+static int crc32_ce_init(struct digest *desc)
+{
+	struct crc32_state *ctx = digest_ctx(desc);
+
+	ctx->crc = 0;
+
+	return 0;
+}
+
+static int crc32_ce_update(struct digest *desc, const void *data,
+			   unsigned long len)
+{
+	struct crc32_state *ctx = digest_ctx(desc);
+
+	ctx->crc = ~crc32_arm64_le(~ctx->crc, data, len);
+
+	return 0;
+}
+
+static int crc32_ce_final(struct digest *desc, unsigned char *md)
+{
+	struct crc32_state *ctx = digest_ctx(desc);
+	__be32 *dst = (__be32 *)md;
+
+	dst[0] = cpu_to_be32(ctx->crc);
+
+	memset(ctx, 0, sizeof *ctx);
+
+	return 0;
+}
+
+static struct digest_algo crc32_ce = {
+	.base = {
+		.name		=	"crc32",
+		.driver_name	=	"crc32-ce",
+		.priority	=	200,
+		.algo		=	HASH_ALGO_CRC32,
+	},
+
+	.init		= crc32_ce_init,
+	.update		= crc32_ce_update,
+	.final		= crc32_ce_final,
+	.digest		= digest_generic_digest,
+	.verify		= digest_generic_verify,
+	.length		= CRC32_DIGEST_SIZE,
+	.ctx_length	= sizeof(struct crc32_state),
+};
+
+static int crc32_ce_digest_register(void)
+{
+	uint64_t isar0;
+
+	isar0 = read_sysreg(ID_AA64ISAR0_EL1);
+	if (!(isar0 & ID_AA64ISAR0_EL1_CRC32_MASK))
+		return -EOPNOTSUPP;
+
+	crc32_ce_supported = true;
+
+	return digest_algo_register(&crc32_ce);
+}
+coredevice_initcall(crc32_ce_digest_register);
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * sha512-ce-glue.c - SHA-384/SHA-512 using ARMv8 Crypto Extensions
+ *
+ * Copyright (C) 2018 Linaro Ltd <ard.biesheuvel@linaro.org>
+ */
+
+#include <common.h>
+#include <digest.h>
+#include <init.h>
+#include <crypto/sha.h>
+#include <crypto/sha512_base.h>
+#include <crypto/internal.h>
+#include <linux/linkage.h>
+#include <linux/bitfield.h>
+#include <asm/byteorder.h>
+#include <asm/neon.h>
+#include <asm/sysreg.h>
+
+MODULE_DESCRIPTION("SHA-384/SHA-512 secure hash using ARMv8 Crypto Extensions");
+MODULE_AUTHOR("Ard Biesheuvel <ard.biesheuvel@linaro.org>");
+MODULE_LICENSE("GPL v2");
+MODULE_ALIAS_CRYPTO("sha384");
+MODULE_ALIAS_CRYPTO("sha512");
+
+asmlinkage int sha512_ce_transform(struct sha512_state *sst, u8 const *src,
+				   int blocks);
+
+static void __sha512_ce_transform(struct sha512_state *sst, u8 const *src,
+				  int blocks)
+{
+	while (blocks) {
+		int rem;
+
+		kernel_neon_begin();
+		rem = sha512_ce_transform(sst, src, blocks);
+		kernel_neon_end();
+		src += (blocks - rem) * SHA512_BLOCK_SIZE;
+		blocks = rem;
+	}
+}
+
+static int sha512_ce_update(struct digest *desc, const void *data,
+			    unsigned long len)
+{
+	sha512_base_do_update(desc, data, len, __sha512_ce_transform);
+
+	return 0;
+}
+
+static int sha512_ce_final(struct digest *desc, u8 *out)
+{
+	sha512_base_do_finalize(desc, __sha512_ce_transform);
+	return sha512_base_finish(desc, out);
+}
+
+static struct digest_algo sha384 = {
+	.base = {
+		.name		=	"sha384",
+		.driver_name	=	"sha384-ce",
+		.priority	=	200,
+		.algo		=	HASH_ALGO_SHA384,
+	},
+
+	.length	=	SHA384_DIGEST_SIZE,
+	.init	=	sha384_base_init,
+	.update	=	sha512_ce_update,
+	.final	=	sha512_ce_final,
+	.digest	=	digest_generic_digest,
+	.verify	=	digest_generic_verify,
+	.ctx_length =	sizeof(struct sha512_state),
+};
+
+static struct digest_algo sha512 = {
+	.base = {
+		.name		=	"sha512",
+		.driver_name	=	"sha512-ce",
+		.priority	=	200,
+		.algo		=	HASH_ALGO_SHA512,
+	},
+
+	.length	=	SHA512_DIGEST_SIZE,
+	.init	=	sha512_base_init,
+	.update	=	sha512_ce_update,
+	.final	=	sha512_ce_final,
+	.digest	=	digest_generic_digest,
+	.verify	=	digest_generic_verify,
+	.ctx_length =	sizeof(struct sha512_state),
+};
+
+static int sha512_ce_digest_register(void)
+{
+	uint64_t isar0;
+	int ret;
+
+	isar0 = read_sysreg(ID_AA64ISAR0_EL1);
+	if (FIELD_GET(ID_AA64ISAR0_EL1_SHA2_MASK, isar0) < 2)
+		return -EOPNOTSUPP;
+
+	ret = digest_algo_register(&sha384);
+	if (ret)
+		return ret;
+
+	return digest_algo_register(&sha512);
+}
+coredevice_initcall(sha512_ce_digest_register);
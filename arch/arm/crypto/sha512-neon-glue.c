@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * sha512-neon-glue.c - SHA-384/SHA-512 using NEON on 32 bit ARM
+ */
+
+#include <common.h>
+#include <digest.h>
+#include <init.h>
+#include <crypto/sha.h>
+#include <crypto/sha512_base.h>
+#include <crypto/internal.h>
+#include <linux/linkage.h>
+#include <asm/byteorder.h>
+#include <asm/neon.h>
+
+asmlinkage void sha512_neon_transform(struct sha512_state *sst, u8 const *src,
+				      int blocks);
+asmlinkage int sha512_neon_enable(void);
+
+static void __sha512_neon_transform(struct sha512_state *sst, u8 const *src,
+				    int blocks)
+{
+	kernel_neon_begin();
+	sha512_neon_transform(sst, src, blocks);
+	kernel_neon_end();
+}
+
+static int sha512_neon_update(struct digest *desc, const void *data,
+			      unsigned long len)
+{
+	sha512_base_do_update(desc, data, len, __sha512_neon_transform);
+
+	return 0;
+}
+
+static int sha512_neon_final(struct digest *desc, u8 *out)
+{
+	sha512_base_do_finalize(desc, __sha512_neon_transform);
+	return sha512_base_finish(desc, out);
+}
+
+static struct digest_algo sha384 = {
+	.base = {
+		.name		=	"sha384",
+		.driver_name	=	"sha384-neon",
+		.priority	=	150,
+		.algo		=	HASH_ALGO_SHA384,
+	},
+
+	.length	=	SHA384_DIGEST_SIZE,
+	.init	=	sha384_base_init,
+	.update	=	sha512_neon_update,
+	.final	=	sha512_neon_final,
+	.digest	=	digest_generic_digest,
+	.verify	=	digest_generic_verify,
+	.ctx_length =	sizeof(struct sha512_state),
+};
+
+static struct digest_algo sha512 = {
+	.base = {
+		.name		=	"sha512",
+		.driver_name	=	"sha512-neon",
+		.priority	=	150,
+		.algo		=	HASH_ALGO_SHA512,
+	},
+
+	.length	=	SHA512_DIGEST_SIZE,
+	.init	=	sha512_base_init,
+	.update	=	sha512_neon_update,
+	.final	=	sha512_neon_final,
+	.digest	=	digest_generic_digest,
+	.verify	=	digest_generic_verify,
+	.ctx_length =	sizeof(struct sha512_state),
+};
+
+static int sha512_neon_digest_register(void)
+{
+	int ret;
+
+	if (sha512_neon_enable())
+		return -EOPNOTSUPP;
+
+	ret = digest_algo_register(&sha384);
+	if (ret)
+		return ret;
+
+	return digest_algo_register(&sha512);
+}
+coredevice_initcall(sha512_neon_digest_register);
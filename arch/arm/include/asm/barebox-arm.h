@@ -100,7 +100,8 @@ void *barebox_arm_boot_dtb(void);
  *                                   ↓
  *  ---------------------- arm_mem_barebox_image() ---------------------
  *                                   ↑
- *                                SZ_128K
+ *                       ARM_MEM_EARLY_MALLOC_SIZE
+ *              (SZ_256K with IMAGE_COMPRESSION_ZSTD, else SZ_128K)
  *                                   ↓
  *  ------------------------ arm_mem_early_malloc ----------------------
  */
@@ -144,7 +145,12 @@ static inline unsigned long arm_mem_ttb(unsigned long endmem)
 	return endmem;
 }
 
+#ifdef CONFIG_IMAGE_COMPRESSION_ZSTD
+/* the zstd decompression context alone is bigger than 128K */
+#define ARM_MEM_EARLY_MALLOC_SIZE	SZ_256K
+#else
 #define ARM_MEM_EARLY_MALLOC_SIZE	SZ_128K
+#endif
 
 static inline unsigned long arm_mem_ramoops(unsigned long endmem)
 {
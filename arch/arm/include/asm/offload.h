@@ -0,0 +1,24 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __ASM_OFFLOAD_H
+#define __ASM_OFFLOAD_H
+
+/* order mailbox accesses between boot and secondary CPUs */
+static inline void offload_mb(void)
+{
+	asm volatile("dmb ish" : : : "memory");
+}
+
+/* wait for an event from another CPU */
+static inline void offload_cpu_idle(void)
+{
+	asm volatile("wfe" : : : "memory");
+}
+
+/* make preceding stores visible and wake up CPUs waiting in wfe */
+static inline void offload_cpu_kick(void)
+{
+	asm volatile("dsb ishst\n\tsev" : : : "memory");
+}
+
+#endif /* __ASM_OFFLOAD_H */
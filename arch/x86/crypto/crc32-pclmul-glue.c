@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * CRC32 using the PCLMULQDQ carry-less multiplication instruction
+ *
+ * Folding constants and the Barrett reduction are taken from the Linux
+ * crc32-pclmul implementation, which is based on the Intel white paper
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+ */
+
+#include <common.h>
+#include <digest.h>
+#include <init.h>
+#include <crc.h>
+#include <asm/byteorder.h>
+
+#include <crypto/crc.h>
+#include <crypto/internal.h>
+
+typedef long long v2di __attribute__((vector_size(16)));
+typedef long long v2di_u __attribute__((vector_size(16), aligned(1)));
+typedef unsigned long long v2du __attribute__((vector_size(16)));
+
+static bool crc32_pclmul_supported;
+
+#define PCLMUL_MIN_LEN	64
+#define PCLMUL_ALIGN	16
+
+#define clmul(a, b, imm)	__builtin_ia32_pclmulqdq128((a), (b), (imm))
+
+static inline v2di load128(const u8 *p)
+{
+	return *(const v2di_u *)p;
+}
+
+static inline v2di fold128(v2di x, v2di k)
+{
+	return clmul(x, k, 0x00) ^ clmul(x, k, 0x11);
+}
+
+/*
+ * Computes the non-inverted CRC32 (like crc32_no_comp()) over len bytes,
+ * len must be a multiple of 16 and at least PCLMUL_MIN_LEN.
+ */
+static u32 crc32_pclmul_le_16(u32 crc, const u8 *p, size_t len)
+{
+	const v2di k1k2 = { 0x154442bd4, 0x1c6e41596 };
+	const v2di k3k4 = { 0x1751997d0, 0x0ccaa009e };
+	const v2di k5 = { 0x163cd6124, 0 };
+	const v2di poly = { 0x1db710641, 0x1f7011641 };
+	const v2di mask32 = { 0xffffffff, 0 };
+	v2di x0, x1, x2, x3;
+	v2du t;
+
+	x0 = load128(p) ^ (v2di){ crc, 0 };
+	x1 = load128(p + 16);
+	x2 = load128(p + 32);
+	x3 = load128(p + 48);
+	p += 64;
+	len -= 64;
+
+	/* fold four 128 bit lanes in parallel */
+	while (len >= 64) {
+		x0 = fold128(x0, k1k2) ^ load128(p);
+		x1 = fold128(x1, k1k2) ^ load128(p + 16);
+		x2 = fold128(x2, k1k2) ^ load128(p + 32);
+		x3 = fold128(x3, k1k2) ^ load128(p + 48);
+		p += 64;
+		len -= 64;
+	}
+
+	/* reduce to a single lane and consume the remainder */
+	x0 = fold128(x0, k3k4) ^ x1;
+	x0 = fold128(x0, k3k4) ^ x2;
+	x0 = fold128(x0, k3k4) ^ x3;
+
+	while (len >= 16) {
+		x0 = fold128(x0, k3k4) ^ load128(p);
+		p += 16;
+		len -= 16;
+	}
+
+	/* fold 128 to 64 bits, this also appends 32 zero bits */
+	x0 = clmul(x0, k3k4, 0x10) ^ (v2di){ x0[1], 0 };
+
+	/* final 32 bit fold */
+	t = (v2du)x0;
+	x1 = (v2di){ (t[0] >> 32) | (t[1] << 32), t[1] >> 32 };
+	x0 = clmul(x0 & mask32, k5, 0x00) ^ x1;
+
+	/* bit reflected Barrett reduction from 64 to 32 bits */
+	x1 = clmul(x0 & mask32, poly, 0x10);
+	x1 = clmul(x1 & mask32, poly, 0x00) ^ x0;
+
+	return (u64)x1[0] >> 32;
+}
+
+static u32 crc32_pclmul_le(u32 crc, const u8 *p, size_t len)
+{
+	size_t prealign, chunk;
+
+	if (len < PCLMUL_MIN_LEN + PCLMUL_ALIGN - 1)
+		return crc32_le_base(crc, p, len);
+
+	prealign = -(uintptr_t)p & (PCLMUL_ALIGN - 1);
+	if (prealign) {
+		crc = crc32_le_base(crc, p, prealign);
+		p += prealign;
+		len -= prealign;
+	}
+
+	chunk = len & ~(size_t)(PCLMUL_ALIGN - 1);
+	crc = crc32_pclmul_le_16(crc, p, chunk);
+
+	return crc32_le_base(crc, p + chunk, len - chunk);
+}
+
+uint32_t crc32_le_arch(uint32_t crc, const void *buf, unsigned int len)
+{
+	if (!crc32_pclmul_supported)
+		return crc32_le_base(crc, buf, len);
+
+	return crc32_pclmul_le(crc, buf, len);
+}
+
+static int crc32_pclmul_init(struct digest *desc)
+{
+	struct crc32_state *ctx = digest_ctx(desc);
+
+	ctx->crc = 0;
+
+	return 0;
+}
+
+static int crc32_pclmul_update(struct digest *desc, const void *data,
+			       unsigned long len)
+{
+	struct crc32_state *ctx = digest_ctx(desc);
+
+	ctx->crc = ~crc32_pclmul_le(~ctx->crc, data, len);
+
+	return 0;
+}
+
+static int crc32_pclmul_final(struct digest *desc, unsigned char *md)
+{
+	struct crc32_state *ctx = digest_ctx(desc);
+	__be32 *dst = (__be32 *)md;
+
+	dst[0] = cpu_to_be32(ctx->crc);
+
+	memset(ctx, 0, sizeof *ctx);
+
+	return 0;
+}
+
+static struct digest_algo crc32_pclmul = {
+	.base = {
+		.name		=	"crc32",
+		.driver_name	=	"crc32-pclmul",
+		.priority	=	200,
+		.algo		=	HASH_ALGO_CRC32,
+	},
+
+	.init		= crc32_pclmul_init,
+	.update		= crc32_pclmul_update,
+	.final		= crc32_pclmul_final,
+	.digest		= digest_generic_digest,
+	.verify		= digest_generic_verify,
+	.length		= CRC32_DIGEST_SIZE,
+	.ctx_length	= sizeof(struct crc32_state),
+};
+
+#define CPUID_1_ECX_PCLMULQDQ	BIT(1)
+
+static int crc32_pclmul_register(void)
+{
+	u32 eax = 1, ebx, ecx = 0, edx;
+
+	asm volatile("cpuid"
+		     : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+
+	if (!(ecx & CPUID_1_ECX_PCLMULQDQ))
+		return -EOPNOTSUPP;
+
+	crc32_pclmul_supported = true;
+
+	return digest_algo_register(&crc32_pclmul);
+}
+coredevice_initcall(crc32_pclmul_register);
@@ -5,20 +5,91 @@
 #include <block.h>
 #include <getopt.h>
 #include <fs.h>
+#include <iostat.h>
+#include <linux/mtd/mtd.h>
+
+static void blkstats_print_iostat_json(const char *name, const struct iostat *s)
+{
+	int i;
+
+	printf(", \"%s\": { \"requests\": %llu, \"errors\": %llu, "
+	       "\"bytes\": %llu, \"time_ns\": %llu, \"latency\": [",
+	       name, s->requests, s->errors, s->bytes, s->time_ns);
+
+	for (i = 0; i < IOSTAT_LATENCY_BUCKETS; i++)
+		printf("%s%u", i ? ", " : "", s->latency[i]);
+
+	printf("] }");
+}
+
+static void blkstats_print_json(const char *name)
+{
+	struct block_device *blk;
+	bool first = true;
+
+	printf("{ \"devices\": [\n");
+
+	for_each_block_device(blk) {
+		struct block_device_stats *stats = &blk->stats;
+
+		if (name && strcmp(name, blk->cdev.name))
+			continue;
+
+		printf("%s  { \"name\": \"%s\", \"type\": \"block\", "
+		       "\"block_size\": %u, \"read_sectors\": %llu, "
+		       "\"write_sectors\": %llu, \"erase_sectors\": %llu, "
+		       "\"cache_hits\": %llu, \"cache_misses\": %llu",
+		       first ? "" : ",\n", blk->cdev.name, BLOCKSIZE(blk),
+		       stats->read_sectors, stats->write_sectors,
+		       stats->erase_sectors, stats->cache_hits,
+		       stats->cache_misses);
+		blkstats_print_iostat_json("read", &stats->read);
+		blkstats_print_iostat_json("write", &stats->write);
+		printf(" }");
+
+		first = false;
+	}
+
+#ifdef CONFIG_MTD_STATS
+	{
+		struct mtd_info *mtd;
+
+		class_for_each_container_of_device(&mtd_class, mtd, dev) {
+			if (name && strcmp(name, mtd->cdev.name))
+				continue;
+
+			printf("%s  { \"name\": \"%s\", \"type\": \"mtd\"",
+			       first ? "" : ",\n", mtd->cdev.name);
+			blkstats_print_iostat_json("read", &mtd->read_stats);
+			blkstats_print_iostat_json("write", &mtd->write_stats);
+			blkstats_print_iostat_json("erase", &mtd->erase_stats);
+			printf(" }");
+
+			first = false;
+		}
+	}
+#endif
+
+	printf("\n] }\n");
+}
 
 static int do_blkstats(int argc, char *argv[])
 {
 	struct block_device *blk;
 	const char *name;
-	bool first = false;
+	bool first = true, json = false;
 	int opt;
 
-	while ((opt = getopt(argc, argv, "l")) > 0) {
+	while ((opt = getopt(argc, argv, "lj")) > 0) {
 		switch (opt) {
 		case 'l':
 			for_each_block_device(blk) {
 				printf("%s\n", blk->cdev.name);
 			}
+			return 0;
+		case 'j':
+			json = true;
+			break;
 		default:
 			return COMMAND_ERROR_USAGE;
 		}
@@ -29,6 +100,11 @@ static int do_blkstats(int argc, char *argv[])
 
 	name = argv[0];
 
+	if (json) {
+		blkstats_print_json(name);
+		return 0;
+	}
+
 	for_each_block_device(blk) {
 		struct block_device_stats *stats;
 
@@ -36,15 +112,16 @@ static int do_blkstats(int argc, char *argv[])
 			continue;
 
 		if (first) {
-			printf("%-16s %10s %10s %10s\n",
-			       "Device", "Read", "Write", "Erase");
-			first = true;
+			printf("%-16s %10s %10s %10s %10s %10s\n",
+			       "Device", "Read", "Write", "Erase", "Hits", "Misses");
+			first = false;
 		}
 
 		stats = &blk->stats;
 
-		printf("%-16s %10llu %10llu %10llu\n", blk->cdev.name,
-		       stats->read_sectors, stats->write_sectors, stats->erase_sectors);
+		printf("%-16s %10llu %10llu %10llu %10llu %10llu\n", blk->cdev.name,
+		       stats->read_sectors, stats->write_sectors, stats->erase_sectors,
+		       stats->cache_hits, stats->cache_misses);
 	}
 
 	return 0;
@@ -52,15 +129,20 @@ static int do_blkstats(int argc, char *argv[])
 
 BAREBOX_CMD_HELP_START(blkstats)
 BAREBOX_CMD_HELP_TEXT("Display a block device's number of read, written and erased sectors")
+BAREBOX_CMD_HELP_TEXT("and the number of block cache hits and misses. The JSON output adds")
+BAREBOX_CMD_HELP_TEXT("MTD devices, request counts and log2 latency histograms in us.")
+BAREBOX_CMD_HELP_TEXT("These are also available as parameters of the DEVICE.stats devices")
+BAREBOX_CMD_HELP_TEXT("and of the MTD devices.")
 BAREBOX_CMD_HELP_TEXT("")
 BAREBOX_CMD_HELP_TEXT("Options:")
 BAREBOX_CMD_HELP_OPT("-l",  "list all currently registered block devices")
+BAREBOX_CMD_HELP_OPT("-j",  "JSON output")
 BAREBOX_CMD_HELP_END
 
 BAREBOX_CMD_START(blkstats)
 	.cmd		= do_blkstats,
 	BAREBOX_CMD_DESC("display block layer statistics")
-	BAREBOX_CMD_OPTS("[-l] [DEVICE]")
+	BAREBOX_CMD_OPTS("[-lj] [DEVICE]")
 	BAREBOX_CMD_GROUP(CMD_GRP_INFO)
 	BAREBOX_CMD_HELP(cmd_blkstats_help)
 BAREBOX_CMD_END
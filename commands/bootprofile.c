@@ -0,0 +1,325 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <common.h>
+#include <command.h>
+#include <getopt.h>
+#include <malloc.h>
+#include <fcntl.h>
+#include <fs.h>
+#include <qsort.h>
+#include <kallsyms.h>
+#include <bootprofile.h>
+
+static int bootprofile_cmp(const void *a, const void *b)
+{
+	const struct bootprofile_entry *ea = *(const struct bootprofile_entry **)a;
+	const struct bootprofile_entry *eb = *(const struct bootprofile_entry **)b;
+
+	if (ea->duration == eb->duration)
+		return 0;
+
+	return ea->duration < eb->duration ? 1 : -1;
+}
+
+static int bootprofile_type_parse(const char *str)
+{
+	int type;
+
+	for (type = 0; type < BOOTPROFILE_TYPE_MAX; type++)
+		if (!strcmp(str, bootprofile_type_name(type)))
+			return type;
+
+	return -EINVAL;
+}
+
+/* parse a comma separated list of event types into a mask */
+static int bootprofile_mask_parse(const char *str, unsigned int *mask)
+{
+	char *types, *p, *type;
+	int ret = 0;
+
+	if (!strcmp(str, "all")) {
+		*mask = BIT(BOOTPROFILE_TYPE_MAX) - 1;
+		return 0;
+	}
+
+	p = types = xstrdup(str);
+	*mask = 0;
+
+	while ((type = strsep(&p, ","))) {
+		ret = bootprofile_type_parse(type);
+		if (ret < 0) {
+			printf("unknown event type '%s'\n", type);
+			break;
+		}
+		*mask |= BIT(ret);
+		ret = 0;
+	}
+
+	free(types);
+
+	return ret;
+}
+
+/* every character may need a \u00XX escape */
+#define BOOTPROFILE_JSON_NAME_LEN	(KSYM_NAME_LEN * 6)
+
+/*
+ * The name of an event escaped for use in a JSON string. File events are
+ * named after arbitrary paths.
+ */
+static void bootprofile_entry_json_name(const struct bootprofile_entry *e,
+					char *buf, size_t size)
+{
+	char name[KSYM_NAME_LEN];
+	size_t len = 0;
+	const char *s;
+
+	bootprofile_entry_name(e, name, sizeof(name));
+
+	for (s = name; *s && len + 7 <= size; s++) {
+		unsigned char c = *s;
+
+		if (c == '"' || c == '\\') {
+			buf[len++] = '\\';
+			buf[len++] = c;
+		} else if (c < 0x20) {
+			len += sprintf(buf + len, "\\u%04x", c);
+		} else {
+			buf[len++] = c;
+		}
+	}
+
+	buf[len] = '\0';
+}
+
+static int bootprofile_write_trace_event(int fd, const struct bootprofile_entry *e)
+{
+	char name[BOOTPROFILE_JSON_NAME_LEN];
+	u32 start_rem, dur_rem;
+	u64 start, dur;
+
+	bootprofile_entry_json_name(e, name, sizeof(name));
+
+	start = div_u64_rem(e->start, NSEC_PER_USEC, &start_rem);
+	dur = div_u64_rem(e->duration, NSEC_PER_USEC, &dur_rem);
+
+	if (e->flags & BOOTPROFILE_F_INSTANT)
+		return dprintf(fd, ",\n{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"%s\","
+			       "\"name\":\"%s\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":1,"
+			       "\"args\":{\"ret\":%d}}",
+			       bootprofile_type_name(e->type), name,
+			       start, start_rem, e->ret);
+
+	return dprintf(fd, ",\n{\"ph\":\"X\",\"cat\":\"%s\",\"name\":\"%s\","
+		       "\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":1,\"tid\":1,"
+		       "\"args\":{\"ret\":%d}}",
+		       bootprofile_type_name(e->type), name,
+		       start, start_rem, dur, dur_rem, e->ret);
+}
+
+/*
+ * Write the events in the Trace Event Format understood by Perfetto and
+ * chrome://tracing. Nesting is derived from the timestamps, so all events
+ * go to a single track.
+ */
+static int bootprofile_write_trace(const char *filename, int type)
+{
+	const struct bootprofile_entry *e;
+	unsigned int i, num, mask;
+	int fd, ret;
+
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC);
+	if (fd < 0) {
+		printf("could not open %s: %m\n", filename);
+		return fd;
+	}
+
+	/* writing the trace must not overwrite the events being written */
+	mask = bootprofile_set_mask(0);
+
+	ret = dprintf(fd, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+		      "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,"
+		      "\"args\":{\"name\":\"barebox\"}}");
+
+	num = bootprofile_num_entries(NULL);
+
+	for (i = 0; i < num && ret >= 0; i++) {
+		e = bootprofile_get_entry(i);
+		if (type >= 0 && e->type != type)
+			continue;
+
+		ret = bootprofile_write_trace_event(fd, e);
+	}
+
+	if (ret >= 0)
+		ret = dprintf(fd, "\n]}\n");
+
+	bootprofile_set_mask(mask);
+
+	if (close(fd) && ret >= 0)
+		ret = -errno;
+
+	if (ret < 0) {
+		printf("could not write %s: %pe\n", filename, ERR_PTR(ret));
+		return ret;
+	}
+
+	return 0;
+}
+
+static void bootprofile_print_json(int type)
+{
+	const struct bootprofile_entry *e;
+	unsigned int i, num, dropped;
+	char name[BOOTPROFILE_JSON_NAME_LEN];
+	bool first = true;
+
+	num = bootprofile_num_entries(&dropped);
+
+	printf("{ \"dropped\": %u, \"events\": [\n", dropped);
+
+	for (i = 0; i < num; i++) {
+		e = bootprofile_get_entry(i);
+		if (type >= 0 && e->type != type)
+			continue;
+
+		bootprofile_entry_json_name(e, name, sizeof(name));
+
+		printf("%s  { \"type\": \"%s\", \"name\": \"%s\", "
+		       "\"start_ns\": %llu, \"duration_ns\": %llu, "
+		       "\"depth\": %u, \"ret\": %d }",
+		       first ? "" : ",\n", bootprofile_type_name(e->type), name,
+		       e->start, e->duration, e->depth, e->ret);
+
+		first = false;
+	}
+
+	printf("\n] }\n");
+}
+
+static void bootprofile_print_top(int type, unsigned int max)
+{
+	const struct bootprofile_entry **sorted, *e;
+	unsigned int i, num, n = 0, dropped;
+	char name[KSYM_NAME_LEN];
+	u64 total = 0;
+
+	num = bootprofile_num_entries(&dropped);
+	sorted = xmalloc(num * sizeof(*sorted));
+
+	for (i = 0; i < num; i++) {
+		e = bootprofile_get_entry(i);
+		if (type >= 0 && e->type != type)
+			continue;
+
+		sorted[n++] = e;
+		if (e->type == BOOTPROFILE_INITCALL)
+			total += e->duration;
+	}
+
+	qsort(sorted, n, sizeof(*sorted), bootprofile_cmp);
+
+	printf("%10s %10s %-8s %s\n", "start/us", "time/us", "type", "name");
+
+	for (i = 0; i < n && i < max; i++) {
+		e = sorted[i];
+
+		bootprofile_entry_name(e, name, sizeof(name));
+
+		printf("%10llu %10llu %-8s %*s%s", div_u64(e->start, NSEC_PER_USEC),
+		       div_u64(e->duration, NSEC_PER_USEC),
+		       bootprofile_type_name(e->type), e->depth * 2, "", name);
+		if (e->ret < 0)
+			printf(" (%pe)", ERR_PTR(e->ret));
+		printf("\n");
+	}
+
+	if (total)
+		printf("initcalls took %llu us in total\n",
+		       div_u64(total, NSEC_PER_USEC));
+	if (dropped)
+		printf("%u older events were dropped\n", dropped);
+
+	free(sorted);
+}
+
+static int do_bootprofile(int argc, char *argv[])
+{
+	unsigned int max = UINT_MAX, mask;
+	const char *trace = NULL;
+	bool json = false;
+	int opt, type = -1;
+
+	while ((opt = getopt(argc, argv, "n:t:jco:e:d:")) > 0) {
+		switch (opt) {
+		case 'n':
+			max = simple_strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			type = bootprofile_type_parse(optarg);
+			if (type < 0) {
+				printf("unknown event type '%s'\n", optarg);
+				return COMMAND_ERROR_USAGE;
+			}
+			break;
+		case 'j':
+			json = true;
+			break;
+		case 'c':
+			bootprofile_clear();
+			return 0;
+		case 'o':
+			trace = optarg;
+			break;
+		case 'e':
+			if (bootprofile_mask_parse(optarg, &mask))
+				return COMMAND_ERROR_USAGE;
+			bootprofile_set_mask(bootprofile_get_mask() | mask);
+			return 0;
+		case 'd':
+			if (bootprofile_mask_parse(optarg, &mask))
+				return COMMAND_ERROR_USAGE;
+			bootprofile_set_mask(bootprofile_get_mask() & ~mask);
+			return 0;
+		default:
+			return COMMAND_ERROR_USAGE;
+		}
+	}
+
+	if (trace)
+		return bootprofile_write_trace(trace, type) ? COMMAND_ERROR : 0;
+
+	if (json)
+		bootprofile_print_json(type);
+	else
+		bootprofile_print_top(type, max);
+
+	return 0;
+}
+
+BAREBOX_CMD_HELP_START(bootprofile)
+BAREBOX_CMD_HELP_TEXT("Show the boot events recorded by the boot time profiler,")
+BAREBOX_CMD_HELP_TEXT("longest first. Durations include nested events, e.g. an")
+BAREBOX_CMD_HELP_TEXT("initcall's time includes the driver probes it triggered.")
+BAREBOX_CMD_HELP_TEXT("")
+BAREBOX_CMD_HELP_TEXT("Options:")
+BAREBOX_CMD_HELP_OPT ("-n NUM",  "show the NUM longest events only")
+BAREBOX_CMD_HELP_OPT ("-t TYPE", "only show events of TYPE")
+BAREBOX_CMD_HELP_OPT ("-j",      "JSON output in recording order")
+BAREBOX_CMD_HELP_OPT ("-o FILE", "write a trace for Perfetto or chrome://tracing to FILE")
+BAREBOX_CMD_HELP_OPT ("-c",      "clear the recorded events")
+BAREBOX_CMD_HELP_OPT ("-e TYPES", "start recording events of TYPES (comma separated or 'all')")
+BAREBOX_CMD_HELP_OPT ("-d TYPES", "stop recording events of TYPES")
+BAREBOX_CMD_HELP_TEXT("")
+BAREBOX_CMD_HELP_TEXT("Event types: initcall, probe, deferred, bootm, block-read,")
+BAREBOX_CMD_HELP_TEXT("block-write, file, digest, decompress, net-rx, net-tx")
+BAREBOX_CMD_HELP_END
+
+BAREBOX_CMD_START(bootprofile)
+	.cmd		= do_bootprofile,
+	BAREBOX_CMD_DESC("show boot time profile")
+	BAREBOX_CMD_OPTS("[-n NUM] [-t TYPE] [-o FILE] [-e|-d TYPES] [-jc]")
+	BAREBOX_CMD_GROUP(CMD_GRP_INFO)
+	BAREBOX_CMD_HELP(cmd_bootprofile_help)
+BAREBOX_CMD_END
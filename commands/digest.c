@@ -12,6 +12,9 @@
 #include <digest.h>
 #include <getopt.h>
 #include <libfile.h>
+#include <clock.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
 
 #include "internal.h"
 
@@ -74,6 +77,38 @@ int __do_digest(struct digest *d, unsigned char *sig,
 	return ret;
 }
 
+static int digest_benchmark(struct digest *d, loff_t size)
+{
+	unsigned char *hash, *buf;
+	u64 start, ns;
+	int ret;
+
+	buf = malloc(size);
+	hash = malloc(digest_length(d));
+	if (!buf || !hash) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	memset(buf, 0x5a, size);
+
+	start = get_time_ns();
+	ret = digest_digest(d, buf, size, hash);
+	ns = get_time_ns() - start;
+	if (ret)
+		goto out;
+
+	printf("%s (%s): %llu bytes in %llu us, %llu KiB/s\n",
+	       digest_name(d), digest_driver_name(d), size, div_u64(ns, 1000),
+	       div64_u64(size * (NSEC_PER_SEC / SZ_1K), max_t(u64, ns, 1)));
+out:
+	free(hash);
+	free(buf);
+	digest_free(d);
+
+	return ret ? COMMAND_ERROR : COMMAND_SUCCESS;
+}
+
 static void __maybe_unused prints_algo_help(void)
 {
 	puts("\navailable algo:\n");
@@ -92,6 +127,7 @@ static int do_digest(int argc, char *argv[])
 	char *keyfile = NULL;
 	size_t keylen = 0;
 	size_t digestlen = 0;
+	loff_t benchsize = 0;
 	char *algo = NULL;
 	int opt;
 	int ret = COMMAND_ERROR;
@@ -99,8 +135,11 @@ static int do_digest(int argc, char *argv[])
 	if (argc < 2)
 		return COMMAND_ERROR_USAGE;
 
-	while((opt = getopt(argc, argv, "a:k:K:s:S:")) > 0) {
+	while((opt = getopt(argc, argv, "a:b:k:K:s:S:")) > 0) {
 		switch(opt) {
+		case 'b':
+			benchsize = strtoull_suffix(optarg, NULL, 0);
+			break;
 		case 'k':
 			key = optarg;
 			keylen = strlen(key);
@@ -133,6 +172,9 @@ static int do_digest(int argc, char *argv[])
 	argc -= optind;
 	argv += optind;
 
+	if (benchsize)
+		return digest_benchmark(d, benchsize);
+
 	if (keyfile) {
 		tmp_key = key = read_file(keyfile, &keylen);
 		if (!key) {
@@ -191,6 +233,7 @@ BAREBOX_CMD_HELP_START(digest)
 BAREBOX_CMD_HELP_TEXT("Calculate a digest over a FILE or a memory area.")
 BAREBOX_CMD_HELP_TEXT("Options:")
 BAREBOX_CMD_HELP_OPT ("-a <algo>\t",  "hash or signature algorithm name/driver to use")
+BAREBOX_CMD_HELP_OPT ("-b <size>\t",  "measure throughput hashing <size> bytes of RAM")
 BAREBOX_CMD_HELP_OPT ("-k <key>\t",   "use supplied <key> (ASCII or hex) for MAC")
 BAREBOX_CMD_HELP_OPT ("-K <file>\t",  "use key from <file> (binary) for MAC")
 BAREBOX_CMD_HELP_OPT ("-s <hex>\t",   "verify data against supplied <hex> (hash, MAC or signature)")
@@ -200,7 +243,7 @@ BAREBOX_CMD_HELP_END
 BAREBOX_CMD_START(digest)
 	.cmd		= do_digest,
 	BAREBOX_CMD_DESC("calculate digest")
-	BAREBOX_CMD_OPTS("-a <algo> [-k <key> | -K <file>] [-s <sig> | -S <file>] FILE|AREA")
+	BAREBOX_CMD_OPTS("-a <algo> [-k <key> | -K <file>] [-s <sig> | -S <file>] FILE|AREA | -b <size>")
 	BAREBOX_CMD_GROUP(CMD_GRP_FILE)
 	BAREBOX_CMD_HELP(cmd_digest_help)
 	BAREBOX_CMD_USAGE(prints_algo_help)
@@ -56,6 +56,7 @@ static struct console_device *cdev; /* The console device we are using */
 
 static void sendchar(char c)
 {
+	console_tx_flush(cdev);
 	cdev->putc(cdev, c);
 }
 
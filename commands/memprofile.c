@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <common.h>
+#include <command.h>
+#include <getopt.h>
+#include <malloc.h>
+
+static int do_memprofile(int argc, char *argv[])
+{
+	unsigned int num = 20;
+	bool by_allocs = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:ar")) > 0) {
+		switch (opt) {
+		case 'n':
+			num = simple_strtoul(optarg, NULL, 0);
+			break;
+		case 'a':
+			by_allocs = true;
+			break;
+		case 'r':
+			malloc_profile_reset();
+			return 0;
+		default:
+			return COMMAND_ERROR_USAGE;
+		}
+	}
+
+	malloc_profile_print(num, by_allocs);
+
+	return 0;
+}
+
+BAREBOX_CMD_HELP_START(memprofile)
+BAREBOX_CMD_HELP_TEXT("Show the allocation sites holding the most heap memory and")
+BAREBOX_CMD_HELP_TEXT("the peak heap usage of each boot phase, as recorded by the")
+BAREBOX_CMD_HELP_TEXT("allocation profiler. Sizes are the requested sizes without")
+BAREBOX_CMD_HELP_TEXT("allocator overhead.")
+BAREBOX_CMD_HELP_TEXT("")
+BAREBOX_CMD_HELP_TEXT("Options:")
+BAREBOX_CMD_HELP_OPT ("-n NUM", "show NUM sites (default 20, 0 for all)")
+BAREBOX_CMD_HELP_OPT ("-a",     "sort by number of allocations instead of bytes in use")
+BAREBOX_CMD_HELP_OPT ("-r",     "reset allocation counts and peaks")
+BAREBOX_CMD_HELP_END
+
+BAREBOX_CMD_START(memprofile)
+	.cmd		= do_memprofile,
+	BAREBOX_CMD_DESC("show heap allocation profile")
+	BAREBOX_CMD_OPTS("[-n NUM] [-ar]")
+	BAREBOX_CMD_GROUP(CMD_GRP_INFO)
+	BAREBOX_CMD_HELP(cmd_memprofile_help)
+BAREBOX_CMD_END
@@ -13,9 +13,8 @@
 #include <mmu.h>
 
 static int do_test_one_area(struct mem_test_resource *r, int bus_only,
-		maptype_t cache_flag)
+		maptype_t cache_flag, unsigned flags)
 {
-	unsigned flags = MEMTEST_VERBOSE;
 	int ret;
 
 	printf("Testing memory space: %pa -> %pa:\n",
@@ -23,6 +22,10 @@ static int do_test_one_area(struct mem_test_resource *r, int bus_only,
 
 	remap_range((void *)r->r->start, resource_size(r->r), cache_flag);
 
+	/* offload CPUs only ever see the region mapped cached */
+	if (maptype_is_compatible(cache_flag, MAP_CACHED))
+		flags |= MEMTEST_OFFLOAD;
+
 	ret = mem_test_bus_integrity(r->r->start, r->r->end, flags);
 	if (ret < 0)
 		return ret;
@@ -39,13 +42,13 @@ static int do_test_one_area(struct mem_test_resource *r, int bus_only,
 }
 
 static int do_memtest_thorough(struct list_head *memtest_regions,
-		int bus_only, maptype_t cache_flag)
+		int bus_only, maptype_t cache_flag, unsigned flags)
 {
 	struct mem_test_resource *r;
 	int ret;
 
 	list_for_each_entry(r, memtest_regions, list) {
-		ret = do_test_one_area(r, bus_only, cache_flag);
+		ret = do_test_one_area(r, bus_only, cache_flag, flags);
 		if (ret)
 			return ret;
 	}
@@ -54,7 +57,7 @@ static int do_memtest_thorough(struct list_head *memtest_regions,
 }
 
 static int do_memtest_biggest(struct list_head *memtest_regions,
-		int bus_only, maptype_t cache_flag)
+		int bus_only, maptype_t cache_flag, unsigned flags)
 {
 	struct mem_test_resource *r;
 
@@ -62,7 +65,7 @@ static int do_memtest_biggest(struct list_head *memtest_regions,
 	if (!r)
 		return -EINVAL;
 
-	return do_test_one_area(r, bus_only, cache_flag);
+	return do_test_one_area(r, bus_only, cache_flag, flags);
 }
 
 static int do_memtest(int argc, char *argv[])
@@ -70,12 +73,13 @@ static int do_memtest(int argc, char *argv[])
 	int bus_only = 0, ret, opt;
 	uint32_t i, max_i = 1;
 	struct list_head memtest_used_regions;
-	int (*memtest)(struct list_head *, int, maptype_t);
+	int (*memtest)(struct list_head *, int, maptype_t, unsigned);
+	unsigned flags = MEMTEST_VERBOSE;
 	int cached = 0, uncached = 0;
 
 	memtest = do_memtest_biggest;
 
-	while ((opt = getopt(argc, argv, "i:btcu")) > 0) {
+	while ((opt = getopt(argc, argv, "i:btcue")) > 0) {
 		switch (opt) {
 		case 'i':
 			max_i = simple_strtoul(optarg, NULL, 0);
@@ -92,6 +96,9 @@ static int do_memtest(int argc, char *argv[])
 		case 'u':
 			uncached = 1;
 			break;
+		case 'e':
+			flags |= MEMTEST_EXTENDED;
+			break;
 		default:
 			return COMMAND_ERROR_USAGE;
 		}
@@ -121,7 +128,7 @@ static int do_memtest(int argc, char *argv[])
 		if (cached) {
 			printf("Do memtest with caching enabled.\n");
 			ret = memtest(&memtest_used_regions,
-					bus_only, MAP_CACHED);
+					bus_only, MAP_CACHED, flags);
 			if (ret < 0)
 				goto out;
 		}
@@ -129,14 +136,14 @@ static int do_memtest(int argc, char *argv[])
 		if (uncached) {
 			printf("Do memtest with caching disabled.\n");
 			ret = memtest(&memtest_used_regions,
-					bus_only, MAP_UNCACHED);
+					bus_only, MAP_UNCACHED, flags);
 			if (ret < 0)
 				goto out;
 		}
 
 		if (!cached && !uncached) {
 			ret = memtest(&memtest_used_regions,
-					bus_only, MAP_DEFAULT);
+					bus_only, MAP_DEFAULT, flags);
 			if (ret < 0)
 				goto out;
 		}
@@ -169,12 +176,13 @@ BAREBOX_CMD_HELP_OPT("-b", "perform only a test on bus lines")
 BAREBOX_CMD_HELP_OPT("-c", "cached. Test using cached memory")
 BAREBOX_CMD_HELP_OPT("-u", "uncached. Test using uncached memory")
 BAREBOX_CMD_HELP_OPT("-t", "thorough. test all free areas. If unset, only test biggest free area")
+BAREBOX_CMD_HELP_OPT("-e", "extended. Also test checkerboard and pseudo random patterns")
 BAREBOX_CMD_HELP_END
 
 BAREBOX_CMD_START(memtest)
 	.cmd		= do_memtest,
 	BAREBOX_CMD_DESC("extensive memory test")
-	BAREBOX_CMD_OPTS("[-ibcut]")
+	BAREBOX_CMD_OPTS("[-ibcute]")
 	BAREBOX_CMD_GROUP(CMD_GRP_MEM)
 	BAREBOX_CMD_HELP(cmd_memtest_help)
 BAREBOX_CMD_END
@@ -17,6 +17,7 @@ static int do_splash(int argc, char *argv[])
 	int opt;
 	char *fbdev = "/dev/fb0";
 	char *image_file;
+	char *cache = NULL;
 	u32 bg_color = 0x00000000;
 	bool do_bg = false;
 	void *buf;
@@ -28,7 +29,7 @@ static int do_splash(int argc, char *argv[])
 	s.width = -1;
 	s.height = -1;
 
-	while((opt = getopt(argc, argv, "f:x:y:ob:")) > 0) {
+	while((opt = getopt(argc, argv, "f:x:y:ob:c:")) > 0) {
 		switch(opt) {
 		case 'f':
 			fbdev = optarg;
@@ -43,6 +44,9 @@ static int do_splash(int argc, char *argv[])
 		case 'y':
 			s.y = simple_strtoul(optarg, NULL, 0);
 			break;
+		case 'c':
+			cache = optarg;
+			break;
 		default:
 			return COMMAND_ERROR_USAGE;
 		}
@@ -54,6 +58,14 @@ static int do_splash(int argc, char *argv[])
 	}
 	image_file = argv[optind];
 
+	/*
+	 * Alpha blended images would be cached together with whatever the
+	 * framebuffer happened to contain, so always draw on a defined
+	 * background when caching.
+	 */
+	if (cache)
+		do_bg = true;
+
 	sc = fb_open(fbdev);
 	if (IS_ERR(sc)) {
 		printf("fb_open: %pe\n", sc);
@@ -70,7 +82,11 @@ static int do_splash(int argc, char *argv[])
 		}
 	}
 
-	ret = image_renderer_file(sc, &s, image_file);
+	if (cache)
+		ret = image_renderer_file_cached(sc, &s, image_file, cache,
+						 bg_color);
+	else
+		ret = image_renderer_file(sc, &s, image_file);
 	if (ret > 0)
 		ret = 0;
 
@@ -91,12 +107,13 @@ BAREBOX_CMD_HELP_OPT ("-f FB\t",    "framebuffer device (default /dev/fb0)")
 BAREBOX_CMD_HELP_OPT ("-x XOFFS", "x offset (default center)")
 BAREBOX_CMD_HELP_OPT ("-y YOFFS", "y offset (default center)")
 BAREBOX_CMD_HELP_OPT ("-b COLOR", "background color in 0xttrrggbb")
+BAREBOX_CMD_HELP_OPT ("-c CACHE", "cache the rendered image in file or partition CACHE, implies -b")
 BAREBOX_CMD_HELP_END
 
 BAREBOX_CMD_START(splash)
 	.cmd		= do_splash,
 	BAREBOX_CMD_DESC("display a BMP or PNG splash image")
-	BAREBOX_CMD_OPTS("[-fxyno] FILE")
+	BAREBOX_CMD_OPTS("[-fxyobc] FILE")
 	BAREBOX_CMD_GROUP(CMD_GRP_CONSOLE)
 	BAREBOX_CMD_HELP(cmd_splash_help)
 BAREBOX_CMD_END
@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * udcbench - measure USB gadget throughput on the dummy UDC
+ */
+
+#include <common.h>
+#include <command.h>
+#include <getopt.h>
+#include <clock.h>
+#include <malloc.h>
+#include <slice.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/storage.h>
+#include <linux/usb/dummy_udc.h>
+#include <asm/unaligned.h>
+
+struct udcbench {
+	struct dummy_udc *udc;
+	u8 ep_in;
+	u8 ep_out;
+	void *buf;
+	size_t chunk;
+	u32 tag;
+};
+
+static int udcbench_control(struct udcbench *b, u8 type, u8 request,
+			    u16 value, void *data, u16 len)
+{
+	struct usb_ctrlrequest ctrl = {
+		.bRequestType = type,
+		.bRequest = request,
+		.wValue = cpu_to_le16(value),
+		.wLength = cpu_to_le16(len),
+	};
+
+	return dummy_udc_control(b->udc, &ctrl, data);
+}
+
+/* find the bulk endpoints of the first interface of class @class */
+static int udcbench_configure(struct udcbench *b, u8 class)
+{
+	struct usb_config_descriptor cfg;
+	u8 *desc, *p, *end;
+	bool found = false;
+	int ret;
+
+	ret = udcbench_control(b, USB_DIR_IN, USB_REQ_GET_DESCRIPTOR,
+			       USB_DT_CONFIG << 8, &cfg, sizeof(cfg));
+	if (ret < 0)
+		return ret;
+
+	desc = xzalloc(le16_to_cpu(cfg.wTotalLength));
+
+	ret = udcbench_control(b, USB_DIR_IN, USB_REQ_GET_DESCRIPTOR,
+			       USB_DT_CONFIG << 8, desc,
+			       le16_to_cpu(cfg.wTotalLength));
+	if (ret < 0)
+		goto out;
+
+	b->ep_in = b->ep_out = 0;
+
+	for (p = desc, end = desc + ret; p + 2 <= end && p[0]; p += p[0]) {
+		if (p[1] == USB_DT_INTERFACE) {
+			struct usb_interface_descriptor *intf = (void *)p;
+
+			if (b->ep_in && b->ep_out)
+				break;
+			found = intf->bInterfaceClass == class;
+		} else if (p[1] == USB_DT_ENDPOINT && found) {
+			struct usb_endpoint_descriptor *ep = (void *)p;
+
+			if (!usb_endpoint_xfer_bulk(ep))
+				continue;
+			if (usb_endpoint_dir_in(ep))
+				b->ep_in = ep->bEndpointAddress;
+			else
+				b->ep_out = ep->bEndpointAddress;
+		}
+	}
+
+	if (!b->ep_in || !b->ep_out) {
+		printf("No interface of class 0x%02x found\n", class);
+		ret = -ENODEV;
+		goto out;
+	}
+
+	ret = udcbench_control(b, USB_DIR_OUT, USB_REQ_SET_CONFIGURATION,
+			       cfg.bConfigurationValue, NULL, 0);
+out:
+	free(desc);
+
+	return ret < 0 ? ret : 0;
+}
+
+static void udcbench_report(struct udcbench *b, const char *name,
+			    u64 bytes, u64 start)
+{
+	u64 ns = get_time_ns() - start;
+	u8 eps[] = { b->ep_out, b->ep_in };
+	int i;
+
+	printf("%s: %llu bytes in %llu ms, %llu KiB/s\n", name, bytes,
+	       div_u64(ns, MSECOND), div64_u64(bytes * SECOND, ns ?: 1) >> 10);
+
+	for (i = 0; i < ARRAY_SIZE(eps); i++) {
+		struct dummy_udc_ep_stats s;
+
+		if (dummy_udc_ep_stats(b->udc, eps[i], &s))
+			continue;
+
+		printf("  ep 0x%02x: %llu requests, %llu bytes/request, "
+		       "max %u queued, host waited %u times\n",
+		       eps[i], s.requests,
+		       s.requests ? div64_u64(s.bytes, s.requests) : 0,
+		       s.max_queued, s.starved);
+	}
+}
+
+static int udcbench_fastboot_response(struct udcbench *b, char *resp)
+{
+	int ret;
+
+	do {
+		ret = dummy_udc_bulk(b->udc, b->ep_in, resp, 64);
+		if (ret < 0)
+			return ret;
+		resp[ret] = '\0';
+	} while (!strncmp(resp, "INFO", 4) || !strncmp(resp, "TEXT", 4));
+
+	return 0;
+}
+
+static int udcbench_fastboot(struct udcbench *b, size_t size)
+{
+	char cmd[65];
+	size_t done;
+	u64 start;
+	int ret;
+
+	ret = udcbench_configure(b, USB_CLASS_VENDOR_SPEC);
+	if (ret)
+		return ret;
+
+	sprintf(cmd, "download:%08zx", size);
+	ret = dummy_udc_bulk(b->udc, b->ep_out, cmd, strlen(cmd));
+	if (ret < 0)
+		return ret;
+
+	ret = udcbench_fastboot_response(b, cmd);
+	if (ret)
+		return ret;
+	if (strncmp(cmd, "DATA", 4)) {
+		printf("download failed: %s\n", cmd);
+		return -EIO;
+	}
+
+	dummy_udc_reset_stats(b->udc);
+	start = get_time_ns();
+
+	for (done = 0; done < size; done += ret) {
+		ret = dummy_udc_bulk(b->udc, b->ep_out, b->buf,
+				     min(b->chunk, size - done));
+		if (ret <= 0)
+			return ret ?: -EIO;
+	}
+
+	ret = udcbench_fastboot_response(b, cmd);
+	if (ret)
+		return ret;
+	if (strncmp(cmd, "OKAY", 4)) {
+		printf("download failed: %s\n", cmd);
+		return -EIO;
+	}
+
+	udcbench_report(b, "fastboot download", size, start);
+
+	return 0;
+}
+
+static int udcbench_scsi(struct udcbench *b, const u8 *cdb, int cdblen,
+			 void *data, size_t len, bool in)
+{
+	struct bulk_cb_wrap cbw = {
+		.Signature = cpu_to_le32(US_BULK_CB_SIGN),
+		.Tag = ++b->tag,
+		.DataTransferLength = cpu_to_le32(len),
+		.Flags = in ? US_BULK_FLAG_IN : US_BULK_FLAG_OUT,
+		.Length = cdblen,
+	};
+	struct bulk_cs_wrap csw;
+	int ret;
+
+	memcpy(cbw.CDB, cdb, cdblen);
+
+	ret = dummy_udc_bulk(b->udc, b->ep_out, &cbw, US_BULK_CB_WRAP_LEN);
+	if (ret < 0)
+		return ret;
+
+	if (len) {
+		ret = dummy_udc_bulk(b->udc, in ? b->ep_in : b->ep_out,
+				     data, len);
+		if (ret < 0)
+			return ret;
+	}
+
+	ret = dummy_udc_bulk(b->udc, b->ep_in, &csw, US_BULK_CS_WRAP_LEN);
+	if (ret < 0)
+		return ret;
+
+	if (le32_to_cpu(csw.Signature) != US_BULK_CS_SIGN ||
+	    csw.Tag != cbw.Tag || csw.Status != US_BULK_STAT_OK)
+		return -EIO;
+
+	return 0;
+}
+
+static int udcbench_ums(struct udcbench *b, size_t size, bool write)
+{
+	u8 cdb[10] = {};
+	u32 blksz, nblks, lba, n;
+	size_t done;
+	u8 cap[8];
+	u64 start;
+	int ret;
+
+	ret = udcbench_configure(b, USB_CLASS_MASS_STORAGE);
+	if (ret)
+		return ret;
+
+	cdb[0] = 0x25;	/* READ CAPACITY(10) */
+	ret = udcbench_scsi(b, cdb, sizeof(cdb), cap, sizeof(cap), true);
+	if (ret)
+		return ret;
+
+	nblks = get_unaligned_be32(cap) + 1;
+	blksz = get_unaligned_be32(cap + 4);
+	if (!blksz || b->chunk < blksz)
+		return -EINVAL;
+
+	size = min_t(u64, size, (u64)nblks * blksz);
+
+	dummy_udc_reset_stats(b->udc);
+	start = get_time_ns();
+
+	for (done = 0, lba = 0; done + blksz <= size; done += n * blksz, lba += n) {
+		/* the transfer length of READ(10) / WRITE(10) is 16 bit */
+		n = min_t(size_t, min(b->chunk, size - done) / blksz, U16_MAX);
+
+		memset(cdb, 0, sizeof(cdb));
+		cdb[0] = write ? 0x2a : 0x28;	/* WRITE(10) / READ(10) */
+		put_unaligned_be32(lba, cdb + 2);
+		put_unaligned_be16(n, cdb + 7);
+
+		ret = udcbench_scsi(b, cdb, sizeof(cdb), b->buf, n * blksz, !write);
+		if (ret)
+			return ret;
+	}
+
+	udcbench_report(b, write ? "ums write" : "ums read", done, start);
+
+	return 0;
+}
+
+static int do_udcbench(int argc, char *argv[])
+{
+	struct udcbench b = {
+		.chunk = SZ_64K,
+	};
+	size_t size = SZ_16M;
+	const char *test;
+	int opt, ret;
+
+	while ((opt = getopt(argc, argv, "s:c:")) > 0) {
+		switch (opt) {
+		case 's':
+			size = strtoull_suffix(optarg, NULL, 0);
+			break;
+		case 'c':
+			b.chunk = strtoull_suffix(optarg, NULL, 0);
+			break;
+		default:
+			return COMMAND_ERROR_USAGE;
+		}
+	}
+
+	if (optind != argc - 1 || !b.chunk)
+		return COMMAND_ERROR_USAGE;
+
+	test = argv[optind];
+
+	b.udc = dummy_udc_get();
+	if (!b.udc) {
+		printf("No dummy UDC found\n");
+		return COMMAND_ERROR;
+	}
+
+	b.buf = malloc(b.chunk);
+	if (!b.buf)
+		return -ENOMEM;
+	memset(b.buf, 0x5a, b.chunk);
+
+	/* let the gadget's workqueues and bthreads run while we wait */
+	command_slice_release();
+
+	if (!strcmp(test, "fastboot"))
+		ret = udcbench_fastboot(&b, size);
+	else if (!strcmp(test, "ums-read"))
+		ret = udcbench_ums(&b, size, false);
+	else if (!strcmp(test, "ums-write"))
+		ret = udcbench_ums(&b, size, true);
+	else
+		ret = COMMAND_ERROR_USAGE;
+
+	command_slice_acquire();
+
+	free(b.buf);
+
+	if (ret < 0)
+		printf("%s failed: %pe\n", test, ERR_PTR(ret));
+
+	return ret ? COMMAND_ERROR : 0;
+}
+
+BAREBOX_CMD_HELP_START(udcbench)
+BAREBOX_CMD_HELP_TEXT("Measure the throughput of a USB gadget function running on the")
+BAREBOX_CMD_HELP_TEXT("dummy UDC, with barebox acting as USB host as well. The gadget")
+BAREBOX_CMD_HELP_TEXT("must be started with the usbgadget command before.")
+BAREBOX_CMD_HELP_TEXT("")
+BAREBOX_CMD_HELP_TEXT("Tests:")
+BAREBOX_CMD_HELP_OPT ("fastboot",  "fastboot download of SIZE bytes")
+BAREBOX_CMD_HELP_OPT ("ums-read",  "read SIZE bytes from the first mass storage LUN")
+BAREBOX_CMD_HELP_OPT ("ums-write", "write SIZE bytes to the first mass storage LUN")
+BAREBOX_CMD_HELP_TEXT("")
+BAREBOX_CMD_HELP_TEXT("Options:")
+BAREBOX_CMD_HELP_OPT ("-s SIZE",  "bytes to transfer (default 16M)")
+BAREBOX_CMD_HELP_OPT ("-c CHUNK", "host transfer size (default 64k)")
+BAREBOX_CMD_HELP_END
+
+BAREBOX_CMD_START(udcbench)
+	.cmd		= do_udcbench,
+	BAREBOX_CMD_DESC("benchmark USB gadget functions on the dummy UDC")
+	BAREBOX_CMD_OPTS("[-sc] fastboot|ums-read|ums-write")
+	BAREBOX_CMD_GROUP(CMD_GRP_MISC)
+	BAREBOX_CMD_HELP(cmd_udcbench_help)
+BAREBOX_CMD_END
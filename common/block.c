@@ -14,6 +14,7 @@
 #include <range.h>
 #include <bootargs.h>
 #include <file-list.h>
+#include <bootprofile.h>
 
 LIST_HEAD(block_device_list);
 
@@ -33,6 +34,13 @@ static int writebuffer_io_len(struct block_device *blk, struct chunk *chunk)
 	return min_t(blkcnt_t, blk->rdbufsize, blk->num_blocks - chunk->block_start);
 }
 
+/* timestamp for both the block statistics and the boot profiler */
+static inline u64 blk_io_start(void)
+{
+	return IS_ENABLED(CONFIG_BLOCK_STATS) ? iostat_start() :
+						bootprofile_start();
+}
+
 #ifdef CONFIG_BLOCK_STATS
 static void blk_stats_record_read(struct block_device *blk, blkcnt_t count)
 {
@@ -46,22 +54,74 @@ static void blk_stats_record_erase(struct block_device *blk, blkcnt_t count)
 {
 	blk->stats.erase_sectors += count;
 }
+static void blk_stats_record_io(struct block_device *blk, bool write,
+				u64 start, blkcnt_t count, int ret)
+{
+	iostat_account(write ? &blk->stats.write : &blk->stats.read, start,
+		       (u64)count << blk->blockbits, ret);
+}
+static void blk_stats_record_cache(struct block_device *blk, bool hit)
+{
+	if (hit)
+		blk->stats.cache_hits++;
+	else
+		blk->stats.cache_misses++;
+}
+
+static void blk_stats_register(struct block_device *blk)
+{
+	struct block_device_stats *stats = &blk->stats;
+	struct device *dev = &stats->dev;
+
+	/*
+	 * Not a child of blk->dev, which may be unregistered before the
+	 * block device is.
+	 */
+	dev_set_name(dev, "%s.stats", blk->cdev.name);
+	dev->id = DEVICE_ID_SINGLE;
+	if (register_device(dev))
+		return;
+
+	stats->registered = true;
+
+	iostat_add_params(dev, "read", &stats->read);
+	iostat_add_params(dev, "write", &stats->write);
+	dev_add_param_uint64_ro(dev, "cache_hits", &stats->cache_hits, "%llu");
+	dev_add_param_uint64_ro(dev, "cache_misses", &stats->cache_misses, "%llu");
+}
+
+static void blk_stats_unregister(struct block_device *blk)
+{
+	if (blk->stats.registered)
+		unregister_device(&blk->stats.dev);
+	blk->stats.registered = false;
+}
 #else
 static void blk_stats_record_read(struct block_device *blk, blkcnt_t count) { }
 static void blk_stats_record_write(struct block_device *blk, blkcnt_t count) { }
 static void blk_stats_record_erase(struct block_device *blk, blkcnt_t count) { }
+static void blk_stats_record_io(struct block_device *blk, bool write,
+				u64 start, blkcnt_t count, int ret) { }
+static void blk_stats_record_cache(struct block_device *blk, bool hit) { }
+static void blk_stats_register(struct block_device *blk) { }
+static void blk_stats_unregister(struct block_device *blk) { }
 #endif
 
 static int chunk_flush(struct block_device *blk, struct chunk *chunk)
 {
 	size_t len;
+	u64 start;
 	int ret;
 
 	if (!chunk->dirty)
 		return 0;
 
 	len = writebuffer_io_len(blk, chunk);
+	start = blk_io_start();
 	ret = blk->ops->write(blk, chunk->data, chunk->block_start, len);
+	blk_stats_record_io(blk, true, start, len, ret);
+	bootprofile_event(BOOTPROFILE_BLOCK_WRITE, blk->cdev.name, start,
+			  ret < 0 ? ret : len * BLOCKSIZE(blk));
 	if (ret < 0)
 		return ret;
 
@@ -168,6 +228,7 @@ static int block_cache(struct block_device *blk, sector_t block)
 {
 	struct chunk *chunk;
 	size_t len;
+	u64 start;
 	int ret;
 
 	chunk = get_chunk(blk);
@@ -188,7 +249,11 @@ static int block_cache(struct block_device *blk, sector_t block)
 		return 0;
 	}
 
+	start = blk_io_start();
 	ret = blk->ops->read(blk, chunk->data, chunk->block_start, len);
+	blk_stats_record_io(blk, false, start, len, ret);
+	bootprofile_event(BOOTPROFILE_BLOCK_READ, blk->cdev.name, start,
+			  ret ?: len * BLOCKSIZE(blk));
 	if (ret) {
 		list_add_tail(&chunk->list, &blk->idle_blocks);
 		return ret;
@@ -213,6 +278,7 @@ static void *block_get(struct block_device *blk, sector_t block)
 		return ERR_PTR(-ENXIO);
 
 	outdata = block_get_cached(blk, block);
+	blk_stats_record_cache(blk, outdata);
 	if (outdata)
 		return outdata;
 
@@ -493,6 +559,8 @@ int blockdevice_register(struct block_device *blk)
 
 	list_add_tail(&blk->list, &block_device_list);
 
+	blk_stats_register(blk);
+
 	cdev_create_default_automount(&blk->cdev);
 
 	/* Lack of partition table is unusual, but not a failure */
@@ -517,6 +585,7 @@ int blockdevice_unregister(struct block_device *blk)
 		free(chunk);
 	}
 
+	blk_stats_unregister(blk);
 	devfs_remove(&blk->cdev);
 	list_del(&blk->list);
 
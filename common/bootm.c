@@ -19,6 +19,7 @@
 #include <uncompress.h>
 #include <zero_page.h>
 #include <security/config.h>
+#include <bootprofile.h>
 
 static LIST_HEAD(handler_list);
 static struct sconfig_notifier_block sconfig_notifier;
@@ -222,19 +223,7 @@ static bool bootm_get_override(char **oldpath, const char *newpath)
 	return true;
 }
 
-/*
- * bootm_load_os() - load OS to RAM
- *
- * @data:		image data context
- * @load_address:	The address where the OS should be loaded to
- *
- * This loads the OS to a RAM location. load_address must be a valid
- * address. If the image_data doesn't have a OS specified it's considered
- * an error.
- *
- * Return: 0 on success, negative error code otherwise
- */
-int bootm_load_os(struct image_data *data, unsigned long load_address)
+static int __bootm_load_os(struct image_data *data, unsigned long load_address)
 {
 	if (data->os_res)
 		return 0;
@@ -283,6 +272,29 @@ int bootm_load_os(struct image_data *data, unsigned long load_address)
 	return 0;
 }
 
+/*
+ * bootm_load_os() - load OS to RAM
+ *
+ * @data:		image data context
+ * @load_address:	The address where the OS should be loaded to
+ *
+ * This loads the OS to a RAM location. load_address must be a valid
+ * address. If the image_data doesn't have a OS specified it's considered
+ * an error.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+int bootm_load_os(struct image_data *data, unsigned long load_address)
+{
+	u64 start = bootprofile_start();
+	int ret;
+
+	ret = __bootm_load_os(data, load_address);
+	bootprofile_bootm("load-os", start, ret);
+
+	return ret;
+}
+
 static bool fitconfig_has_ramdisk(struct image_data *data)
 {
 	if (!IS_ENABLED(CONFIG_FITIMAGE) || !data->os_fit)
@@ -319,21 +331,8 @@ static int bootm_open_initrd_uimage(struct image_data *data)
 	return 0;
 }
 
-/*
- * bootm_load_initrd() - load initrd to RAM
- *
- * @data:		image data context
- * @load_address:	The address where the initrd should be loaded to
- *
- * This loads the initrd to a RAM location. load_address must be a valid
- * address. If the image_data doesn't have a initrd specified this function
- * still returns successful as an initrd is optional. Check data->initrd_res
- * to see if an initrd has been loaded.
- *
- * Return: 0 on success, negative error code otherwise
- */
-const struct resource *
-bootm_load_initrd(struct image_data *data, unsigned long load_address)
+static const struct resource *
+__bootm_load_initrd(struct image_data *data, unsigned long load_address)
 {
 	enum filetype type;
 	int ret;
@@ -420,6 +419,31 @@ bootm_load_initrd(struct image_data *data, unsigned long load_address)
 	return data->initrd_res;
 }
 
+/*
+ * bootm_load_initrd() - load initrd to RAM
+ *
+ * @data:		image data context
+ * @load_address:	The address where the initrd should be loaded to
+ *
+ * This loads the initrd to a RAM location. load_address must be a valid
+ * address. If the image_data doesn't have a initrd specified this function
+ * still returns successful as an initrd is optional. Check data->initrd_res
+ * to see if an initrd has been loaded.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+const struct resource *
+bootm_load_initrd(struct image_data *data, unsigned long load_address)
+{
+	u64 start = bootprofile_start();
+	const struct resource *res;
+
+	res = __bootm_load_initrd(data, load_address);
+	bootprofile_bootm("load-initrd", start, PTR_ERR_OR_ZERO(res));
+
+	return res;
+}
+
 static int bootm_open_oftree_uimage(struct image_data *data, size_t *size,
 				    struct fdt_header **fdt)
 {
@@ -470,19 +494,7 @@ static bool fitconfig_has_fdt(struct image_data *data)
 	return fit_has_image(data->os_fit, data->fit_config, "fdt");
 }
 
-/*
- * bootm_get_devicetree() - get devicetree
- *
- * @data:		image data context
- *
- * This gets the fixed devicetree from the various image sources or the internal
- * devicetree. It returns a pointer to the allocated devicetree which must be
- * freed after use.
- *
- * Return: pointer to the fixed devicetree, NULL if image_data has an empty DT
- *         or a ERR_PTR() on failure.
- */
-void *bootm_get_devicetree(struct image_data *data)
+static void *__bootm_get_devicetree(struct image_data *data)
 {
 	enum filetype type;
 	struct fdt_header *oftree;
@@ -570,6 +582,29 @@ void *bootm_get_devicetree(struct image_data *data)
 	return oftree;
 }
 
+/*
+ * bootm_get_devicetree() - get devicetree
+ *
+ * @data:		image data context
+ *
+ * This gets the fixed devicetree from the various image sources or the internal
+ * devicetree. It returns a pointer to the allocated devicetree which must be
+ * freed after use.
+ *
+ * Return: pointer to the fixed devicetree, NULL if image_data has an empty DT
+ *         or a ERR_PTR() on failure.
+ */
+void *bootm_get_devicetree(struct image_data *data)
+{
+	u64 start = bootprofile_start();
+	void *oftree;
+
+	oftree = __bootm_get_devicetree(data);
+	bootprofile_bootm("devicetree", start, PTR_ERR_OR_ZERO(oftree));
+
+	return oftree;
+}
+
 /*
  * bootm_load_devicetree() - load devicetree
  *
@@ -787,12 +822,15 @@ int bootm_boot(struct bootm_data *bootm_data)
 	enum filetype os_type;
 	size_t size;
 	const char *os_type_str;
+	u64 start = bootprofile_start();
 
 	if (!bootm_data->os_file) {
 		pr_err("no image given\n");
 		return -ENOENT;
 	}
 
+	malloc_profile_phase("bootm");
+
 	data = xzalloc(sizeof(*data));
 
 	bootm_image_name_and_part(bootm_data->os_file, &data->os_file, &data->os_part);
@@ -1007,7 +1045,11 @@ int bootm_boot(struct bootm_data *bootm_data)
 		}
 	}
 
+	bootprofile_bootm("open", start, 0);
+
+	start = bootprofile_start();
 	ret = handler->bootm(data);
+	bootprofile_bootm(handler->name, start, ret);
 	if (data->dryrun)
 		pr_info("Dryrun. Aborted\n");
 
@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Boot time profiler
+ *
+ * Records the duration of initcalls, driver probes, deferred probe
+ * retries and bootm phases into a fixed size ring. The ring is never
+ * resized, so recording is cheap and works before malloc is usable.
+ * Block and file I/O, digests, decompression and network packets can be
+ * recorded as well, but as they quickly fill the ring, they are only
+ * enabled by default with CONFIG_BOOTPROFILE_IO.
+ * The results can be inspected with the bootprofile command and are
+ * passed to the kernel under /chosen/barebox-boot-profile.
+ */
+
+#include <common.h>
+#include <init.h>
+#include <of.h>
+#include <driver.h>
+#include <bootprofile.h>
+
+static struct bootprofile_entry bootprofile_ring[CONFIG_BOOTPROFILE_ENTRIES];
+static unsigned int bootprofile_head;
+static unsigned int bootprofile_count;
+
+#define BOOTPROFILE_IO_MASK	(BIT(BOOTPROFILE_BLOCK_READ) | \
+				 BIT(BOOTPROFILE_BLOCK_WRITE) | \
+				 BIT(BOOTPROFILE_FILE) | \
+				 BIT(BOOTPROFILE_NET_RX) | \
+				 BIT(BOOTPROFILE_NET_TX))
+#define BOOTPROFILE_ALL_MASK	(BIT(BOOTPROFILE_TYPE_MAX) - 1)
+
+static unsigned int bootprofile_mask = IS_ENABLED(CONFIG_BOOTPROFILE_IO) ?
+	BOOTPROFILE_ALL_MASK : BOOTPROFILE_ALL_MASK & ~BOOTPROFILE_IO_MASK;
+
+static struct bootprofile_entry *bootprofile_new(enum bootprofile_type type,
+						 u64 start, int ret)
+{
+	struct bootprofile_entry *e;
+
+	if (!(bootprofile_mask & BIT(type)))
+		return NULL;
+
+	e = &bootprofile_ring[bootprofile_head];
+
+	bootprofile_head = (bootprofile_head + 1) % ARRAY_SIZE(bootprofile_ring);
+	bootprofile_count++;
+
+	e->start = start;
+	e->duration = get_time_ns() - start;
+	e->ret = ret;
+	e->type = type;
+	e->depth = 0;
+	e->flags = 0;
+
+	return e;
+}
+
+void bootprofile_initcall(const void *fn, u64 start, int ret)
+{
+	struct bootprofile_entry *e;
+
+	e = bootprofile_new(BOOTPROFILE_INITCALL, start, ret);
+	if (e)
+		e->fn = fn;
+}
+
+void bootprofile_probe(enum bootprofile_type type, struct device *dev,
+		       int depth, u64 start, int ret)
+{
+	struct bootprofile_entry *e;
+
+	e = bootprofile_new(type, start, ret);
+	if (!e)
+		return;
+
+	e->depth = min_t(int, depth, U8_MAX);
+	strscpy(e->name, dev_name(dev), sizeof(e->name));
+}
+
+void bootprofile_bootm(const char *phase, u64 start, int ret)
+{
+	struct bootprofile_entry *e;
+
+	e = bootprofile_new(BOOTPROFILE_BOOTM, start, ret);
+	if (e)
+		e->phase = phase;
+}
+
+/* keep the end of long names, that's where the file name is */
+static void bootprofile_set_name(struct bootprofile_entry *e, const char *name)
+{
+	size_t len = strlen(name);
+
+	if (len >= sizeof(e->name))
+		name += len - sizeof(e->name) + 1;
+
+	strscpy(e->name, name, sizeof(e->name));
+}
+
+/**
+ * bootprofile_event - record an event of one of the generic types
+ * @type: the event type
+ * @name: device, file or algorithm name. It is copied, long names are
+ *        shortened at the front.
+ * @start: bootprofile_start() when the event started
+ * @ret: result, usually an error code or the number of bytes processed
+ */
+void bootprofile_event(enum bootprofile_type type, const char *name,
+		       u64 start, int ret)
+{
+	struct bootprofile_entry *e;
+
+	e = bootprofile_new(type, start, ret);
+	if (e)
+		bootprofile_set_name(e, name);
+}
+
+/**
+ * bootprofile_instant - record an event without duration
+ * @type: the event type
+ * @name: as for bootprofile_event()
+ * @ret: as for bootprofile_event()
+ */
+void bootprofile_instant(enum bootprofile_type type, const char *name,
+			 int ret)
+{
+	struct bootprofile_entry *e;
+
+	e = bootprofile_new(type, get_time_ns(), ret);
+	if (!e)
+		return;
+
+	e->duration = 0;
+	e->flags = BOOTPROFILE_F_INSTANT;
+	bootprofile_set_name(e, name);
+}
+
+/**
+ * bootprofile_set_mask - select the event types to record
+ * @mask: bitmask of BIT(enum bootprofile_type)
+ *
+ * Return: the previous mask
+ */
+unsigned int bootprofile_set_mask(unsigned int mask)
+{
+	unsigned int old = bootprofile_mask;
+
+	bootprofile_mask = mask & BOOTPROFILE_ALL_MASK;
+
+	return old;
+}
+
+unsigned int bootprofile_get_mask(void)
+{
+	return bootprofile_mask;
+}
+
+/**
+ * bootprofile_num_entries - number of entries currently in the ring
+ * @dropped: if non NULL, returns the number of overwritten entries
+ */
+unsigned int bootprofile_num_entries(unsigned int *dropped)
+{
+	unsigned int num = min_t(unsigned int, bootprofile_count,
+				 ARRAY_SIZE(bootprofile_ring));
+
+	if (dropped)
+		*dropped = bootprofile_count - num;
+
+	return num;
+}
+
+/**
+ * bootprofile_get_entry - get a recorded entry
+ * @i: index, 0 being the oldest entry still in the ring
+ */
+const struct bootprofile_entry *bootprofile_get_entry(unsigned int i)
+{
+	unsigned int num = bootprofile_num_entries(NULL);
+
+	if (i >= num)
+		return NULL;
+
+	i += bootprofile_head + ARRAY_SIZE(bootprofile_ring) - num;
+
+	return &bootprofile_ring[i % ARRAY_SIZE(bootprofile_ring)];
+}
+
+int bootprofile_entry_name(const struct bootprofile_entry *e,
+			   char *buf, size_t len)
+{
+	switch (e->type) {
+	case BOOTPROFILE_INITCALL:
+		return snprintf(buf, len, "%pS", e->fn);
+	case BOOTPROFILE_BOOTM:
+		return snprintf(buf, len, "%s", e->phase);
+	default:
+		return snprintf(buf, len, "%s", e->name);
+	}
+}
+
+static const char * const bootprofile_type_names[] = {
+	[BOOTPROFILE_INITCALL] = "initcall",
+	[BOOTPROFILE_PROBE] = "probe",
+	[BOOTPROFILE_DEFERRED] = "deferred",
+	[BOOTPROFILE_BOOTM] = "bootm",
+	[BOOTPROFILE_BLOCK_READ] = "block-read",
+	[BOOTPROFILE_BLOCK_WRITE] = "block-write",
+	[BOOTPROFILE_FILE] = "file",
+	[BOOTPROFILE_DIGEST] = "digest",
+	[BOOTPROFILE_DECOMPRESS] = "decompress",
+	[BOOTPROFILE_NET_RX] = "net-rx",
+	[BOOTPROFILE_NET_TX] = "net-tx",
+};
+
+const char *bootprofile_type_name(enum bootprofile_type type)
+{
+	if (type >= ARRAY_SIZE(bootprofile_type_names))
+		return "unknown";
+
+	return bootprofile_type_names[type];
+}
+
+void bootprofile_clear(void)
+{
+	bootprofile_head = 0;
+	bootprofile_count = 0;
+}
+
+static int bootprofile_of_fixup(struct device_node *root, void *unused)
+{
+	const struct bootprofile_entry *e;
+	struct device_node *node;
+	unsigned int i, num, dropped;
+	size_t len = 0, pos;
+	u32 *start, *duration;
+	char *names;
+	int ret;
+
+	num = bootprofile_num_entries(&dropped);
+	if (!num)
+		return 0;
+
+	node = of_find_node_by_path_from(root, "/chosen/barebox-boot-profile");
+	if (node)
+		of_delete_node(node);
+
+	node = of_create_node(root, "/chosen/barebox-boot-profile");
+	if (!node)
+		return -ENOMEM;
+
+	for (i = 0; i < num; i++) {
+		e = bootprofile_get_entry(i);
+		len += strlen(bootprofile_type_name(e->type)) + 1;
+		len += bootprofile_entry_name(e, NULL, 0) + 1;
+	}
+
+	names = xmalloc(len);
+	start = xmalloc(num * sizeof(*start));
+	duration = xmalloc(num * sizeof(*duration));
+
+	for (i = 0, pos = 0; i < num; i++) {
+		e = bootprofile_get_entry(i);
+
+		pos += snprintf(names + pos, len - pos, "%s:",
+				bootprofile_type_name(e->type));
+		pos += bootprofile_entry_name(e, names + pos, len - pos) + 1;
+
+		start[i] = div_u64(e->start, NSEC_PER_USEC);
+		duration[i] = div_u64(e->duration, NSEC_PER_USEC);
+	}
+
+	ret = of_set_property(node, "names", names, len, 1);
+	if (!ret)
+		ret = of_property_write_u32_array(node, "start-us", start, num);
+	if (!ret)
+		ret = of_property_write_u32_array(node, "duration-us", duration, num);
+	if (!ret)
+		ret = of_property_write_u32(node, "dropped", dropped);
+	if (!ret)
+		ret = of_property_write_u32(node, "timestamp-us",
+					    div_u64(get_time_ns(), NSEC_PER_USEC));
+
+	free(names);
+	free(start);
+	free(duration);
+
+	return ret;
+}
+
+static int bootprofile_init(void)
+{
+	return of_register_fixup(bootprofile_of_fixup, NULL);
+}
+late_initcall(bootprofile_init);
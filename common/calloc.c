@@ -4,6 +4,7 @@
 #include <malloc.h>
 #include <memory.h>
 #include <linux/overflow.h>
+#include <linux/instruction_pointer.h>
 
 /*
  * calloc calls malloc, then zeroes out the allocated chunk.
@@ -11,7 +12,11 @@
 void *calloc(size_t n, size_t elem_size)
 {
 	size_t size = size_mul(elem_size, n);
-	void *r = malloc(size);
+	void *r;
+
+	malloc_profile_caller(_RET_IP_);
+
+	r = malloc(size);
 
 	if (!ZERO_OR_NULL_PTR(r) && !want_init_on_alloc())
 		memset(r, 0x0, size);
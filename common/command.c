@@ -17,10 +17,26 @@
 #include <init.h>
 #include <complete.h>
 #include <getopt.h>
+#include <linux/hash.h>
 
 LIST_HEAD(command_list);
 EXPORT_SYMBOL(command_list);
 
+#define COMMAND_HASH_BITS	8
+
+/* commands hashed by name, so that find_cmd() doesn't walk the whole list */
+static struct hlist_head command_hash[1 << COMMAND_HASH_BITS];
+
+static struct hlist_head *command_hash_head(const char *name)
+{
+	u32 hash = 0;
+
+	while (*name)
+		hash = hash * 31 + *name++;
+
+	return &command_hash[hash_32(hash, COMMAND_HASH_BITS)];
+}
+
 void barebox_cmd_usage(struct command *cmdtp)
 {
 	putchar('\n');
@@ -89,6 +105,8 @@ int register_command(struct command *cmd)
 	debug("register command %s\n", cmd->name);
 
 	list_add_sort(&cmd->list, &command_list, compare);
+	/* newest first, like in command_list */
+	hlist_add_head(&cmd->hnode, command_hash_head(cmd->name));
 
 	if (cmd->aliases) {
 		const char * const *aliases = cmd->aliases;
@@ -120,7 +138,7 @@ struct command *find_cmd (const char *cmd)
 {
 	struct command *cmdtp;
 
-	for_each_command(cmdtp)
+	hlist_for_each_entry(cmdtp, command_hash_head(cmd), hnode)
 		if (!strcmp(cmd, cmdtp->name))
 			return cmdtp;
 
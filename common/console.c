@@ -18,6 +18,7 @@
 #include <kfifo.h>
 #include <module.h>
 #include <sched.h>
+#include <poller.h>
 #include <ratp_bb.h>
 #include <magicvar.h>
 #include <globalvar.h>
@@ -47,6 +48,70 @@ static struct kfifo __console_output_fifo;
 static struct kfifo *console_input_fifo = &__console_input_fifo;
 static struct kfifo *console_output_fifo = &__console_output_fifo;
 
+/*
+ * With CONFIG_CONSOLE_TX_ASYNC, output to consoles that can tell whether
+ * they are ready to transmit is queued in a per console FIFO and drained
+ * by a poller, so that printing doesn't wait for the UART. The FIFO is
+ * drained synchronously when it's full and on console_flush().
+ */
+static struct poller_struct console_tx_poller;
+
+static void console_tx_drain(struct console_device *cdev, bool wait)
+{
+	unsigned char c;
+
+	while (kfifo_len(cdev->tx_fifo)) {
+		if (!wait && !cdev->tx_ready(cdev))
+			return;
+
+		kfifo_getc(cdev->tx_fifo, &c);
+		cdev->putc(cdev, c);
+	}
+}
+
+/**
+ * console_tx_flush - write out queued console output
+ * @cdev: the console device
+ *
+ * Must be called by code writing to the device with cdev->putc()
+ * directly, like file transfer protocols, so that queued console output
+ * isn't sent in the middle of their data later.
+ */
+void console_tx_flush(struct console_device *cdev)
+{
+	if (cdev->tx_fifo)
+		console_tx_drain(cdev, true);
+}
+EXPORT_SYMBOL(console_tx_flush);
+
+static void console_tx_putc(struct console_device *cdev, char c)
+{
+	unsigned char ch;
+
+	if (!cdev->tx_fifo) {
+		cdev->putc(cdev, c);
+		return;
+	}
+
+	/* make room for one character, waiting for the UART if needed */
+	if (kfifo_len(cdev->tx_fifo) == cdev->tx_fifo->size) {
+		kfifo_getc(cdev->tx_fifo, &ch);
+		cdev->putc(cdev, ch);
+	}
+
+	kfifo_putc(cdev->tx_fifo, c);
+}
+
+static void console_tx_poll(struct poller_struct *poller)
+{
+	struct console_device *cdev;
+
+	for_each_console(cdev) {
+		if (cdev->tx_fifo)
+			console_tx_drain(cdev, false);
+	}
+}
+
 int console_open(struct console_device *cdev)
 {
 	int ret;
@@ -90,8 +155,11 @@ int console_set_active(struct console_device *cdev, unsigned flag)
 	if (!cdev->putc)
 		flag &= ~(CONSOLE_STDOUT | CONSOLE_STDERR);
 
-	if (!flag && cdev->f_active && cdev->flush)
-		cdev->flush(cdev);
+	if (!flag && cdev->f_active) {
+		console_tx_flush(cdev);
+		if (cdev->flush)
+			cdev->flush(cdev);
+	}
 
 	if (flag == cdev->f_active)
 		return 0;
@@ -187,6 +255,8 @@ int console_set_baudrate(struct console_device *cdev, unsigned baudrate)
 		mdelay(50);
 	}
 
+	console_tx_flush(cdev);
+
 	ret = cdev->setbrg(cdev, baudrate);
 	if (ret)
 		return ret;
@@ -279,12 +349,12 @@ static int __console_puts(struct console_device *cdev, const char *s,
 
 	for (i = 0; i < nbytes; i++) {
 		if (*s == '\n') {
-			cdev->putc(cdev, '\r');
+			console_tx_putc(cdev, '\r');
 			if (IS_ENABLED(CONFIG_CONSOLE_FLUSH_LINE_BREAK) && cdev->flush)
 				cdev->flush(cdev);
 		}
 
-		cdev->putc(cdev, *s);
+		console_tx_putc(cdev, *s);
 		s++;
 	}
 	return i;
@@ -311,6 +381,8 @@ static int fops_flush(struct cdev *dev)
 {
 	struct console_device *priv = dev->priv;
 
+	console_tx_flush(priv);
+
 	if (priv->flush)
 		priv->flush(priv);
 
@@ -327,6 +399,25 @@ static ssize_t fops_write(struct cdev* dev, const void* buf, size_t count,
 	return count;
 }
 
+static void console_tx_init(struct console_device *cdev)
+{
+	if (!IS_ENABLED(CONFIG_CONSOLE_TX_ASYNC) || !cdev->tx_ready)
+		return;
+
+	/* drivers with their own puts write out directly */
+	if (cdev->puts != __console_puts)
+		return;
+
+	cdev->tx_fifo = kfifo_alloc(CONFIG_CONSOLE_TX_BUFFER_SIZE);
+	if (!cdev->tx_fifo)
+		return;
+
+	if (!console_tx_poller.registered) {
+		console_tx_poller.func = console_tx_poll;
+		poller_register(&console_tx_poller, "console-tx");
+	}
+}
+
 int console_register(struct console_device *newcdev)
 {
 	struct device_node *serdev_node = console_is_serdev_node(newcdev);
@@ -389,6 +480,8 @@ int console_register(struct console_device *newcdev)
 	if (newcdev->putc && !newcdev->puts)
 		newcdev->puts = __console_puts;
 
+	console_tx_init(newcdev);
+
 	dev_add_param_string(dev, "active", console_active_set, console_active_get,
 			     &newcdev->active_string, newcdev);
 
@@ -445,6 +538,11 @@ int console_unregister(struct console_device *cdev)
 
 	devfs_remove(&cdev->devfs);
 
+	if (cdev->tx_fifo) {
+		console_tx_flush(cdev);
+		kfifo_free(cdev->tx_fifo);
+	}
+
 	list_del(&cdev->list);
 	if (list_empty(&console_list))
 		initialized = CONSOLE_UNINITIALIZED;
@@ -596,8 +694,8 @@ void console_putc(unsigned int ch, char c)
 		for_each_console(cdev) {
 			if (cdev->f_active & ch) {
 				if (c == '\n')
-					cdev->putc(cdev, '\r');
-				cdev->putc(cdev, c);
+					console_tx_putc(cdev, '\r');
+				console_tx_putc(cdev, c);
 			}
 		}
 		return;
@@ -642,6 +740,7 @@ void console_flush(void)
 	struct console_device *cdev;
 
 	for_each_console(cdev) {
+		console_tx_flush(cdev);
 		if (cdev->flush)
 			cdev->flush(cdev);
 	}
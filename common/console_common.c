@@ -20,11 +20,14 @@
 #include <password.h>
 #include <clock.h>
 #include <malloc.h>
+#include <logbuf.h>
 #include <linux/pstore.h>
 #include <linux/math64.h>
 #include <linux/sizes.h>
 #include <linux/overflow.h>
 #include <security/config.h>
+#include <pbl/handoff-data.h>
+#include <asm/io.h>
 
 #ifndef CONFIG_CONSOLE_NONE
 
@@ -39,15 +42,42 @@ static const char *colored_log_level[] = {
 
 int barebox_loglevel = CONFIG_DEFAULT_LOGLEVEL;
 
-LIST_HEAD(barebox_logbuf);
-static int barebox_logbuf_num_messages;
 static int barebox_log_max_messages;
 
-static void log_del(struct log_entry *log)
+#ifdef CONFIG_LOGBUF
+static u64 barebox_logbuf_mem[CONFIG_LOGBUF_SIZE / sizeof(u64)] __aligned(SZ_4K);
+static struct logbuf *barebox_logbuf;
+
+static void log_import_pbl(struct logbuf *lb)
+{
+	struct logbuf *pbl;
+	struct log_entry *e;
+	size_t size;
+
+	pbl = handoff_data_get_entry(HANDOFF_DATA_PBL_LOG, &size);
+	if (!pbl || !logbuf_valid(pbl, size))
+		return;
+
+	logbuf_for_each_entry(pbl, e)
+		logbuf_add(lb, e->timestamp, e->level,
+			   e->flags | LOG_ENTRY_PBL, e->msg);
+}
+
+/**
+ * barebox_log - get the barebox log buffer
+ *
+ * The buffer is statically allocated, so messages can be logged right from
+ * the start. On first use the messages logged by the PBL are imported.
+ */
+struct logbuf *barebox_log(void)
 {
-	list_del(&log->list);
-	free(log);
-	barebox_logbuf_num_messages--;
+	if (!barebox_logbuf) {
+		barebox_logbuf = logbuf_init(barebox_logbuf_mem,
+					     sizeof(barebox_logbuf_mem));
+		log_import_pbl(barebox_logbuf);
+	}
+
+	return barebox_logbuf;
 }
 
 /**
@@ -61,17 +91,43 @@ static void log_del(struct log_entry *log)
  */
 void log_clean(unsigned int limit)
 {
-	struct log_entry *log, *tmp;
+	struct logbuf *lb = barebox_log();
 
-	if (list_empty(&barebox_logbuf))
-		return;
+	while (lb->num > limit)
+		logbuf_drop_oldest(lb);
+}
 
-	list_for_each_entry_safe(log, tmp, &barebox_logbuf, list) {
-		if (barebox_logbuf_num_messages <= limit)
-			break;
-		log_del(log);
-	}
+static int log_of_fixup(struct device_node *root, void *unused)
+{
+	struct logbuf *lb = barebox_log();
+	struct device_node *node;
+	struct resource res = {};
+	int ret;
+
+	res.start = virt_to_phys(lb);
+	res.end = res.start + lb->size - 1;
+	res.name = "barebox-log";
+
+	ret = of_fixup_reserved_memory(root, &res);
+	if (ret)
+		return ret;
+
+	node = of_find_node_by_path_from(root, "/reserved-memory/barebox-log");
+	if (!node)
+		return -ENOMEM;
+
+	return of_property_write_string(node, "compatible", "barebox,log");
+}
+
+static int log_of_fixup_init(void)
+{
+	if (!IS_ENABLED(CONFIG_LOGBUF_OF_FIXUP))
+		return 0;
+
+	return of_register_fixup(log_of_fixup, NULL);
 }
+late_initcall(log_of_fixup_init);
+#endif
 
 static void print_colored_log_level(unsigned int ch, const int level)
 {
@@ -87,31 +143,16 @@ static void print_colored_log_level(unsigned int ch, const int level)
 
 static void pr_puts(int level, const char *str)
 {
-	struct log_entry *log;
+	if (IS_ENABLED(CONFIG_LOGBUF) && barebox_log_max_messages >= 0) {
+		struct logbuf *lb = barebox_log();
 
-	if (IS_ENABLED(CONFIG_LOGBUF) && mem_malloc_is_initialized()) {
 		if (barebox_log_max_messages > 0)
 			log_clean(barebox_log_max_messages - 1);
 
-		if (barebox_log_max_messages >= 0) {
-			int msglen;
-
-			msglen = strlen(str);
-			log = malloc(struct_size(log, msg, msglen + 1));
-			if (!log)
-				goto nolog;
-
-			memcpy(log->msg, str, msglen + 1);
-
-			log->timestamp = get_time_ns();
-			log->level = level;
-			list_add_tail(&log->list, &barebox_logbuf);
-			barebox_logbuf_num_messages++;
-		}
+		logbuf_add(lb, get_time_ns(), level, 0, str);
 	}
 
 	pstore_log(str);
-nolog:
 
 	if (level > barebox_loglevel)
 		return;
@@ -179,12 +220,9 @@ bool console_allow_color(void)
 
 static int console_common_init(void)
 {
-	if (IS_ENABLED(CONFIG_LOGBUF)) {
-		barebox_log_max_messages
-			= clamp(mem_malloc_size() / SZ_32K, 1000UL, 100000UL);
+	if (IS_ENABLED(CONFIG_LOGBUF))
 		globalvar_add_simple_int("log_max_messages",
 				&barebox_log_max_messages, "%d");
-	}
 
 	globalvar_add_simple_bool("allow_color", &__console_allow_color);
 
@@ -195,13 +233,17 @@ core_initcall(console_common_init);
 int log_writefile(const char *filepath)
 {
 	int ret = 0, nbytes = 0, fd = -1;
+	struct logbuf *lb = barebox_log();
 	struct log_entry *log;
 
+	if (!lb)
+		return 0;
+
 	fd = open(filepath, O_WRONLY | O_CREAT | O_TRUNC);
 	if (fd < 0)
 		return -errno;
 
-	list_for_each_entry(log, &barebox_logbuf, list) {
+	logbuf_for_each_entry(lb, log) {
 		ret = dputs(fd, log->msg);
 		if (ret < 0)
 			break;
@@ -223,10 +265,14 @@ int log_writefile(const char *filepath)
  */
 int log_print(unsigned flags, unsigned levels)
 {
+	struct logbuf *lb = barebox_log();
 	struct log_entry *log;
 	unsigned long last = 0;
 
-	list_for_each_entry(log, &barebox_logbuf, list) {
+	if (!lb)
+		return 0;
+
+	logbuf_for_each_entry(lb, log) {
 		uint64_t time_ns = log->timestamp;
 		unsigned long time;
 
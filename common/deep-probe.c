@@ -8,6 +8,8 @@
 
 #include <common.h>
 #include <deep-probe.h>
+#include <init.h>
+#include <environment.h>
 #include <of.h>
 
 enum deep_probe_state {
@@ -85,3 +87,92 @@ bool deep_probe_is_supported(void)
 	return boardstate;
 }
 EXPORT_SYMBOL_GPL(deep_probe_is_supported);
+
+#ifdef CONFIG_DEEP_PROBE_LAZY
+
+static bool lazy_probe_completed;
+
+/**
+ * deep_probe_is_lazy - check if devices are only probed on demand
+ *
+ * Return: true if of_probe() should only create the devices needed for
+ * booting, the rest being left to deep_probe_complete().
+ */
+bool deep_probe_is_lazy(void)
+{
+	return !lazy_probe_completed && deep_probe_is_supported();
+}
+
+/**
+ * deep_probe_complete - probe all devices skipped by lazy probing
+ */
+void deep_probe_complete(void)
+{
+	if (!deep_probe_is_lazy())
+		return;
+
+	lazy_probe_completed = true;
+
+	pr_debug("probing remaining devices\n");
+
+	of_platform_populate(of_get_root_node(), of_default_bus_match_table, NULL);
+}
+
+static int lazy_probe_watchdogs(void)
+{
+	if (deep_probe_is_lazy())
+		of_devices_ensure_probed_by_name("watchdog");
+
+	return 0;
+}
+of_populate_initcall(lazy_probe_watchdogs);
+
+static void lazy_probe_boot_target(const char *target)
+{
+	char *name, *dot;
+	int ret;
+
+	if (!strcmp(target, "net")) {
+		target = "ethernet0";
+	} else if (strncmp(target, "/dev/", 5) == 0) {
+		target += 5;
+	}
+
+	/* mmc1.rootfs and similar: probe the device, partitions follow */
+	name = xstrdup(target);
+	dot = strchr(name, '.');
+	if (dot)
+		*dot = '\0';
+
+	ret = of_device_ensure_probed_by_alias(name);
+	if (ret != -EINVAL)
+		pr_debug("boot target %s: %pe\n", name, ERR_PTR(ret));
+
+	free(name);
+}
+
+static int lazy_probe_boot_targets(void)
+{
+	const char *targets;
+	char *str, *freep, *target;
+
+	if (!deep_probe_is_lazy())
+		return 0;
+
+	targets = getenv("global.boot.default");
+	if (!targets)
+		return 0;
+
+	str = freep = xstrdup(targets);
+
+	while ((target = strsep(&str, " ")))
+		if (*target)
+			lazy_probe_boot_target(target);
+
+	free(freep);
+
+	return 0;
+}
+postenvironment_initcall(lazy_probe_boot_targets);
+
+#endif
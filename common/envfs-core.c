@@ -23,6 +23,7 @@
 #include <libgen.h>
 #include <environment.h>
 #include <libfile.h>
+#include <ramfs.h>
 #else
 #define pr_info(fmt, ...)	printf(pr_fmt(fmt), ##__VA_ARGS__)
 #define pr_warn(fmt, ...)	printf(pr_fmt(fmt), ##__VA_ARGS__)
@@ -74,15 +75,222 @@ int envfs_check_data(struct envfs_super *super, const void *buf, size_t size)
 	return 0;
 }
 
-int envfs_load_data(struct envfs_super *super, void *buf, size_t size,
-		const char *dir, unsigned flags)
+/**
+ * envfs_check_index - check the file index following the envfs data
+ * @super: the superblock
+ * @buf: the envfs data
+ * @size: size of the envfs data
+ * @len: number of bytes available at @buf, including the index
+ *
+ * Return: 0 if a valid index follows the data, -ENOENT if the envfs has no
+ * index and -EIO if it is damaged.
+ */
+int envfs_check_index(struct envfs_super *super, const void *buf, size_t size,
+		size_t len)
+{
+	const struct envfs_index *index = buf + size;
+	uint32_t i, num, ofs, fsize;
+
+	if (!(ENVFS_32(super->flags) & ENVFS_FLAGS_INDEX))
+		return -ENOENT;
+
+	if (len < size + sizeof(*index) ||
+	    ENVFS_32(index->magic) != ENVFS_INDEX_MAGIC)
+		return -EIO;
+
+	num = ENVFS_32(index->num);
+	if (num > (len - size - sizeof(*index)) / sizeof(index->entries[0]))
+		return -EIO;
+
+	if (crc32(0, index->entries, num * sizeof(index->entries[0])) !=
+	    ENVFS_32(index->crc)) {
+		pr_warn("wrong crc on env index\n");
+		return -EIO;
+	}
+
+	for (i = 0; i < num; i++) {
+		const struct envfs_index_entry *e = &index->entries[i];
+
+		ofs = ENVFS_32(e->name);
+		if (ofs >= size || !memchr(buf + ofs, 0, size - ofs))
+			return -EIO;
+
+		ofs = ENVFS_32(e->data);
+		fsize = ENVFS_32(e->size);
+		if (ofs > size || fsize > size - ofs)
+			return -EIO;
+	}
+
+	return 0;
+}
+
+#ifdef __BAREBOX__
+/*
+ * The loaded envfs data. Files in ramfs refer to it until they are
+ * modified, it is freed when the last of them is.
+ */
+struct envfs_buf {
+	void *freep;
+	int refcount;
+};
+
+static void envfs_buf_put(void *priv)
+{
+	struct envfs_buf *eb = priv;
+
+	if (--eb->refcount)
+		return;
+
+	free(eb->freep);
+	free(eb);
+}
+
+static struct envfs_buf *envfs_buf_get(void *freep)
 {
-	int fd, ret = 0;
+	struct envfs_buf *eb = xzalloc(sizeof(*eb));
+
+	eb->freep = freep;
+	eb->refcount = 1;
+
+	return eb;
+}
+
+/* let the file refer to the envfs data instead of copying it */
+static int envfs_set_ext_data(int fd, const void *buf, uint32_t size,
+		struct envfs_buf *eb)
+{
+	struct ramfs_ext_data ext = {
+		.data = buf,
+		.size = size,
+		.release = envfs_buf_put,
+		.priv = eb,
+	};
+
+	if (!size || ioctl(fd, RAMFS_IOC_SET_EXT_DATA, &ext))
+		return -ENOSYS;
+
+	eb->refcount++;
+
+	return 0;
+}
+#else
+struct envfs_buf;
+
+static void envfs_buf_put(void *priv)
+{
+	free(priv);
+}
+
+static struct envfs_buf *envfs_buf_get(void *freep)
+{
+	return freep;
+}
+
+static int envfs_set_ext_data(int fd, const void *buf, uint32_t size,
+		struct envfs_buf *eb)
+{
+	return -ENOSYS;
+}
+#endif
+
+static int envfs_load_file(const char *dir, const char *name, uint32_t mode,
+		const void *buf, uint32_t size, unsigned flags,
+		struct envfs_buf *eb, char **lastdir)
+{
+	struct stat s;
 	char *str, *tmp;
+	int fd, ret;
+
+	str = concat_path_file(dir, name);
+
+	/* the files are sorted, so only create each directory once */
+	tmp = strdup(str);
+	dirname(tmp);
+	if (*lastdir && !strcmp(*lastdir, tmp)) {
+		free(tmp);
+	} else {
+		make_directory(tmp);
+		free(*lastdir);
+		*lastdir = tmp;
+	}
+
+	ret = stat(str, &s);
+	if (!ret && (flags & ENV_FLAG_NO_OVERWRITE)) {
+		printf("skip %s\n", str);
+		free(str);
+		return 0;
+	}
+
+	if (S_ISLNK(mode)) {
+		debug("symlink: %s -> %s\n", str, (char*)buf);
+		if (!strcmp(buf, basename(str))) {
+			unlink(str);
+		} else {
+			if (!ret)
+				unlink(str);
+
+			ret = symlink(buf, str);
+			if (ret < 0)
+				printf("symlink: %s -> %s : %s\n",
+						str, (char*)buf, strerror(-errno));
+		}
+		free(str);
+
+		return 0;
+	}
+
+	fd = open(str, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	free(str);
+	if (fd < 0) {
+		printf("Open %m\n");
+		return fd;
+	}
+
+	if (!envfs_set_ext_data(fd, buf, size, eb)) {
+		close(fd);
+		return 0;
+	}
+
+	ret = write(fd, buf, size);
+	if (ret < size) {
+		perror("write");
+		close(fd);
+		return -errno;
+	}
+
+	close(fd);
+
+	return 0;
+}
+
+static int envfs_load_index(void *buf, size_t size, const char *dir,
+		unsigned flags, struct envfs_buf *eb, char **lastdir)
+{
+	const struct envfs_index *index = buf + size;
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < ENVFS_32(index->num); i++) {
+		const struct envfs_index_entry *e = &index->entries[i];
+
+		ret = envfs_load_file(dir, buf + ENVFS_32(e->name),
+				ENVFS_32(e->mode), buf + ENVFS_32(e->data),
+				ENVFS_32(e->size), flags, eb, lastdir);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int envfs_load_inodes(struct envfs_super *super, void *buf,
+		size_t size, const char *dir, unsigned flags,
+		struct envfs_buf *eb, char **lastdir)
+{
+	int ret;
 	int headerlen_full;
 	/* for envfs < 1.0 */
 	struct envfs_inode_end inode_end_dummy;
-	struct stat s;
 
 	inode_end_dummy.mode = ENVFS_32(S_IRWXU | S_IRWXG | S_IRWXO);
 	inode_end_dummy.magic = ENVFS_32(ENVFS_INODE_END_MAGIC);
@@ -97,8 +305,7 @@ int envfs_load_data(struct envfs_super *super, void *buf, size_t size,
 
 		if (ENVFS_32(inode->magic) != ENVFS_INODE_MAGIC) {
 			pr_warn("wrong magic\n");
-			ret = -EIO;
-			goto out;
+			return -EIO;
 		}
 		inode_size = ENVFS_32(inode->size);
 		inode_headerlen = ENVFS_32(inode->headerlen);
@@ -111,74 +318,72 @@ int envfs_load_data(struct envfs_super *super, void *buf, size_t size,
 		debug("loading %s size %d namelen %d headerlen %d\n", inode->data,
 			inode_size, namelen, inode_headerlen);
 
-		str = concat_path_file(dir, inode->data);
-
 		headerlen_full = PAD4(inode_headerlen);
 		buf += headerlen_full;
 
 		if (ENVFS_32(inode_end->magic) != ENVFS_INODE_END_MAGIC) {
 			printf("envfs: wrong inode_end_magic\n");
-			ret = -EIO;
-			goto out;
+			return -EIO;
 		}
 
-		tmp = strdup(str);
-		make_directory(dirname(tmp));
-		free(tmp);
-
-		ret = stat(str, &s);
-		if (!ret && (flags & ENV_FLAG_NO_OVERWRITE)) {
-			printf("skip %s\n", str);
-			goto skip;
-		}
+		ret = envfs_load_file(dir, inode->data,
+				ENVFS_32(inode_end->mode), buf, inode_size,
+				flags, eb, lastdir);
+		if (ret)
+			return ret;
 
-		if (S_ISLNK(ENVFS_32(inode_end->mode))) {
-			debug("symlink: %s -> %s\n", str, (char*)buf);
-			if (!strcmp(buf, basename(str))) {
-				unlink(str);
-			} else {
-				if (!ret)
-					unlink(str);
-
-				ret = symlink(buf, str);
-				if (ret < 0)
-					printf("symlink: %s -> %s : %s\n",
-							str, (char*)buf, strerror(-errno));
-			}
-			free(str);
-		} else {
-			fd = open(str, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-			free(str);
-			if (fd < 0) {
-				printf("Open %m\n");
-				ret = fd;
-				goto out;
-			}
-
-			ret = write(fd, buf, inode_size);
-			if (ret < inode_size) {
-				perror("write");
-				ret = -errno;
-				close(fd);
-				goto out;
-			}
-			close(fd);
-		}
-skip:
 		buf += PAD4(inode_size);
 		size -= headerlen_full + PAD4(inode_size) +
 				sizeof(struct envfs_inode);
 	}
 
+	return 0;
+}
+
+/**
+ * envfs_load_data - create the files of an envfs in a directory
+ * @super: the superblock
+ * @buf: the envfs data
+ * @size: size of the envfs data
+ * @len: number of bytes available at @buf, including a possible index
+ * @dir: the directory to create the files in
+ * @flags: ENV_FLAG_* flags
+ * @freep: the allocation containing @buf, NULL if @buf is never freed
+ *
+ * This takes ownership of @freep. Files created in ramfs refer to @buf
+ * until they are modified, so @freep is freed when the last of them is.
+ */
+int envfs_load_data(struct envfs_super *super, void *buf, size_t size,
+		size_t len, const char *dir, unsigned flags, void *freep)
+{
+	struct envfs_buf *eb = envfs_buf_get(freep);
+	char *lastdir = NULL;
+	int ret;
+
+	ret = envfs_check_index(super, buf, size, len);
+	if (!ret) {
+		ret = envfs_load_index(buf, size, dir, flags, eb, &lastdir);
+	} else {
+		if (ret == -EIO)
+			pr_warn("damaged env index, ignoring it\n");
+		ret = envfs_load_inodes(super, buf, size, dir, flags, eb,
+				&lastdir);
+	}
+
+	free(lastdir);
+	envfs_buf_put(eb);
+
+	if (ret)
+		return ret;
+
 	recursive_action(dir, ACTION_RECURSE | ACTION_DEPTHFIRST, NULL,
 			dir_remove_action, NULL, 0);
 
-	ret = 0;
-out:
-	return ret;
+	return 0;
 }
 
-int envfs_load_from_buf(void *buf, int len, const char *dir, unsigned flags)
+int envfs_load_from_buf(void *buf, int len, const char *dir, unsigned flags,
+		void *freep)
 {
 	int ret;
 	size_t size;
@@ -188,13 +393,20 @@ int envfs_load_from_buf(void *buf, int len, const char *dir, unsigned flags)
 
 	ret = envfs_check_super(super, &size);
 	if (ret)
-		return ret;
+		goto err;
+
+	ret = -EIO;
+	if (size > len - sizeof(*super))
+		goto err;
 
 	ret = envfs_check_data(super, buf, size);
 	if (ret)
-		return ret;
+		goto err;
 
-	ret = envfs_load_data(super, buf, size, dir, flags);
+	return envfs_load_data(super, buf, size, len - sizeof(*super), dir,
+			flags, freep);
+err:
+	free(freep);
 
 	return ret;
 }
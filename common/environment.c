@@ -46,6 +46,8 @@ struct envfs_entry {
 struct action_data {
 	const char *base;
 	void *writep;
+	void *datap;
+	struct envfs_index_entry *index;
 	struct envfs_entry *env;
 };
 
@@ -237,6 +239,10 @@ static void envfs_save_inode(struct action_data *data, struct envfs_entry *env)
 
 	data->writep += sizeof(struct envfs_inode);
 
+	data->index->name = ENVFS_32(data->writep - data->datap);
+	data->index->size = ENVFS_32(env->size);
+	data->index->mode = ENVFS_32(env->mode);
+
 	strcpy(data->writep, env->name);
 	data->writep += PAD4(namelen);
 
@@ -245,6 +251,9 @@ static void envfs_save_inode(struct action_data *data, struct envfs_entry *env)
 	inode_end->mode = ENVFS_32(env->mode);
 	data->writep += sizeof(struct envfs_inode_end);
 
+	data->index->data = ENVFS_32(data->writep - data->datap);
+	data->index++;
+
 	memcpy(data->writep, env->buf, env->size);
 	data->writep += PAD4(env->size);
 }
@@ -308,7 +317,8 @@ static int file_remove_action(const char *filename, struct stat *statbuf,
 int envfs_save(const char *filename, const char *dirname, unsigned flags)
 {
 	struct envfs_super *super;
-	int envfd, size, ret;
+	struct envfs_index *index = NULL;
+	int envfd, size, ret, num = 0, indexsize = 0;
 	struct action_data data = {};
 	void *buf = NULL, *wbuf;
 	struct envfs_entry *env;
@@ -342,11 +352,16 @@ int envfs_save(const char *filename, const char *dirname, unsigned flags)
 			size += sizeof(struct envfs_inode);
 			size += PAD4(strlen(env->name) + 1);
 			size += sizeof(struct envfs_inode_end);
+			num++;
 		}
+
+		flags |= ENVFS_FLAGS_INDEX;
+		indexsize = sizeof(*index) + num * sizeof(index->entries[0]);
 	}
 
-	buf = xzalloc(size + sizeof(struct envfs_super));
+	buf = xzalloc(size + indexsize + sizeof(struct envfs_super));
 	data.writep = buf + sizeof(struct envfs_super);
+	data.datap = data.writep;
 
 	super = buf;
 	super->magic = ENVFS_32(ENVFS_MAGIC);
@@ -356,6 +371,11 @@ int envfs_save(const char *filename, const char *dirname, unsigned flags)
 	super->flags = ENVFS_32(flags);
 
 	if (!(flags & ENVFS_FLAGS_FORCE_BUILT_IN)) {
+		index = data.datap + size;
+		index->magic = ENVFS_32(ENVFS_INDEX_MAGIC);
+		index->num = ENVFS_32(num);
+		data.index = index->entries;
+
 		/* second pass: copy files to buffer */
 		env = data.env;
 		while (env) {
@@ -372,6 +392,9 @@ int envfs_save(const char *filename, const char *dirname, unsigned flags)
 
 	super->crc = ENVFS_32(crc32(0, buf + sizeof(struct envfs_super), size));
 	super->sb_crc = ENVFS_32(crc32(0, buf, sizeof(struct envfs_super) - 4));
+	if (index)
+		index->crc = ENVFS_32(crc32(0, index->entries,
+					    num * sizeof(index->entries[0])));
 
 	envfd = open(filename, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR);
 	if (envfd < 0) {
@@ -396,7 +419,7 @@ int envfs_save(const char *filename, const char *dirname, unsigned flags)
 		goto out;
 	}
 
-	size += sizeof(struct envfs_super);
+	size += indexsize + sizeof(struct envfs_super);
 
 	wbuf = buf;
 
@@ -437,6 +460,25 @@ int envfs_save(const char *filename, const char *dirname, unsigned flags)
 }
 EXPORT_SYMBOL(envfs_save);
 
+static int envfs_read(int fd, void *buf, size_t size)
+{
+	while (size) {
+		ssize_t now;
+
+		now = read(fd, buf, size);
+		if (now < 0)
+			return -errno;
+
+		if (!now)
+			return -EINVAL;
+
+		buf += now;
+		size -= now;
+	}
+
+	return 0;
+}
+
 /**
  * Restore the last environment into the current one
  * @param[in] filename from where to restore
@@ -449,10 +491,11 @@ EXPORT_SYMBOL(envfs_save);
 int envfs_load(const char *filename, const char *dir, unsigned flags)
 {
 	struct envfs_super super;
-	void *buf = NULL, *rbuf;
+	struct envfs_index *index;
+	void *buf = NULL;
 	int envfd;
 	int ret = 0;
-	size_t size, rsize;
+	size_t size, len;
 	__maybe_unused const char *defenv_path;
 
 #ifdef __BAREBOX__
@@ -497,36 +540,47 @@ int envfs_load(const char *filename, const char *dir, unsigned flags)
 		goto out;
 	}
 
-	buf = xmalloc(size);
-
-	rbuf = buf;
-	rsize = size;
+	len = size;
+	if (ENVFS_32(super.flags) & ENVFS_FLAGS_INDEX)
+		len += sizeof(*index);
 
-	while (rsize) {
-		ssize_t now;
+	buf = xmalloc(len);
 
-		now = read(envfd, rbuf, rsize);
-		if (now < 0) {
-			perror("read");
-			ret = -errno;
-			goto out;
-		}
-
-		if (!now) {
+	ret = envfs_read(envfd, buf, size);
+	if (ret) {
+		if (ret == -EINVAL)
 			printf("%s: premature end of file\n", filename);
-			ret = -EINVAL;
-			goto out;
-		}
-
-		rbuf += now;
-		rsize -= now;
+		else
+			perror("read");
+		goto out;
 	}
 
 	ret = envfs_check_data(&super, buf, size);
 	if (ret)
 		goto out;
 
-	ret = envfs_load_data(&super, buf, size, dir, flags);
+	/* the index isn't covered by the data crc, envfs_check_index() checks it */
+	index = buf + size;
+	if (len > size && !envfs_read(envfd, index, sizeof(*index)) &&
+	    ENVFS_32(index->num) <= size / sizeof(struct envfs_inode)) {
+		void *tmp;
+
+		len += ENVFS_32(index->num) * sizeof(index->entries[0]);
+
+		tmp = xmalloc(len);
+		memcpy(tmp, buf, size + sizeof(*index));
+		free(buf);
+		buf = tmp;
+
+		if (envfs_read(envfd, buf + size + sizeof(*index),
+			       len - size - sizeof(*index)))
+			len = size;
+	} else {
+		len = size;
+	}
+
+	ret = envfs_load_data(&super, buf, size, len, dir, flags, buf);
+	buf = NULL;
 	if (ret)
 		goto out;
 
@@ -37,10 +37,23 @@ void nv_var_set_persistable(void)
 	nv_persistable = true;
 }
 
+/* Can @name match more than a single variable? */
+static bool globalvar_is_pattern(const char *name)
+{
+	return strpbrk(name, "*?[\\") != NULL;
+}
+
 void globalvar_remove(const char *name)
 {
 	struct param_d *p, *tmp;
 
+	if (!globalvar_is_pattern(name)) {
+		p = get_param_by_name(&global_device, name);
+		if (p)
+			param_remove(p);
+		return;
+	}
+
 	dev_for_each_param_safe(&global_device, p, tmp) {
 		if (fnmatch(name, p->name, 0))
 			continue;
@@ -272,25 +285,41 @@ int nvvar_add(const char *name, const char *value)
 	return nv_save(name, value);
 }
 
+static void nvvar_remove_one(struct param_d *p)
+{
+	char *fname;
+
+	fname = basprintf("/env/nv/%s", p->name);
+
+	param_remove(p);
+
+	unlink(fname);
+	free(fname);
+}
+
 int nvvar_remove(const char *name)
 {
 	struct param_d *p, *tmp;
-	char *fname;
 	int ret = -ENOENT;
 
 	if (!IS_ENABLED(CONFIG_NVVAR))
 		return -ENOSYS;
 
+	if (!globalvar_is_pattern(name)) {
+		p = get_param_by_name(&nv_device, name);
+		if (!p)
+			return -ENOENT;
+
+		nvvar_remove_one(p);
+
+		return 0;
+	}
+
 	dev_for_each_param_safe(&nv_device, p, tmp) {
 		if (fnmatch(name, p->name, 0))
 			continue;
 
-		fname = basprintf("/env/nv/%s", p->name);
-
-		param_remove(p);
-
-		unlink(fname);
-		free(fname);
+		nvvar_remove_one(p);
 
 		ret = 0;
 	}
@@ -425,17 +454,15 @@ char *globalvar_get_match(const char *match, const char *separator)
 	char *val = NULL;
 	struct param_d *param;
 
-	dev_for_each_param(&global_device, param) {
-		if (!strncmp(match, param->name, strlen(match))) {
-			const char *p = dev_get_param(&global_device, param->name);
-			if (val) {
-				char *new = basprintf("%s%s%s", val,
-							separator, p);
-				free(val);
-				val = new;
-			} else {
-				val = xstrdup(p);
-			}
+	bobject_for_each_param_prefix(&global_device, param, match) {
+		const char *p = dev_get_param(&global_device, param->name);
+		if (val) {
+			char *new = basprintf("%s%s%s", val,
+						separator, p);
+			free(val);
+			val = new;
+		} else {
+			val = xstrdup(p);
 		}
 	}
 
@@ -449,10 +476,8 @@ void globalvar_set_match(const char *match, const char *val)
 {
 	struct param_d *param;
 
-	dev_for_each_param(&global_device, param) {
-		if (!strncmp(match, param->name, strlen(match)))
-			dev_set_param(&global_device, param->name, val);
-	}
+	bobject_for_each_param_prefix(&global_device, param, match)
+		dev_set_param(&global_device, param->name, val);
 }
 
 void globalvar_set(const char *name, const char *val)
@@ -762,14 +787,8 @@ static int nv_global_param_complete(struct device *dev,
 				    char *instr, int eval)
 {
 	struct param_d *param;
-	int len;
-
-	len = strlen(instr);
-
-	dev_for_each_param(dev, param) {
-		if (strncmp(instr, param->name, len))
-			continue;
 
+	bobject_for_each_param_prefix(dev, param, instr) {
 		string_list_add_asprintf(sl, "%s%c",
 			param->name,
 			eval ? ' ' : '=');
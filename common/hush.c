@@ -266,8 +266,20 @@ struct in_str {
 
 #define final_printf hush_debug
 
+/* set while trying to parse a script for the script cache */
+static int parse_quiet;
+
+/* properties of the script being parsed, for the script cache */
+static unsigned int parse_flags;
+#define PARSE_USES_ARGS		(1 << 0)	/* $1..$9, $# or $* */
+#define PARSE_GLOBBED		(1 << 1)	/* "for ... in" globbed files */
+#define PARSE_RUNTIME_STATE	(1 << 2)	/* getopt or IFS= */
+
 static void syntax(void)
 {
+	if (parse_quiet)
+		return;
+
 	printf("syntax error\n");
 }
 
@@ -275,6 +287,9 @@ static void syntaxf(const char *fmt, ...)
 {
 	va_list args;
 
+	if (parse_quiet)
+		return;
+
 	printf("syntax error: ");
 
 	va_start(args, fmt);
@@ -769,6 +784,7 @@ static int run_pipe_real(struct p_context *ctx, struct pipe *pi)
 	glob_t globbuf = {};
 	int ret;
 	int rcode;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -797,6 +813,8 @@ static int run_pipe_real(struct p_context *ctx, struct pipe *pi)
 	if (!pi->progs[0].argv)
 		return -1;
 
+	sp = child->sp;
+
 	for (i = 0; is_assignment(child->argv[i]); i++)
 		{ /* nothing */ }
 
@@ -831,11 +849,11 @@ static int run_pipe_real(struct p_context *ctx, struct pipe *pi)
 			return 1;
 
 		if (p != child->argv[i]) {
-			child->sp--;
+			sp--;
 			free(p);
 		}
 	}
-	if (child->sp) {
+	if (sp) {
 		char * str = NULL;
 		struct p_context ctx1;
 
@@ -876,7 +894,7 @@ static int run_list_real(struct p_context *ctx, struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
-	struct pipe *rpipe;
+	struct pipe *rpipe, *for_pipe = NULL;
 	int flag_rep = 0;
 	int rcode=0, flag_skip=1;
 	int flag_restore = 0, flag_conditional = 0;
@@ -904,8 +922,10 @@ static int run_list_real(struct p_context *ctx, struct pipe *pi)
 		if (pi->r_mode == RES_WHILE || pi->r_mode == RES_UNTIL ||
 				pi->r_mode == RES_FOR) {
 			/* check Ctrl-C */
-			if (ctrlc())
-				return 1;
+			if (ctrlc()) {
+				rcode = 1;
+				goto out;
+			}
 			flag_restore = 0;
 			if (!rpipe) {
 				flag_rep = 0;
@@ -946,6 +966,7 @@ static int run_list_real(struct p_context *ctx, struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				for_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -954,6 +975,7 @@ static int run_list_real(struct p_context *ctx, struct pipe *pi)
 				free(pi->progs->argv[0]);
 				free(save_list);
 				list = NULL;
+				for_pipe = NULL;
 				flag_rep = 0;
 				pi->progs->argv[0] = save_name;
 				continue;
@@ -988,7 +1010,7 @@ static int run_list_real(struct p_context *ctx, struct pipe *pi)
 
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return rcode;	/* exit */
+			goto out;	/* exit */
 		}
 
 		/* Conditional statements like "if", "elif", "while" and "until"
@@ -1027,6 +1049,19 @@ static int run_list_real(struct p_context *ctx, struct pipe *pi)
 		rcode = 0;
 	}
 
+out:
+	/*
+	 * When leaving a "for" loop early, restore its variable name, the
+	 * list may be cached and run again.
+	 */
+	if (for_pipe) {
+		free(for_pipe->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		for_pipe->progs->argv[0] = save_name;
+	}
+
 	return rcode;
 }
 
@@ -1102,13 +1137,15 @@ static int xglob(o_string *dest, int flags, glob_t *pglob, int glob_needed)
 			return 0;
 		}
 	} else if (glob_needed) {
+		if (IS_ENABLED(CONFIG_GLOB))
+			parse_flags |= PARSE_GLOBBED;
 		gr = do_glob(dest->data, flags, NULL, pglob);
 		hush_debug("glob returned %d\n",gr);
 	} else {
 		gr = fake_glob(dest->data, flags, NULL, pglob);
 		hush_debug("globhack returned %d\n",gr);
 	}
-	if (gr != 0) { /* GLOB_ABORTED ? */
+	if (gr != 0 && !parse_quiet) { /* GLOB_ABORTED ? */
 		error_msg("glob(3) error %d",gr);
 	}
 
@@ -1324,6 +1361,14 @@ static int done_word(o_string *dest, struct p_context *ctx)
 		syntax();
 		return 1;  /* syntax error, groups and arglists don't mix */
 	}
+	/*
+	 * getopt shifts the positional arguments and IFS changes how later
+	 * lines are split, both only when the script runs.
+	 */
+	if (!child->argv && dest->data &&
+	    (!strcmp(dest->data, "getopt") || !strncmp(dest->data, "IFS=", 4)))
+		parse_flags |= PARSE_RUNTIME_STATE;
+
 	if (!child->argv && (ctx->type & FLAG_PARSE_SEMICOLON)) {
 		hush_debug("checking %s for reserved-ness\n",dest->data);
 		if (reserved_word(dest,ctx))
@@ -1472,6 +1517,7 @@ static int handle_dollar(o_string *dest, struct p_context *ctx, struct in_str *i
 
 	} else if (isdigit(ch)) {
 
+		parse_flags |= PARSE_USES_ARGS;
 		i = ch - '0';	/* XXX is $0 special? */
 		if (i < ctx->global_argc) {
 			parse_string(dest, ctx, ctx->global_argv[i]);        /* recursion */
@@ -1488,6 +1534,7 @@ static int handle_dollar(o_string *dest, struct p_context *ctx, struct in_str *i
 			advance = 1;
 			break;
 		case '#':
+			parse_flags |= PARSE_USES_ARGS;
 			b_adduint(dest,ctx->global_argc ? ctx->global_argc-1 : 0);
 			advance = 1;
 			break;
@@ -1508,6 +1555,7 @@ static int handle_dollar(o_string *dest, struct p_context *ctx, struct in_str *i
 			b_addchr(dest, SPECIAL_VAR_SYMBOL);
 			break;
 		case '*':
+			parse_flags |= PARSE_USES_ARGS;
 			for (i = 1; i < ctx->global_argc; i++) {
 				b_addstr(dest, ctx->global_argv[i]);
 				b_addchr(dest, ' ');
@@ -1952,10 +2000,240 @@ static int execute_script(const char *path, int argc, char *argv[])
 	return ret;
 }
 
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+/*
+ * Parsed scripts, so scripts run several times during boot are parsed only
+ * once. barebox filesystems don't keep modification times, so an entry is
+ * only used when the script contents are unchanged. $1..$9, $# and $* are
+ * substituted while parsing, so scripts using them must also be run with
+ * the same arguments. Scripts calling getopt, which shifts the arguments,
+ * or setting IFS are not cached, because parsing them ahead would see the
+ * state from before these ran.
+ */
+struct script_cache {
+	struct list_head list;
+	char *path;
+	char *script;
+	size_t size;
+	int argc;
+	char **argv;		/* NULL if the script doesn't use its arguments */
+	const void *scope;
+	struct pipe **lists;
+	int num_lists;
+	int uncacheable;
+	int active;		/* number of running instances */
+};
+
+static LIST_HEAD(script_cache_list);
+static int script_cache_num;
+
+static void script_cache_free(struct script_cache *sc)
+{
+	int i;
+
+	list_del(&sc->list);
+	script_cache_num--;
+
+	for (i = 0; i < sc->num_lists; i++)
+		free_pipe_list(sc->lists[i], 0);
+	free(sc->lists);
+	talloc_free((void *)sc->scope);
+
+	for (i = 0; sc->argv && i < sc->argc; i++)
+		free(sc->argv[i]);
+	free(sc->argv);
+	free(sc->path);
+	free(sc->script);
+	free(sc);
+}
+
+static bool script_cache_args_match(struct script_cache *sc, int argc,
+				    char *argv[])
+{
+	int i;
+
+	if (!sc->argv)
+		return true;
+	if (sc->argc != argc)
+		return false;
+
+	for (i = 0; i < argc; i++)
+		if (strcmp(sc->argv[i], argv[i]))
+			return false;
+
+	return true;
+}
+
+static struct script_cache *script_cache_lookup(const char *path,
+						const char *script, size_t size,
+						int argc, char *argv[])
+{
+	struct script_cache *sc;
+
+	list_for_each_entry(sc, &script_cache_list, list) {
+		if (strcmp(sc->path, path))
+			continue;
+		if (sc->size != size || memcmp(sc->script, script, size))
+			continue;
+		if (!script_cache_args_match(sc, argc, argv))
+			continue;
+
+		/* keep the list in LRU order */
+		list_move(&sc->list, &script_cache_list);
+
+		return sc;
+	}
+
+	return NULL;
+}
+
+/*
+ * Parse a whole script into its top level lists without running them.
+ * Returns 0 on success, nonzero on syntax errors.
+ */
+static int parse_script(struct p_context *ctx, const char *script,
+			struct script_cache *sc)
+{
+	o_string temp = NULL_O_STRING;
+	struct in_str input;
+	int rcode;
+
+	setup_string_in_str(&input, script);
+
+	do {
+		ctx->type = FLAG_PARSE_SEMICOLON;
+		initialize_context(ctx, false);
+		update_ifs_map();
+
+		rcode = parse_stream(&temp, ctx, &input, '\n');
+		if (rcode == 1 || ctx->old_flag != 0) {
+			if (ctx->old_flag != 0)
+				free(ctx->stack);
+			free_pipe_list(ctx->list_head, 0);
+			b_free(&temp);
+			return 1;
+		}
+
+		done_word(&temp, ctx);
+		done_pipe(ctx, PIPE_SEQ);
+		b_free(&temp);
+
+		if (!ctx->list_head->num_progs) {
+			free_pipe_list(ctx->list_head, 0);
+			continue;
+		}
+
+		sc->lists = xrealloc(sc->lists,
+				     (sc->num_lists + 1) * sizeof(*sc->lists));
+		sc->lists[sc->num_lists++] = ctx->list_head;
+	} while (rcode != -1);
+
+	return 0;
+}
+
+static struct script_cache *script_cache_add(const char *path, char *script,
+					     size_t size, int argc, char *argv[])
+{
+	struct script_cache *sc, *tmp, *n;
+	struct p_context ctx = {};
+	int i, ret;
+
+	sc = xzalloc(sizeof(*sc));
+	sc->path = xstrdup(path);
+	sc->script = script;
+	sc->size = size;
+
+	initialize_context(&ctx, true);
+	ctx.global_argc = argc;
+	ctx.global_argv = argv;
+
+	parse_flags = 0;
+	parse_quiet++;
+	ret = parse_script(&ctx, script, sc);
+	parse_quiet--;
+
+	sc->scope = ctx.scope;
+
+	if (ret || (parse_flags & (PARSE_GLOBBED | PARSE_RUNTIME_STATE))) {
+		/* let the caller parse and run it the usual way */
+		while (sc->num_lists)
+			free_pipe_list(sc->lists[--sc->num_lists], 0);
+		sc->uncacheable = 1;
+	} else if (parse_flags & PARSE_USES_ARGS) {
+		sc->argc = argc;
+		sc->argv = xzalloc((argc + 1) * sizeof(*argv));
+		for (i = 0; i < argc; i++)
+			sc->argv[i] = xstrdup(argv[i]);
+	}
+
+	list_for_each_entry_safe_reverse(tmp, n, &script_cache_list, list) {
+		if (script_cache_num < CONFIG_HUSH_SCRIPT_CACHE_ENTRIES)
+			break;
+		if (!tmp->active)
+			script_cache_free(tmp);
+	}
+
+	list_add(&sc->list, &script_cache_list);
+	script_cache_num++;
+
+	return sc;
+}
+
+static int run_script(struct p_context *ctx, const char *path, char *script,
+		      size_t size)
+{
+	struct script_cache *sc;
+	int i, code = 0;
+
+	/* parse_stream() wants the last line terminated, like parse_string_outer() */
+	if (!size || script[size - 1] != '\n') {
+		script = xrealloc(script, size + 2);
+		script[size++] = '\n';
+		script[size] = '\0';
+	}
+
+	sc = script_cache_lookup(path, script, size, ctx->global_argc,
+				 ctx->global_argv);
+	if (sc) {
+		free(script);
+	} else {
+		sc = script_cache_add(path, script, size, ctx->global_argc,
+				      ctx->global_argv);
+	}
+
+	sc->active++;
+
+	if (sc->uncacheable)
+		code = parse_string_outer(ctx, sc->script, FLAG_PARSE_SEMICOLON);
+
+	for (i = 0; i < sc->num_lists; i++) {
+		code = run_list_real(ctx, sc->lists[i]);
+		if (code < -1 || ctrlc())
+			break;
+	}
+
+	sc->active--;
+
+	return code;
+}
+#else
+static int run_script(struct p_context *ctx, const char *path, char *script,
+		      size_t size)
+{
+	int ret;
+
+	ret = parse_string_outer(ctx, script, FLAG_PARSE_SEMICOLON);
+	free(script);
+
+	return ret;
+}
+#endif
+
 static int source_script(const char *path, int argc, char *argv[])
 {
 	struct p_context ctx = {};
 	char *script;
+	size_t size;
 	int ret;
 
 	initialize_context(&ctx, true);
@@ -1963,18 +2241,17 @@ static int source_script(const char *path, int argc, char *argv[])
 	ctx.global_argc = argc;
 	ctx.global_argv = argv;
 
-	script = read_file(path, NULL);
+	script = read_file(path, &size);
 	if (!script) {
 		perror("sh");
 		return 1;
 	}
 
-	ret = parse_string_outer(&ctx, script, FLAG_PARSE_SEMICOLON);
+	ret = run_script(&ctx, path, script, size);
 	if (ret < -1)
 		ret = -ret - 2;
 
 	release_context(&ctx);
-	free(script);
 
 	return ret;
 }
@@ -25,6 +25,8 @@
 #include <uncompress.h>
 #include <image-fit.h>
 #include <fuzz.h>
+#include <offload.h>
+#include <bootprofile.h>
 
 #define FDT_MAX_DEPTH 32
 #define FDT_MAX_PATH_LEN 200
@@ -378,6 +380,29 @@ static int fit_verify_signature(struct fit_handle *handle, struct device_node *s
 	return ret;
 }
 
+static struct device_node *fit_get_hash_node(struct device_node *image)
+{
+	struct device_node *hash;
+
+	hash = of_get_child_by_name(image, "hash-1");
+	if (!hash)
+		hash = of_get_child_by_name(image, "hash@1");
+
+	return hash;
+}
+
+static bool fit_image_is_hashed(struct fit_handle *handle,
+				struct device_node *image)
+{
+	unsigned int i;
+
+	for (i = 0; i < handle->num_hashed_images; i++)
+		if (handle->hashed_images[i] == image)
+			return true;
+
+	return false;
+}
+
 static int fit_verify_hash(struct fit_handle *handle, struct device_node *image,
 			   const void *data, int data_len)
 {
@@ -386,6 +411,7 @@ static int fit_verify_hash(struct fit_handle *handle, struct device_node *image,
 	const char *value_read;
 	int hash_len, ret;
 	struct device_node *hash;
+	u64 start;
 
 	switch (handle->verify) {
 	case BOOTM_VERIFY_NONE:
@@ -397,15 +423,19 @@ static int fit_verify_hash(struct fit_handle *handle, struct device_node *image,
 		ret = -EINVAL;
 	}
 
-	hash = of_get_child_by_name(image, "hash-1");
-	if (!hash)
-		hash = of_get_child_by_name(image, "hash@1");
+	hash = fit_get_hash_node(image);
 	if (!hash) {
 		if (ret)
 			pr_err("image %pOF does not have hashes\n", image);
 		return ret;
 	}
 
+	if (fit_image_is_hashed(handle, image)) {
+		if (handle->verbose)
+			pr_info("%pOF: hash OK\n", hash);
+		return 0;
+	}
+
 	value_read = of_get_property(hash, "value", &hash_len);
 	if (!value_read) {
 		pr_err("%pOF: \"value\" property not found\n", hash);
@@ -429,8 +459,10 @@ static int fit_verify_hash(struct fit_handle *handle, struct device_node *image,
 		goto err_digest_free;
 	}
 
+	start = bootprofile_start();
 	digest_init(d);
 	digest_update(d, data, data_len);
+	bootprofile_event(BOOTPROFILE_DIGEST, algo, start, data_len);
 
 	if (digest_verify(d, value_read)) {
 		pr_err("%pOF: hash BAD\n", hash);
@@ -872,6 +904,111 @@ static int fit_find_last_unit(struct fit_handle *handle,
 	return 0;
 }
 
+struct fit_hash_job {
+	struct offload_digest_job dj;
+	struct device_node *image;
+	const void *value;
+};
+
+static bool fit_hash_job_prepare(struct fit_handle *handle,
+				 struct fit_hash_job *job,
+				 const struct property *pp)
+{
+	struct device_node *image, *hash;
+	const char *unit, *algo;
+	int len, data_len;
+
+	unit = of_property_get_value(pp);
+	if (!pp->length || strnlen(unit, pp->length) == pp->length)
+		return false;
+
+	image = of_get_child_by_name(handle->images, unit);
+	if (!image || fit_image_is_hashed(handle, image))
+		return false;
+
+	hash = fit_get_hash_node(image);
+	if (!hash || of_property_read_string(hash, "algo", &algo))
+		return false;
+
+	job->value = of_get_property(hash, "value", &len);
+	if (!job->value)
+		return false;
+
+	job->dj.buf = of_get_property(image, "data", &data_len);
+	if (!job->dj.buf || !data_len)
+		return false;
+
+	job->dj.len = data_len;
+
+	job->dj.d = digest_alloc(algo);
+	if (!job->dj.d)
+		return false;
+
+	if (len != digest_length(job->dj.d)) {
+		digest_free(job->dj.d);
+		return false;
+	}
+
+	job->dj.out = xmalloc(len);
+	job->image = image;
+
+	return true;
+}
+
+/*
+ * Hash the images referenced by a configuration in parallel on all
+ * CPUs. Images with a matching hash are remembered, so fit_verify_hash()
+ * needn't hash them again when they are opened. Anything unusual is
+ * left to fit_verify_hash(), which reports the error as before.
+ */
+static void fit_config_hash_images(struct fit_handle *handle,
+				   struct device_node *conf_node)
+{
+	struct fit_hash_job *jobs;
+	struct property *pp;
+	unsigned int i, njobs = 0, nprops = 0;
+	u64 start;
+
+	if (handle->verify == BOOTM_VERIFY_NONE || offload_num_cpus() == 1)
+		return;
+
+	for_each_property_of_node(conf_node, pp)
+		nprops++;
+
+	jobs = xzalloc(nprops * sizeof(*jobs));
+
+	for_each_property_of_node(conf_node, pp) {
+		if (fit_hash_job_prepare(handle, &jobs[njobs], pp))
+			njobs++;
+	}
+
+	start = bootprofile_start();
+
+	for (i = 0; i < njobs; i++)
+		offload_digest_submit(&jobs[i].dj);
+
+	for (i = 0; i < njobs; i++) {
+		struct fit_hash_job *job = &jobs[i];
+		int ret;
+
+		ret = offload_job_wait(&job->dj.job);
+		if (!ret && !memcmp(job->dj.out, job->value,
+				    digest_length(job->dj.d))) {
+			handle->hashed_images = xrealloc(handle->hashed_images,
+				(handle->num_hashed_images + 1) *
+				sizeof(*handle->hashed_images));
+			handle->hashed_images[handle->num_hashed_images++] = job->image;
+		}
+
+		free(job->dj.out);
+		digest_free(job->dj.d);
+	}
+
+	bootprofile_event(BOOTPROFILE_DIGEST, "fit-parallel", start, njobs);
+
+	free(jobs);
+}
+
 /**
  * fit_open_configuration - open a FIT configuration
  * @handle: The FIT image handle
@@ -918,6 +1055,8 @@ void *fit_open_configuration(struct fit_handle *handle, const char *name,
 	if (ret)
 		return ERR_PTR(ret);
 
+	fit_config_hash_images(handle, conf_node);
+
 	return conf_node;
 }
 
@@ -1064,6 +1203,7 @@ static void __fit_close(struct fit_handle *handle)
 	if (handle->filename)
 		list_del(&handle->entry);
 
+	free(handle->hashed_images);
 	free(handle->filename);
 	free(handle->fit_alloc);
 }
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Statistics and latency histograms of device requests
+ */
+
+#include <common.h>
+#include <driver.h>
+#include <param.h>
+#include <malloc.h>
+#include <iostat.h>
+
+static int iostat_latency_get(struct param_d *p, void *priv)
+{
+	struct iostat *s = priv;
+	char *str, *pos;
+	int i;
+
+	/* 10 digits and a separator for each bucket */
+	pos = str = xmalloc(IOSTAT_LATENCY_BUCKETS * 11 + 1);
+	*str = '\0';
+
+	for (i = 0; i < IOSTAT_LATENCY_BUCKETS; i++)
+		pos += sprintf(pos, "%s%u", i ? " " : "", s->latency[i]);
+
+	free(s->latency_str);
+	s->latency_str = str;
+
+	return 0;
+}
+
+static void iostat_add_param_u64(struct device *dev, const char *prefix,
+				 const char *name, u64 *value)
+{
+	char *pname = xasprintf("%s_%s", prefix, name);
+
+	dev_add_param_uint64_ro(dev, pname, value, "%llu");
+	free(pname);
+}
+
+/**
+ * iostat_add_params - expose statistics as device parameters
+ * @dev: the device to add the parameters to
+ * @prefix: parameter name prefix, like "read" or "write"
+ * @s: the statistics
+ *
+ * Adds <prefix>_requests, <prefix>_errors, <prefix>_bytes, <prefix>_time_ns
+ * and <prefix>_latency. The latter contains the histogram buckets
+ * separated by spaces.
+ */
+void iostat_add_params(struct device *dev, const char *prefix,
+		       struct iostat *s)
+{
+	char *pname;
+
+	if (!IS_ENABLED(CONFIG_PARAMETER))
+		return;
+
+	iostat_add_param_u64(dev, prefix, "requests", &s->requests);
+	iostat_add_param_u64(dev, prefix, "errors", &s->errors);
+	iostat_add_param_u64(dev, prefix, "bytes", &s->bytes);
+	iostat_add_param_u64(dev, prefix, "time_ns", &s->time_ns);
+
+	pname = xasprintf("%s_latency", prefix);
+	dev_add_param_string(dev, pname, param_set_readonly,
+			     iostat_latency_get, &s->latency_str, s);
+	free(pname);
+}
@@ -0,0 +1,324 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Allocation profiler
+ *
+ * Every allocation gets a small header in front of it which records its
+ * size and allocation site, so that the bytes held by each site can be
+ * tracked until they are freed again. Allocation sites are the callers of
+ * malloc() and friends, or of wrappers like xzalloc() which pass their
+ * own caller with malloc_profile_caller(). The peak heap usage is tracked
+ * per boot phase.
+ */
+
+#define pr_fmt(fmt) "malloc-profile: " fmt
+
+#include <common.h>
+#include <malloc.h>
+#include <qsort.h>
+#include <linux/hash.h>
+#include <linux/log2.h>
+
+#include "malloc_profile.h"
+
+#define MALLOC_PROFILE_MAGIC	0xa5
+#define MALLOC_PROFILE_PHASES	8
+
+struct malloc_profile_hdr {
+	u32 size;
+	u16 site;
+	u8 offset_shift;
+	u8 magic;
+};
+
+struct malloc_profile_site {
+	unsigned long caller;
+	unsigned long allocs;
+	unsigned int live;
+	size_t bytes;
+	size_t peak;
+};
+
+struct malloc_profile_phase {
+	const char *name;
+	size_t start;
+	size_t peak;
+};
+
+/* site 0 collects everything once the table is full */
+static struct malloc_profile_site sites[CONFIG_MALLOC_PROFILE_SITES];
+static unsigned int num_sites = 1;
+
+static struct malloc_profile_phase phases[MALLOC_PROFILE_PHASES] = {
+	{ .name = "early" },
+};
+static unsigned int cur_phase;
+
+static size_t cur_bytes, peak_bytes;
+static unsigned long pending_caller;
+
+static_assert(sizeof(struct malloc_profile_hdr) <= MALLOC_PROFILE_HDR);
+static_assert((CONFIG_MALLOC_PROFILE_SITES & (CONFIG_MALLOC_PROFILE_SITES - 1)) == 0);
+
+/**
+ * malloc_profile_caller - attribute the next allocation to @caller
+ * @caller: return address of the allocation wrapper
+ *
+ * To be called by allocation wrappers before calling into malloc(), so
+ * that the allocation shows up under the wrapper's caller. When wrappers
+ * are nested, the outermost one wins.
+ */
+void malloc_profile_caller(unsigned long caller)
+{
+	if (!pending_caller)
+		pending_caller = caller;
+}
+
+/*
+ * Called for allocations which are not profiled, so that the caller set by
+ * a wrapper isn't attributed to the next, unrelated allocation.
+ */
+void malloc_profile_skip(void)
+{
+	pending_caller = 0;
+}
+
+static unsigned int malloc_profile_site(unsigned long caller)
+{
+	unsigned int bits = ilog2(CONFIG_MALLOC_PROFILE_SITES);
+	unsigned int i, idx;
+
+	if (pending_caller) {
+		caller = pending_caller;
+		pending_caller = 0;
+	}
+
+	idx = hash_long(caller, bits);
+
+	for (i = 0; i < CONFIG_MALLOC_PROFILE_SITES; i++) {
+		struct malloc_profile_site *site;
+
+		idx = (idx + i) & (CONFIG_MALLOC_PROFILE_SITES - 1);
+		if (!idx)
+			continue;
+
+		site = &sites[idx];
+		if (site->caller == caller)
+			return idx;
+
+		if (!site->caller) {
+			if (num_sites == CONFIG_MALLOC_PROFILE_SITES - 1)
+				break;
+			num_sites++;
+			site->caller = caller;
+			return idx;
+		}
+	}
+
+	return 0;
+}
+
+static struct malloc_profile_hdr *malloc_profile_hdr(const void *mem)
+{
+	return (struct malloc_profile_hdr *)(mem - MALLOC_PROFILE_HDR);
+}
+
+static void malloc_profile_account(struct malloc_profile_hdr *hdr,
+				   size_t bytes, unsigned long caller)
+{
+	struct malloc_profile_phase *phase = &phases[cur_phase];
+	struct malloc_profile_site *site;
+
+	hdr->size = bytes;
+	hdr->site = malloc_profile_site(caller);
+	hdr->magic = MALLOC_PROFILE_MAGIC;
+
+	site = &sites[hdr->site];
+	site->allocs++;
+	site->live++;
+	site->bytes += bytes;
+	site->peak = max(site->peak, site->bytes);
+
+	cur_bytes += bytes;
+	peak_bytes = max(peak_bytes, cur_bytes);
+	phase->peak = max(phase->peak, cur_bytes);
+}
+
+static void malloc_profile_unaccount(struct malloc_profile_hdr *hdr)
+{
+	struct malloc_profile_site *site = &sites[hdr->site];
+
+	site->live--;
+	site->bytes -= hdr->size;
+	cur_bytes -= hdr->size;
+}
+
+void *malloc_profile_alloc(void *raw, size_t offset, size_t bytes,
+			   unsigned long caller)
+{
+	struct malloc_profile_hdr *hdr;
+	void *mem;
+
+	if (!raw) {
+		pending_caller = 0;
+		return NULL;
+	}
+
+	mem = raw + offset;
+	hdr = malloc_profile_hdr(mem);
+	hdr->offset_shift = ilog2(offset);
+
+	malloc_profile_account(hdr, bytes, caller);
+
+	return mem;
+}
+
+void *malloc_profile_free(void *mem)
+{
+	struct malloc_profile_hdr *hdr = malloc_profile_hdr(mem);
+
+	/*
+	 * The start of the block is unknown without a valid header, so
+	 * leak it rather than handing the wrong pointer to the allocator.
+	 */
+	if (hdr->magic != MALLOC_PROFILE_MAGIC) {
+		pr_warn("leaking %p which is not a profiled allocation\n", mem);
+		dump_stack();
+		return NULL;
+	}
+
+	malloc_profile_unaccount(hdr);
+	hdr->magic = 0;
+
+	return mem - (1UL << hdr->offset_shift);
+}
+
+size_t malloc_profile_offset(const void *mem)
+{
+	return 1UL << malloc_profile_hdr(mem)->offset_shift;
+}
+
+/*
+ * Called with the result of reallocating a profiled allocation. The header
+ * was moved along with the data and still describes the old allocation.
+ */
+void *malloc_profile_realloc(void *raw, size_t offset, size_t bytes,
+			     unsigned long caller)
+{
+	struct malloc_profile_hdr *hdr;
+	void *mem;
+
+	if (!raw) {
+		pending_caller = 0;
+		return NULL;
+	}
+
+	mem = raw + offset;
+	hdr = malloc_profile_hdr(mem);
+
+	malloc_profile_unaccount(hdr);
+	malloc_profile_account(hdr, bytes, caller);
+
+	return mem;
+}
+
+/**
+ * malloc_profile_phase - start a new phase for peak usage tracking
+ * @name: static name of the phase
+ */
+void malloc_profile_phase(const char *name)
+{
+	struct malloc_profile_phase *phase;
+
+	if (cur_phase == MALLOC_PROFILE_PHASES - 1)
+		return;
+
+	phase = &phases[++cur_phase];
+	phase->name = name;
+	phase->start = cur_bytes;
+	phase->peak = cur_bytes;
+}
+
+static int compare_bytes(const void *a, const void *b)
+{
+	const struct malloc_profile_site *sa = &sites[*(const u16 *)a];
+	const struct malloc_profile_site *sb = &sites[*(const u16 *)b];
+
+	return compare3(sb->bytes, sa->bytes);
+}
+
+static int compare_allocs(const void *a, const void *b)
+{
+	const struct malloc_profile_site *sa = &sites[*(const u16 *)a];
+	const struct malloc_profile_site *sb = &sites[*(const u16 *)b];
+
+	return compare3(sb->allocs, sa->allocs);
+}
+
+/**
+ * malloc_profile_print - print the top allocation sites and phases
+ * @num: number of sites to print, 0 for all
+ * @by_allocs: sort by number of allocations instead of bytes in use
+ */
+void malloc_profile_print(unsigned int num, bool by_allocs)
+{
+	struct malloc_profile_site *site;
+	unsigned int i, n = 0;
+	u16 *idx;
+
+	idx = malloc(CONFIG_MALLOC_PROFILE_SITES * sizeof(*idx));
+	if (!idx)
+		return;
+
+	for (i = 0; i < CONFIG_MALLOC_PROFILE_SITES; i++)
+		if (sites[i].allocs || sites[i].live)
+			idx[n++] = i;
+
+	qsort(idx, n, sizeof(*idx), by_allocs ? compare_allocs : compare_bytes);
+
+	if (num)
+		n = min(n, num);
+
+	printf("%10s %10s %8s %10s  %s\n", "bytes", "peak", "live",
+	       "allocs", "site");
+
+	for (i = 0; i < n; i++) {
+		site = &sites[idx[i]];
+		printf("%10zu %10zu %8u %10lu  ", site->bytes, site->peak,
+		       site->live, site->allocs);
+		if (idx[i])
+			printf("%pS\n", (void *)site->caller);
+		else
+			printf("(site table full)\n");
+	}
+
+	free(idx);
+
+	printf("\n%-16s %10s %10s\n", "phase", "start", "peak");
+
+	for (i = 0; i <= cur_phase; i++)
+		printf("%-16s %10zu %10zu\n", phases[i].name,
+		       phases[i].start, phases[i].peak);
+
+	printf("\nin use: %zu bytes, peak: %zu bytes\n", cur_bytes, peak_bytes);
+}
+
+/**
+ * malloc_profile_reset - reset allocation counts and peaks
+ *
+ * Bytes currently in use are kept, so that frees of older allocations
+ * are still accounted correctly.
+ */
+void malloc_profile_reset(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < CONFIG_MALLOC_PROFILE_SITES; i++) {
+		sites[i].allocs = 0;
+		sites[i].peak = sites[i].bytes;
+	}
+
+	for (i = 0; i <= cur_phase; i++)
+		phases[i].peak = phases[i].start = cur_bytes;
+
+	peak_bytes = cur_bytes;
+}
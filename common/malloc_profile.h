@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef __MALLOC_PROFILE_H
+#define __MALLOC_PROFILE_H
+
+#include <linux/types.h>
+
+/* room for the header in front of each profiled allocation */
+#define MALLOC_PROFILE_HDR	8
+
+void *malloc_profile_alloc(void *raw, size_t offset, size_t bytes,
+			   unsigned long caller);
+void *malloc_profile_free(void *mem);
+void *malloc_profile_realloc(void *raw, size_t offset, size_t bytes,
+			     unsigned long caller);
+size_t malloc_profile_offset(const void *mem);
+void malloc_profile_skip(void);
+
+static inline bool malloc_profile_wanted(size_t bytes)
+{
+	if (!IS_ENABLED(CONFIG_MALLOC_PROFILE))
+		return false;
+
+	if (bytes && bytes <= MALLOC_MAX_SIZE)
+		return true;
+
+	malloc_profile_skip();
+
+	return false;
+}
+
+#endif /* __MALLOC_PROFILE_H */
@@ -17,6 +17,9 @@
 #include <memtest.h>
 #include <malloc.h>
 #include <mmu.h>
+#include <offload.h>
+#include <clock.h>
+#include <linux/math64.h>
 
 static int alloc_memtest_region(struct list_head *list,
 		resource_size_t start, resource_size_t size)
@@ -161,6 +164,12 @@ static void mem_test_report_failure(const char *failure_description,
 	       &address);
 }
 
+/*
+ * The bus integrity test deliberately stays with single volatile
+ * accesses: it toggles individual data and address lines and touches
+ * only a few words, so wide accesses would not speed it up but could
+ * hide a stuck line behind a merged or reordered access.
+ */
 int mem_test_bus_integrity(resource_size_t _start,
 			   resource_size_t _end, unsigned int flags)
 {
@@ -344,106 +353,315 @@ int mem_test_bus_integrity(resource_size_t _start,
 	return 0;
 }
 
-static int update_progress(resource_size_t offset, unsigned flags)
+/*
+ * Fast test engine
+ *
+ * Every pass sweeps the whole region once, checking the pattern written
+ * by the previous pass and writing the next one, so N patterns take N
+ * passes instead of 2N. Words are accessed with native width and four at
+ * a time, so the compiler can use paired or wide loads and stores. The
+ * region is processed in chunks that are spread over all CPUs available
+ * for offloading.
+ *
+ * Word i of a pattern holds ((i + 1) * mul) ^ xor. This describes the
+ * address pattern (mul = 1), its inversion (xor = ~0), solid patterns
+ * (mul = 0) and a cheap pseudo random pattern (mul = golden ratio).
+ */
+struct mem_test_pattern {
+	unsigned long mul;
+	unsigned long xor;
+};
+
+#define MEMTEST_GOLDEN		((unsigned long)0x9e3779b97f4a7c15ULL)
+
+static const struct mem_test_pattern mem_test_moving_inversion_patterns[] = {
+	{ .mul = 1, .xor = 0 },
+	{ .mul = 1, .xor = ~0UL },
+	{ .mul = 0, .xor = 0 },
+};
+
+static const struct mem_test_pattern mem_test_extended_patterns[] = {
+	{ .mul = 1, .xor = 0 },
+	{ .mul = 1, .xor = ~0UL },
+	{ .mul = 0, .xor = (unsigned long)0x5555555555555555ULL },
+	{ .mul = 0, .xor = (unsigned long)0xaaaaaaaaaaaaaaaaULL },
+	{ .mul = MEMTEST_GOLDEN, .xor = 0 },
+	{ .mul = MEMTEST_GOLDEN, .xor = ~0UL },
+	{ .mul = 0, .xor = 0 },
+};
+
+#ifdef CONFIG_SELFTEST_MEMTEST
+/* called after each pass, so selftests can inject memory errors */
+void (*mem_test_pass_hook)(unsigned long *words, unsigned long num_words,
+			   unsigned int pass);
+#endif
+
+#define MEMTEST_CHUNK		SZ_1M
+#define MEMTEST_MAX_JOBS	16
+
+struct mem_test_job {
+	struct offload_job job;
+	unsigned long *words;
+	unsigned long first;
+	unsigned long num;
+	const struct mem_test_pattern *check;
+	const struct mem_test_pattern *fill;
+	/* first failing word and the value read from it */
+	unsigned long fail;
+	unsigned long actual;
+};
+
+/*
+ * Check @num words starting at word index @idx against @check and
+ * overwrite them with @fill, either may be NULL. Returns the number of
+ * words processed, which is less than @num if a word didn't match.
+ */
+static __always_inline unsigned long
+__mem_test_kernel(unsigned long *p, unsigned long idx, unsigned long num,
+		  const struct mem_test_pattern *check,
+		  const struct mem_test_pattern *fill, unsigned long *actual)
 {
-	/* Only check every 4k to reduce overhead */
-	if (offset & (SZ_4K - 1))
-		return 0;
+	unsigned long cm = 0, cx = 0, cv = 0;
+	unsigned long fm = 0, fx = 0, fv = 0;
+	unsigned long i = 0, j;
+
+	if (check) {
+		cm = check->mul;
+		cx = check->xor;
+		cv = (idx + 1) * cm;
+	}
 
-	if (ctrlc())
-		return -EINTR;
+	if (fill) {
+		fm = fill->mul;
+		fx = fill->xor;
+		fv = (idx + 1) * fm;
+	}
 
-	if (flags & MEMTEST_VERBOSE)
-		show_progress(offset);
+	for (; i + 4 <= num; i += 4) {
+		if (check) {
+			unsigned long a[4], e[4], diff = 0;
 
-	return 0;
+			for (j = 0; j < 4; j++) {
+				a[j] = p[i + j];
+				e[j] = (cv + j * cm) ^ cx;
+				diff |= a[j] ^ e[j];
+			}
+
+			if (unlikely(diff)) {
+				for (j = 0; a[j] == e[j]; j++)
+					;
+				*actual = a[j];
+				return i + j;
+			}
+
+			cv += 4 * cm;
+		}
+
+		if (fill) {
+			for (j = 0; j < 4; j++)
+				p[i + j] = (fv + j * fm) ^ fx;
+
+			fv += 4 * fm;
+		}
+	}
+
+	for (; i < num; i++) {
+		if (check) {
+			*actual = p[i];
+			if (*actual != (cv ^ cx))
+				return i;
+			cv += cm;
+		}
+
+		if (fill) {
+			p[i] = fv ^ fx;
+			fv += fm;
+		}
+	}
+
+	return num;
 }
 
-int mem_test_moving_inversions(resource_size_t _start, resource_size_t _end,
-			       unsigned flags)
+/* one specialized copy per pass type, so the loop carries no branches */
+static noinline unsigned long
+mem_test_fill(unsigned long *p, unsigned long idx, unsigned long num,
+	      const struct mem_test_pattern *fill, unsigned long *actual)
 {
-	volatile resource_size_t *start, num_words, offset, temp, anti_pattern;
-	int ret;
+	return __mem_test_kernel(p, idx, num, NULL, fill, actual);
+}
 
-	_start = ALIGN(_start, sizeof(resource_size_t));
-	_end = ALIGN_DOWN(_end, sizeof(resource_size_t)) - 1;
+static noinline unsigned long
+mem_test_check_fill(unsigned long *p, unsigned long idx, unsigned long num,
+		    const struct mem_test_pattern *check,
+		    const struct mem_test_pattern *fill, unsigned long *actual)
+{
+	return __mem_test_kernel(p, idx, num, check, fill, actual);
+}
 
-	if (_end <= _start)
-		return -EINVAL;
+static int mem_test_job_fn(struct offload_job *job)
+{
+	struct mem_test_job *mj = container_of(job, struct mem_test_job, job);
+	unsigned long *p = mj->words + mj->first;
 
-	start = (resource_size_t *)_start;
-	num_words = (_end - _start + 1)/sizeof(resource_size_t);
+	if (mj->check)
+		mj->fail = mem_test_check_fill(p, mj->first, mj->num, mj->check,
+					       mj->fill, &mj->actual);
+	else
+		mj->fail = mem_test_fill(p, mj->first, mj->num, mj->fill,
+					 &mj->actual);
 
-	if (flags & MEMTEST_VERBOSE) {
-		printf("Starting moving inversions test of RAM:\n"
-		       "Fill with address, compare, fill with inverted address, compare again\n");
+	if (mj->fail == mj->num)
+		return 0;
 
-		init_progression_bar(3 * num_words);
-	}
+	mj->fail += mj->first;
 
-	/*
-	 * Description: Test the integrity of a physical
-	 *		memory device by performing an
-	 *		increment/decrement test over the
-	 *		entire region. In the process every
-	 *		storage bit in the device is tested
-	 *		as a zero and a one. The base address
-	 *		and the size of the region are
-	 *		selected by the caller.
-	 */
+	return -EIO;
+}
 
-	/* Fill memory with a known pattern */
-	for (offset = 0; offset < num_words; offset++) {
-		ret = update_progress(offset, flags);
-		if (ret)
-			return ret;
-		start[offset] = offset + 1;
-	}
+static int mem_test_pass(unsigned long *words, unsigned long num_words,
+			 const struct mem_test_pattern *check,
+			 const struct mem_test_pattern *fill,
+			 loff_t progress, unsigned flags)
+{
+	struct mem_test_job jobs[MEMTEST_MAX_JOBS];
+	unsigned long chunk = MEMTEST_CHUNK / sizeof(unsigned long);
+	unsigned long idx = 0;
+	unsigned int i, njobs = 1;
+	int ret;
 
-	/* Check each location and invert it for the second pass */
-	for (offset = 0; offset < num_words; offset++) {
-		ret = update_progress(num_words + offset, flags);
-		if (ret)
-			return ret;
+	if (flags & MEMTEST_OFFLOAD)
+		njobs = clamp_t(unsigned int, offload_num_cpus(), 1,
+				MEMTEST_MAX_JOBS);
+
+	while (idx < num_words) {
+		for (i = 0; i < njobs && idx < num_words; i++) {
+			struct mem_test_job *mj = &jobs[i];
+
+			mj->words = words;
+			mj->first = idx;
+			mj->num = min(chunk, num_words - idx);
+			mj->check = check;
+			mj->fill = fill;
+			idx += mj->num;
+
+			offload_job_init(&mj->job, mem_test_job_fn);
+			if (flags & MEMTEST_OFFLOAD)
+				offload_job_submit(&mj->job);
+			else
+				mj->job.ret = mem_test_job_fn(&mj->job);
+		}
+
+		ret = 0;
+
+		while (i--) {
+			struct mem_test_job *mj = &jobs[i];
+
+			if (flags & MEMTEST_OFFLOAD)
+				offload_job_wait(&mj->job);
+
+			if (!mj->job.ret)
+				continue;
 
-		temp = start[offset];
-		if (temp != (offset + 1)) {
 			printf("\n");
 			mem_test_report_failure("read/write",
-						(offset + 1),
-						temp, &start[offset]);
-			return -EIO;
+				(mj->fail + 1) * check->mul ^ check->xor,
+				mj->actual, (resource_size_t *)&words[mj->fail]);
+			ret = -EIO;
 		}
 
-		anti_pattern = ~(offset + 1);
-		start[offset] = anti_pattern;
-	}
-
-	/* Check each location for the inverted pattern and zero it */
-	for (offset = 0; offset < num_words; offset++) {
-		ret = update_progress(2 * num_words + offset, flags);
 		if (ret)
 			return ret;
 
-		anti_pattern = ~(offset + 1);
-		temp = start[offset];
+		if (ctrlc())
+			return -EINTR;
 
-		if (temp != anti_pattern) {
-			printf("\n");
-			mem_test_report_failure("read/write",
-						anti_pattern,
-						temp, &start[offset]);
-			return -EIO;
-		}
+		if (flags & MEMTEST_VERBOSE)
+			show_progress(progress + idx);
+	}
+
+	return 0;
+}
+
+static int mem_test_patterns(resource_size_t _start, resource_size_t _end,
+			     const struct mem_test_pattern *patterns,
+			     unsigned int num_patterns, unsigned flags)
+{
+	unsigned long *words, num_words;
+	unsigned int i;
+	u64 start_ns, ns, bytes;
+	int ret;
+
+	_start = ALIGN(_start, sizeof(unsigned long));
+	_end = ALIGN_DOWN(_end + 1, sizeof(unsigned long));
+
+	if (_end <= _start)
+		return -EINVAL;
+
+	words = (unsigned long *)(uintptr_t)_start;
+	num_words = (_end - _start) / sizeof(unsigned long);
+
+	if (flags & MEMTEST_VERBOSE)
+		init_progression_bar((loff_t)num_patterns * num_words);
+
+	start_ns = get_time_ns();
 
-		start[offset] = 0;
+	for (i = 0; i < num_patterns; i++) {
+		/* make the compiler forget what the previous pass wrote */
+		barrier();
+
+		ret = mem_test_pass(words, num_words,
+				    i ? &patterns[i - 1] : NULL, &patterns[i],
+				    (loff_t)i * num_words, flags);
+		if (ret)
+			return ret;
+
+		if (IS_ENABLED(CONFIG_SELFTEST_MEMTEST) && mem_test_pass_hook)
+			mem_test_pass_hook(words, num_words, i);
 	}
+
 	if (flags & MEMTEST_VERBOSE) {
-		show_progress(3 * num_words);
+		ns = get_time_ns() - start_ns;
+		/* the first pass only writes, all others read and write */
+		bytes = (u64)(2 * num_patterns - 1) * num_words * sizeof(unsigned long);
 
 		/* end of progressbar */
-		printf("\n");
+		printf("\n%u patterns in %llu ms, %llu MiB/s\n", num_patterns,
+		       div_u64(ns, MSECOND), div64_u64(bytes * 1000, ns ?: 1) *
+		       (NSEC_PER_SEC / 1000) >> 20);
 	}
 
 	return 0;
 }
+
+int mem_test_moving_inversions(resource_size_t _start, resource_size_t _end,
+			       unsigned flags)
+{
+	if (flags & MEMTEST_VERBOSE) {
+		if (flags & MEMTEST_EXTENDED)
+			printf("Starting extended pattern test of RAM:\n"
+			       "Address, inverted address, checkerboard and pseudo random patterns,\n"
+			       "each pass checks the previous pattern and writes the next\n");
+		else
+			printf("Starting moving inversions test of RAM:\n"
+			       "Fill with address, compare, fill with inverted address, compare again\n");
+	}
+
+	/*
+	 * Description: Test the integrity of a physical
+	 *		memory device by performing an
+	 *		increment/decrement test over the
+	 *		entire region. In the process every
+	 *		storage bit in the device is tested
+	 *		as a zero and a one. The base address
+	 *		and the size of the region are
+	 *		selected by the caller.
+	 */
+	if (flags & MEMTEST_EXTENDED)
+		return mem_test_patterns(_start, _end, mem_test_extended_patterns,
+					 ARRAY_SIZE(mem_test_extended_patterns),
+					 flags);
+
+	return mem_test_patterns(_start, _end, mem_test_moving_inversion_patterns,
+				 ARRAY_SIZE(mem_test_moving_inversion_patterns),
+				 flags);
+}
@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Minimal work offload to secondary CPUs
+ *
+ * Secondary CPUs brought up by the architecture code sit in
+ * offload_cpu_main() and wait for a job to appear in their mailbox.
+ * The boot CPU hands out jobs to idle CPUs and runs a job itself
+ * when all secondaries are busy, so submitting N jobs and waiting
+ * for them always makes progress, even without any secondary CPU.
+ */
+
+#include <common.h>
+#include <offload.h>
+#include <sched.h>
+#include <asm/barrier.h>
+#include <asm/offload.h>
+#include <linux/sizes.h>
+
+static LIST_HEAD(offload_cpus);
+static unsigned int num_offload_cpus;
+
+/**
+ * offload_num_cpus - number of CPUs jobs are distributed over
+ *
+ * Return: number of parked secondary CPUs plus one for the boot CPU.
+ * Callers splitting work into chunks should use this as chunk count.
+ */
+unsigned int offload_num_cpus(void)
+{
+	return num_offload_cpus + 1;
+}
+
+static void offload_job_complete(struct offload_job *job)
+{
+	job->ret = job->fn(job);
+	offload_mb();
+	WRITE_ONCE(job->done, true);
+}
+
+/**
+ * offload_job_submit - start a job on an idle secondary CPU
+ * @job: the job, initialized with offload_job_init()
+ *
+ * If no secondary CPU is idle, the job is run synchronously on the
+ * calling CPU before this function returns.
+ */
+void offload_job_submit(struct offload_job *job)
+{
+	struct offload_cpu *cpu;
+
+	job->done = false;
+
+	list_for_each_entry(cpu, &offload_cpus, list) {
+		if (READ_ONCE(cpu->job))
+			continue;
+
+		offload_mb();
+		WRITE_ONCE(cpu->job, job);
+		offload_cpu_kick();
+		return;
+	}
+
+	offload_job_complete(job);
+}
+
+/**
+ * offload_job_wait - wait for a submitted job to finish
+ * @job: the job
+ *
+ * Return: the return value of the job function
+ */
+int offload_job_wait(struct offload_job *job)
+{
+	while (!READ_ONCE(job->done))
+		resched();
+
+	offload_mb();
+
+	return job->ret;
+}
+
+/**
+ * offload_cpu_main - job loop run by a secondary CPU
+ * @cpu: the CPU's mailbox
+ *
+ * Called by the architecture code on the secondary CPU once it runs
+ * with the boot CPU's MMU and exception setup. Returns when
+ * offload_cpus_stop() is called, after which the architecture code
+ * should power the CPU down.
+ */
+void offload_cpu_main(struct offload_cpu *cpu)
+{
+	struct offload_job *job;
+
+	WRITE_ONCE(cpu->running, true);
+	offload_cpu_kick();
+
+	for (;;) {
+		job = READ_ONCE(cpu->job);
+		if (job) {
+			offload_mb();
+			offload_job_complete(job);
+			WRITE_ONCE(cpu->job, NULL);
+			offload_cpu_kick();
+			continue;
+		}
+
+		if (READ_ONCE(cpu->stop))
+			break;
+
+		offload_cpu_idle();
+	}
+
+	offload_mb();
+	WRITE_ONCE(cpu->running, false);
+	offload_cpu_kick();
+}
+
+/**
+ * offload_cpu_register - make a started secondary CPU available for jobs
+ * @cpu: the CPU's mailbox, already executing offload_cpu_main()
+ */
+void offload_cpu_register(struct offload_cpu *cpu)
+{
+	list_add_tail(&cpu->list, &offload_cpus);
+	num_offload_cpus++;
+}
+
+/**
+ * offload_cpus_stop - make all secondary CPUs leave offload_cpu_main()
+ *
+ * Waits for running jobs to finish. Must be called before the boot CPU
+ * tears down the MMU and before handing over to the next stage.
+ */
+void offload_cpus_stop(void)
+{
+	struct offload_cpu *cpu, *tmp;
+
+	list_for_each_entry(cpu, &offload_cpus, list)
+		WRITE_ONCE(cpu->stop, true);
+
+	offload_cpu_kick();
+
+	list_for_each_entry_safe(cpu, tmp, &offload_cpus, list) {
+		while (READ_ONCE(cpu->running))
+			offload_cpu_idle();
+
+		list_del(&cpu->list);
+		num_offload_cpus--;
+	}
+}
+
+static int offload_digest_fn(struct offload_job *job)
+{
+	struct offload_digest_job *dj =
+		container_of(job, struct offload_digest_job, job);
+
+	return digest_digest(dj->d, dj->buf, dj->len, dj->out);
+}
+
+/**
+ * offload_digest_submit - hash a buffer on a secondary CPU
+ * @dj: description of the hash operation
+ *
+ * Use offload_job_wait(&dj->job) to wait for the result.
+ */
+void offload_digest_submit(struct offload_digest_job *dj)
+{
+	offload_job_init(&dj->job, offload_digest_fn);
+	offload_job_submit(&dj->job);
+}
+
+struct offload_memset_job {
+	struct offload_job job;
+	void *s;
+	int c;
+	size_t n;
+};
+
+static int offload_memset_fn(struct offload_job *job)
+{
+	struct offload_memset_job *mj =
+		container_of(job, struct offload_memset_job, job);
+
+	memset(mj->s, mj->c, mj->n);
+
+	return 0;
+}
+
+#define OFFLOAD_MAX_CHUNKS	16
+
+/**
+ * offload_memset - memset() spread over all CPUs
+ * @s: start of the region
+ * @c: fill byte
+ * @n: size of the region
+ *
+ * Only worth it for regions of several megabytes; smaller regions are
+ * cleared by the calling CPU alone.
+ */
+void offload_memset(void *s, int c, size_t n)
+{
+	struct offload_memset_job jobs[OFFLOAD_MAX_CHUNKS];
+	unsigned int i, nchunks;
+	size_t chunk;
+
+	nchunks = min_t(unsigned int, offload_num_cpus(), OFFLOAD_MAX_CHUNKS);
+	if (nchunks == 1 || n < SZ_1M) {
+		memset(s, c, n);
+		return;
+	}
+
+	chunk = ALIGN(DIV_ROUND_UP(n, nchunks), SZ_4K);
+
+	for (i = 0; i < nchunks && n; i++) {
+		jobs[i].s = s;
+		jobs[i].c = c;
+		jobs[i].n = min(chunk, n);
+
+		s += jobs[i].n;
+		n -= jobs[i].n;
+
+		offload_job_init(&jobs[i].job, offload_memset_fn);
+		offload_job_submit(&jobs[i].job);
+	}
+
+	nchunks = i;
+
+	for (i = 0; i < nchunks; i++)
+		offload_job_wait(&jobs[i].job);
+}
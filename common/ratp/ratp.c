@@ -155,6 +155,8 @@ static int console_send(struct ratp *r, void *pkt, int len)
 	if (!console_exists(cdev))
 		return -ENODEV;
 
+	console_tx_flush(cdev);
+
 	for (i = 0; i < len; i++)
 		cdev->putc(cdev, buf[i]);
 
@@ -45,6 +45,8 @@
 #include <pbl/handoff-data.h>
 #include <libfile.h>
 #include <fuzz.h>
+#include <bootprofile.h>
+#include <deep-probe.h>
 
 extern initcall_t __barebox_initcalls_start[], __barebox_early_initcalls_end[],
 		  __barebox_initcalls_end[];
@@ -362,6 +364,8 @@ static int run_init(void)
 	if (autoboot == AUTOBOOT_BOOT)
 		run_command("boot");
 
+	deep_probe_complete();
+
 	if (IS_ENABLED(CONFIG_NET) && !IS_ENABLED(CONFIG_CONSOLE_DISABLE_INPUT) &&
 	    autoboot != AUTOBOOT_HALT)
 		eth_open_all();
@@ -405,13 +409,18 @@ void __noreturn start_barebox(void)
 {
 	initcall_t *initcall;
 	int result;
+	u64 start;
 
 	do_ctors();
 
+	malloc_profile_phase("initcalls");
+
 	for (initcall = __barebox_initcalls_start;
 			initcall < __barebox_initcalls_end; initcall++) {
 		pr_debug("initcall-> %pS\n", *initcall);
+		start = bootprofile_start();
 		result = (*initcall)();
+		bootprofile_initcall(*initcall, start, result);
 		if (result)
 			pr_err("initcall %pS failed: %pe\n", *initcall,
 					ERR_PTR(result));
@@ -420,6 +429,8 @@ void __noreturn start_barebox(void)
 	barebox_system_state = BAREBOX_RUNNING;
 	pr_debug("initcalls done\n");
 
+	malloc_profile_phase("running");
+
 
 	if (IS_ENABLED(CONFIG_SELFTEST_AUTORUN))
 		selftests_run();
@@ -427,6 +438,8 @@ void __noreturn start_barebox(void)
 	if (barebox_main)
 		barebox_main();
 
+	deep_probe_complete();
+
 	if (IS_ENABLED(CONFIG_SHELL_NONE)) {
 		pr_err("Nothing left to do\n");
 		hang();
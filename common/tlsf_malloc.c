@@ -16,6 +16,10 @@
 
 #include <linux/kasan.h>
 #include <linux/list.h>
+#include <linux/instruction_pointer.h>
+
+#include "tlsf_slab.h"
+#include "malloc_profile.h"
 
 tlsf_t tlsf_mem_pool;
 static void (*malloc_request_store)(size_t bytes);
@@ -32,11 +36,45 @@ static inline size_t mem_pool_overhead(void)
 	return sizeof(struct pool_entry) + tlsf_pool_overhead();
 }
 
+static void *heap_malloc(size_t bytes)
+{
+	void *mem;
+
+	mem = slab_malloc(bytes);
+	if (!mem)
+		mem = tlsf_malloc(tlsf_mem_pool, bytes);
+
+	return mem;
+}
+
+static void heap_free(void *mem)
+{
+	if (!slab_free(mem))
+		tlsf_free(tlsf_mem_pool, mem);
+}
+
+static size_t heap_usable_size(void *mem)
+{
+	return slab_usable_size(mem) ?: tlsf_block_size(mem);
+}
+
+static void *heap_realloc(void *oldmem, size_t bytes)
+{
+	if (slab_usable_size(oldmem))
+		return slab_realloc(oldmem, bytes);
+
+	return tlsf_realloc(tlsf_mem_pool, oldmem, bytes);
+}
+
 void *malloc(size_t bytes)
 {
 	void *mem;
 
-	mem = tlsf_malloc(tlsf_mem_pool, bytes);
+	if (malloc_profile_wanted(bytes))
+		mem = malloc_profile_alloc(heap_malloc(bytes + MALLOC_PROFILE_HDR),
+					   MALLOC_PROFILE_HDR, bytes, _RET_IP_);
+	else
+		mem = heap_malloc(bytes);
 	if (!mem)
 		errno = ENOMEM;
 
@@ -46,19 +84,50 @@ EXPORT_SYMBOL(malloc);
 
 void free(void *mem)
 {
-	tlsf_free(tlsf_mem_pool, mem);
+	if (IS_ENABLED(CONFIG_MALLOC_PROFILE) && !ZERO_OR_NULL_PTR(mem)) {
+		mem = malloc_profile_free(mem);
+		if (!mem)
+			return;
+	}
+
+	heap_free(mem);
 }
 EXPORT_SYMBOL(free);
 
 size_t malloc_usable_size(void *mem)
 {
-	return tlsf_block_size(mem);
+	size_t offset;
+
+	if (!IS_ENABLED(CONFIG_MALLOC_PROFILE) || ZERO_OR_NULL_PTR(mem))
+		return heap_usable_size(mem);
+
+	offset = malloc_profile_offset(mem);
+
+	return heap_usable_size(mem - offset) - offset;
 }
 EXPORT_SYMBOL(malloc_usable_size);
 
 void *realloc(void *oldmem, size_t bytes)
 {
-	void *mem = tlsf_realloc(tlsf_mem_pool, oldmem, bytes);
+	size_t offset;
+	void *mem;
+
+	if (ZERO_OR_NULL_PTR(oldmem))
+		return malloc(bytes);
+
+	if (!IS_ENABLED(CONFIG_MALLOC_PROFILE)) {
+		mem = heap_realloc(oldmem, bytes);
+	} else if (!bytes) {
+		malloc_profile_skip();
+		free(oldmem);
+		return ZERO_SIZE_PTR;
+	} else if (malloc_profile_wanted(bytes)) {
+		offset = malloc_profile_offset(oldmem);
+		mem = malloc_profile_realloc(heap_realloc(oldmem - offset, bytes + offset),
+					     offset, bytes, _RET_IP_);
+	} else {
+		mem = NULL;
+	}
 	if (!mem)
 		errno = ENOMEM;
 
@@ -68,7 +137,17 @@ EXPORT_SYMBOL(realloc);
 
 void *memalign(size_t alignment, size_t bytes)
 {
-	void *mem = tlsf_memalign(tlsf_mem_pool, alignment, bytes);
+	size_t offset;
+	void *mem;
+
+	if (malloc_profile_wanted(bytes)) {
+		offset = max_t(size_t, alignment, MALLOC_PROFILE_HDR);
+		mem = malloc_profile_alloc(tlsf_memalign(tlsf_mem_pool, alignment,
+							 bytes + offset),
+					   offset, bytes, _RET_IP_);
+	} else {
+		mem = tlsf_memalign(tlsf_mem_pool, alignment, bytes);
+	}
 	if (!mem)
 		errno = ENOMEM;
 
@@ -103,6 +182,8 @@ void malloc_stats(void)
 		tlsf_walk_pool(cur_pool->pool, malloc_walker, &s);
 
 	printf("used: %zu\nfree: %zu\n", s.used, s.free);
+
+	slab_stats();
 }
 
 void *malloc_add_pool(void *mem, size_t bytes)
@@ -0,0 +1,299 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Slab caches for small allocations on top of tlsf
+ *
+ * Small allocations are served from a cache per size class. A cache
+ * consists of slabs, which are blocks allocated from tlsf and cut into
+ * objects of the same size. Allocating and freeing an object only pops
+ * it from or pushes it to the free list of its slab, and grouping small
+ * objects into slabs keeps them from fragmenting the tlsf heap.
+ *
+ * Each object is preceded by a header word at the place where tlsf keeps
+ * its block size. Bit 0 of that word is the tlsf free bit, which is never
+ * set in front of memory handed out by tlsf, so it's used to tell slab
+ * objects from tlsf blocks. The remaining bits store whether the object
+ * is free and its offset to the start of its slab.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <string.h>
+#include <tlsf.h>
+#include <linux/kasan.h>
+#include <linux/list.h>
+#include <linux/sizes.h>
+
+#include "tlsf_slab.h"
+
+#define SLAB_SIZE		SZ_8K
+#define SLAB_OBJ_HDR		8
+
+#define SLAB_OBJ_MAGIC		BIT(0)
+#define SLAB_OBJ_FREE		BIT(1)
+#define SLAB_OBJ_OFFSET_SHIFT	2
+
+struct slab_cache {
+	size_t size;
+	struct list_head partial;
+	unsigned int nr_slabs;
+	unsigned int inuse;
+	unsigned long allocs;
+};
+
+struct slab {
+	struct list_head list;
+	struct slab_cache *cache;
+	void *freelist;
+	unsigned int inuse;
+};
+
+#define SLAB_CACHE(i, sz) [i] = {					\
+	.size = sz,							\
+	.partial = LIST_HEAD_INIT(slab_caches[i].partial),		\
+}
+
+static struct slab_cache slab_caches[] = {
+	SLAB_CACHE(0, 16),
+	SLAB_CACHE(1, 32),
+	SLAB_CACHE(2, 48),
+	SLAB_CACHE(3, 64),
+	SLAB_CACHE(4, 96),
+	SLAB_CACHE(5, 128),
+	SLAB_CACHE(6, 192),
+	SLAB_CACHE(7, 256),
+	SLAB_CACHE(8, 384),
+	SLAB_CACHE(9, 512),
+};
+
+static struct slab_cache *slab_cache_for(size_t bytes)
+{
+	int i;
+
+	if (!bytes || bytes > slab_caches[ARRAY_SIZE(slab_caches) - 1].size)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(slab_caches); i++)
+		if (bytes <= slab_caches[i].size)
+			return &slab_caches[i];
+
+	return NULL;
+}
+
+/*
+ * tlsf keeps the block size 8 bytes in front of the memory it hands
+ * out. On 32-bit, the word right in front of the memory is uninitialized
+ * padding, so the header is at the start of the SLAB_OBJ_HDR area.
+ */
+static inline size_t *slab_obj_hdr(const void *obj)
+{
+	return (size_t *)(obj - SLAB_OBJ_HDR);
+}
+
+static struct slab *slab_of(void *obj)
+{
+	size_t hdr;
+
+	if (ZERO_OR_NULL_PTR(obj))
+		return NULL;
+
+	hdr = *slab_obj_hdr(obj);
+	if (!(hdr & SLAB_OBJ_MAGIC))
+		return NULL;
+
+	return obj - (hdr >> SLAB_OBJ_OFFSET_SHIFT);
+}
+
+static struct slab *slab_new(struct slab_cache *cache)
+{
+	size_t stride = cache->size + SLAB_OBJ_HDR;
+	void *obj, *first, *end;
+	struct slab *slab;
+	void **link;
+
+	slab = tlsf_malloc(tlsf_mem_pool, SLAB_SIZE);
+	if (!slab)
+		return NULL;
+
+	slab->cache = cache;
+	slab->inuse = 0;
+
+	first = (void *)slab + ALIGN(sizeof(*slab), SLAB_OBJ_HDR) + SLAB_OBJ_HDR;
+	end = (void *)slab + SLAB_SIZE;
+
+	link = &slab->freelist;
+	for (obj = first; obj + cache->size <= end; obj += stride) {
+		*slab_obj_hdr(obj) = ((obj - (void *)slab) << SLAB_OBJ_OFFSET_SHIFT) |
+				     SLAB_OBJ_MAGIC | SLAB_OBJ_FREE;
+		*link = obj;
+		link = obj;
+	}
+	*link = NULL;
+
+	kasan_poison_shadow(first - SLAB_OBJ_HDR, end - first + SLAB_OBJ_HDR,
+			    KASAN_KMALLOC_FREE);
+
+	cache->nr_slabs++;
+
+	return slab;
+}
+
+/**
+ * slab_malloc - allocate a small object
+ * @bytes: size of the object
+ *
+ * Return: the object, or NULL if @bytes is not served by a slab cache or
+ * no new slab could be allocated. The caller should fall back to tlsf then.
+ */
+void *slab_malloc(size_t bytes)
+{
+	struct slab_cache *cache = slab_cache_for(bytes);
+	struct slab *slab;
+	void *obj;
+
+	if (!cache)
+		return NULL;
+
+	if (list_empty(&cache->partial)) {
+		slab = slab_new(cache);
+		if (!slab)
+			return NULL;
+		list_add(&slab->list, &cache->partial);
+	} else {
+		slab = list_first_entry(&cache->partial, struct slab, list);
+	}
+
+	obj = slab->freelist;
+	slab->freelist = *(void **)obj;
+	if (!slab->freelist)
+		list_del(&slab->list);
+
+	*slab_obj_hdr(obj) &= ~SLAB_OBJ_FREE;
+
+	slab->inuse++;
+	cache->inuse++;
+	cache->allocs++;
+
+	if (want_init_on_alloc()) {
+		kasan_unpoison_shadow(obj, cache->size);
+		memset(obj, 0, cache->size);
+	}
+
+	kasan_poison_shadow(obj, cache->size, KASAN_KMALLOC_REDZONE);
+	kasan_unpoison_shadow(obj, bytes);
+
+	return obj;
+}
+
+/**
+ * slab_free - free a small object
+ * @mem: the object
+ *
+ * Return: true if @mem was a slab object, false if it's to be freed by tlsf
+ */
+bool slab_free(void *mem)
+{
+	struct slab *slab = slab_of(mem);
+	struct slab_cache *cache;
+	size_t *hdr;
+
+	if (!slab)
+		return false;
+
+	hdr = slab_obj_hdr(mem);
+	tlsf_assert(!(*hdr & SLAB_OBJ_FREE) && "object already marked as free");
+	if (*hdr & SLAB_OBJ_FREE)
+		return true;
+
+	cache = slab->cache;
+
+	if (want_init_on_free()) {
+		kasan_unpoison_shadow(mem, cache->size);
+		memzero_explicit(mem, cache->size);
+	}
+	kasan_poison_shadow(mem, cache->size, KASAN_KMALLOC_FREE);
+
+	*hdr |= SLAB_OBJ_FREE;
+
+	if (!slab->freelist)
+		list_add(&slab->list, &cache->partial);
+
+	*(void **)mem = slab->freelist;
+	slab->freelist = mem;
+
+	slab->inuse--;
+	cache->inuse--;
+
+	/* keep a single empty slab around to avoid thrashing */
+	if (!slab->inuse && !list_is_singular(&cache->partial)) {
+		list_del(&slab->list);
+		cache->nr_slabs--;
+		tlsf_free(tlsf_mem_pool, slab);
+	}
+
+	return true;
+}
+
+/**
+ * slab_realloc - resize a slab object
+ * @mem: the object, must be a slab object
+ * @bytes: the new size
+ *
+ * The object is kept in place when it's shrunk or grown within its
+ * size class, otherwise it's moved to another size class or to tlsf.
+ */
+void *slab_realloc(void *mem, size_t bytes)
+{
+	struct slab_cache *cache = slab_of(mem)->cache;
+	void *p;
+
+	if (!bytes) {
+		slab_free(mem);
+		return ZERO_SIZE_PTR;
+	}
+
+	if (bytes <= cache->size) {
+		kasan_poison_shadow(mem, cache->size, KASAN_KMALLOC_REDZONE);
+		kasan_unpoison_shadow(mem, bytes);
+		return mem;
+	}
+
+	p = slab_malloc(bytes);
+	if (!p)
+		p = tlsf_malloc(tlsf_mem_pool, bytes);
+	if (!p)
+		return NULL;
+
+	kasan_unpoison_shadow(mem, cache->size);
+	memcpy(p, mem, cache->size);
+
+	slab_free(mem);
+
+	return p;
+}
+
+/**
+ * slab_usable_size - get the usable size of a slab object
+ * @mem: the object
+ *
+ * Return: the size of the object's class or 0 if @mem is no slab object
+ */
+size_t slab_usable_size(void *mem)
+{
+	struct slab *slab = slab_of(mem);
+
+	return slab ? slab->cache->size : 0;
+}
+
+void slab_stats(void)
+{
+	struct slab_cache *cache;
+	int i;
+
+	printf("slab    inuse    slabs        allocs\n");
+
+	for (i = 0; i < ARRAY_SIZE(slab_caches); i++) {
+		cache = &slab_caches[i];
+		printf("%4zu %8u %8u %13lu\n", cache->size, cache->inuse,
+		       cache->nr_slabs, cache->allocs);
+	}
+}
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef __TLSF_SLAB_H
+#define __TLSF_SLAB_H
+
+#include <linux/types.h>
+#include <tlsf.h>
+
+extern tlsf_t tlsf_mem_pool;
+
+#ifdef CONFIG_MALLOC_TLSF_SLAB
+void *slab_malloc(size_t bytes);
+bool slab_free(void *mem);
+void *slab_realloc(void *mem, size_t bytes);
+size_t slab_usable_size(void *mem);
+void slab_stats(void);
+#else
+static inline void *slab_malloc(size_t bytes)
+{
+	return NULL;
+}
+
+static inline bool slab_free(void *mem)
+{
+	return false;
+}
+
+static inline void *slab_realloc(void *mem, size_t bytes)
+{
+	return NULL;
+}
+
+static inline size_t slab_usable_size(void *mem)
+{
+	return 0;
+}
+
+static inline void slab_stats(void)
+{
+}
+#endif
+
+#endif /* __TLSF_SLAB_H */
@@ -22,7 +22,17 @@
 #define STATIC static inline
 #endif
 
-static uint32_t crc_table[sizeof(uint32_t) * 256];
+/*
+ * Slice-by-8 needs eight 1K tables. The PBL is often running from a small
+ * SRAM, so stay with a single table there and go byte by byte.
+ */
+#ifdef __PBL__
+#define CRC32_SLICES	1
+#else
+#define CRC32_SLICES	8
+#endif
+
+static uint32_t crc_table[CRC32_SLICES][256];
 
 /*
   Generate a table for a byte-wise 32-bit CRC calculation on the polynomial:
@@ -47,6 +57,10 @@ static uint32_t crc_table[sizeof(uint32_t) * 256];
   The table is simply the CRC of all possible eight bit values.  This is all
   the information needed to generate CRC's on data a byte at a time for all
   combinations of CRC register values and incoming bytes.
+
+  The additional tables crc_table[k] hold the CRC of a byte followed by k
+  zero bytes, which allows processing eight bytes with eight independent
+  table lookups (slice-by-8).
 */
 static void make_crc_table(void)
 {
@@ -56,7 +70,7 @@ static void make_crc_table(void)
 	/* terms of polynomial defining this crc (except x^32): */
 	static const char p[] = { 0, 1, 2, 4, 5, 7, 8, 10, 11, 12, 16, 22, 23, 26 };
 
-	if (crc_table[1])
+	if (crc_table[0][1])
 		return;
 
 	/* make exclusive-or pattern from polynomial (0xedb88320L) */
@@ -68,28 +82,47 @@ static void make_crc_table(void)
 		c = (uint32_t) n;
 		for (k = 0; k < 8; k++)
 			c = c & 1 ? poly ^ (c >> 1) : c >> 1;
-		crc_table[n] = c;
+		crc_table[0][n] = c;
+	}
+
+	for (n = 0; n < 256; n++) {
+		c = crc_table[0][n];
+		for (k = 1; k < CRC32_SLICES; k++) {
+			c = crc_table[0][c & 0xff] ^ (c >> 8);
+			crc_table[k][n] = c;
+		}
 	}
 }
 
-#define DO1(buf) crc = crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-#define DO2(buf)  DO1(buf); DO1(buf);
-#define DO4(buf)  DO2(buf); DO2(buf);
-#define DO8(buf)  DO4(buf); DO4(buf);
+#define DO1(buf) crc = crc_table[0][((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
 
-/* No ones complement version. JFFS2 (and other things ?)
- * don't use ones compliment in their CRC calculations.
- */
-STATIC uint32_t crc32_no_comp(uint32_t crc, const void *_buf, unsigned int len)
+/* Assemble the word byte by byte, so this works regardless of host endianness */
+#define LE32(buf) ((uint32_t)(buf)[0] | (uint32_t)(buf)[1] << 8 | \
+		   (uint32_t)(buf)[2] << 16 | (uint32_t)(buf)[3] << 24)
+
+STATIC uint32_t crc32_le_base(uint32_t crc, const void *_buf, unsigned int len)
 {
 	const unsigned char *buf = _buf;
 
 	make_crc_table();
 
+#if CRC32_SLICES == 8
 	while (len >= 8) {
-		DO8(buf);
+		uint32_t one = crc ^ LE32(buf);
+		uint32_t two = LE32(buf + 4);
+
+		crc = crc_table[7][one & 0xff] ^
+		      crc_table[6][(one >> 8) & 0xff] ^
+		      crc_table[5][(one >> 16) & 0xff] ^
+		      crc_table[4][one >> 24] ^
+		      crc_table[3][two & 0xff] ^
+		      crc_table[2][(two >> 8) & 0xff] ^
+		      crc_table[1][(two >> 16) & 0xff] ^
+		      crc_table[0][two >> 24];
+		buf += 8;
 		len -= 8;
 	}
+#endif
 	if (len)
 		do {
 			DO1(buf);
@@ -98,6 +131,28 @@ STATIC uint32_t crc32_no_comp(uint32_t crc, const void *_buf, unsigned int len)
 	return crc;
 }
 
+#if defined(__BAREBOX__) && !defined(__PBL__)
+/*
+ * Architectures with CRC32 instructions override this. The override must
+ * check whether the CPU supports them and fall back to crc32_le_base()
+ * otherwise.
+ */
+uint32_t __weak crc32_le_arch(uint32_t crc, const void *buf, unsigned int len)
+{
+	return crc32_le_base(crc, buf, len);
+}
+#else
+#define crc32_le_arch crc32_le_base
+#endif
+
+/* No ones complement version. JFFS2 (and other things ?)
+ * don't use ones compliment in their CRC calculations.
+ */
+STATIC uint32_t crc32_no_comp(uint32_t crc, const void *buf, unsigned int len)
+{
+	return crc32_le_arch(crc, buf, len);
+}
+
 STATIC uint32_t crc32(uint32_t crc, const void *buf, unsigned int len)
 {
 	return ~crc32_no_comp(~crc, buf, len);
@@ -24,6 +24,7 @@
 #include <linux/err.h>
 #include <crypto.h>
 #include <crypto/internal.h>
+#include <bootprofile.h>
 
 static LIST_HEAD(digests);
 
@@ -262,6 +263,7 @@ int digest_file_window(struct digest *d, const char *filename,
 		       const unsigned char *sig,
 		       loff_t start, loff_t size)
 {
+	u64 time = bootprofile_start();
 	int fd, ret;
 
 	ret = digest_init(d);
@@ -285,6 +287,8 @@ int digest_file_window(struct digest *d, const char *filename,
 out:
 	close(fd);
 
+	bootprofile_event(BOOTPROFILE_DIGEST, digest_name(d), time, ret);
+
 	return ret;
 }
 EXPORT_SYMBOL_GPL(digest_file_window);
@@ -104,10 +104,8 @@ static int defaultenv_load_one(struct defaultenv *df, const char *dir,
 		size = df->size;
 	}
 
-	ret = envfs_load_from_buf(buf, size, dir, flags);
-
-	free(freep);
-
+	/* files in ramfs refer to the uncompressed buffer until modified */
+	ret = envfs_load_from_buf(buf, size, dir, flags, freep);
 	if (ret)
 		pr_err("Failed to load defaultenv: %pe\n", ERR_PTR(ret));
 
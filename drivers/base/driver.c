@@ -30,6 +30,8 @@
 #include <pinctrl.h>
 #include <featctrl.h>
 #include <linux/clk/clk-conf.h>
+#include <bootprofile.h>
+#include <linux/hash.h>
 
 #ifdef CONFIG_DEBUG_PROBES
 #define pr_report_probe		pr_info
@@ -47,8 +49,161 @@ LIST_HEAD(active_device_list);
 EXPORT_SYMBOL(active_device_list);
 static LIST_HEAD(deferred);
 
+/* incremented whenever a device is bound to a driver */
+static unsigned int device_bind_seq;
+
 static LIST_HEAD(device_alias_list);
 
+/*
+ * Index from OF compatible strings to the drivers handling them. It is
+ * only used for buses matching with device_match(), which never binds
+ * a driver with an of_match_table to a device with a device node in
+ * any other way. This saves comparing every compatible of every driver
+ * on the bus against each newly registered device.
+ */
+#define DRIVER_COMPAT_HASH_BITS		8
+#define DRIVER_MAX_CANDIDATES		8
+
+struct driver_compat {
+	struct hlist_node hnode;
+	const char *compatible;
+	struct driver *drv;
+};
+
+static struct hlist_head driver_compat_hash[1 << DRIVER_COMPAT_HASH_BITS];
+
+/* Drivers a device may bind to, num < 0 if all drivers need to be tried */
+struct driver_candidates {
+	int num;
+	struct driver *drv[DRIVER_MAX_CANDIDATES];
+};
+
+static struct hlist_head *driver_compat_bucket(const char *compatible)
+{
+	u32 hash = 0;
+
+	/* compatibles are compared case insensitive, see of_compat_cmp() */
+	while (*compatible)
+		hash = hash * 31 + tolower(*compatible++);
+
+	return &driver_compat_hash[hash_32(hash, DRIVER_COMPAT_HASH_BITS)];
+}
+
+static bool driver_compat_indexed(const struct bus_type *bus)
+{
+	return IS_ENABLED(CONFIG_OFDEVICE) && bus->match == device_match;
+}
+
+static void driver_compat_add(struct driver *drv)
+{
+	const struct of_device_id *id;
+	struct driver_compat *dc;
+
+	if (!driver_compat_indexed(drv->bus) || !drv->of_compatible)
+		return;
+
+	for (id = drv->of_compatible; id->compatible; id++) {
+		dc = xzalloc(sizeof(*dc));
+		dc->compatible = id->compatible;
+		dc->drv = drv;
+		hlist_add_head(&dc->hnode, driver_compat_bucket(id->compatible));
+	}
+}
+
+static void driver_compat_del(struct driver *drv)
+{
+	const struct of_device_id *id;
+	struct driver_compat *dc;
+	struct hlist_node *tmp;
+
+	if (!driver_compat_indexed(drv->bus) || !drv->of_compatible)
+		return;
+
+	for (id = drv->of_compatible; id->compatible; id++) {
+		hlist_for_each_entry_safe(dc, tmp, driver_compat_bucket(id->compatible),
+					  hnode) {
+			if (dc->drv != drv)
+				continue;
+
+			hlist_del(&dc->hnode);
+			free(dc);
+		}
+	}
+}
+
+static void driver_candidates_get(struct device *dev,
+				  struct driver_candidates *c)
+{
+	struct driver_compat *dc;
+	struct property *prop;
+	const char *compat;
+	int i;
+
+	c->num = -1;
+
+	if (!driver_compat_indexed(dev->bus) || !dev->of_node)
+		return;
+
+	c->num = 0;
+
+	of_property_for_each_string(dev->of_node, "compatible", prop, compat) {
+		hlist_for_each_entry(dc, driver_compat_bucket(compat), hnode) {
+			if (dc->drv->bus != dev->bus ||
+			    of_compat_cmp(dc->compatible, compat, 0))
+				continue;
+
+			for (i = 0; i < c->num; i++)
+				if (c->drv[i] == dc->drv)
+					break;
+			if (i < c->num)
+				continue;
+
+			if (c->num == DRIVER_MAX_CANDIDATES) {
+				c->num = -1;
+				return;
+			}
+
+			c->drv[c->num++] = dc->drv;
+		}
+	}
+}
+
+/* Whether the index allows @drv to bind to @dev */
+static bool driver_compat_may_match(struct driver *drv, struct device *dev)
+{
+	struct driver_compat *dc;
+	struct property *prop;
+	const char *compat;
+
+	if (!driver_compat_indexed(dev->bus) || !dev->of_node ||
+	    !drv->of_compatible)
+		return true;
+
+	of_property_for_each_string(dev->of_node, "compatible", prop, compat) {
+		hlist_for_each_entry(dc, driver_compat_bucket(compat), hnode) {
+			if (dc->drv == drv && !of_compat_cmp(dc->compatible, compat, 0))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static bool driver_candidates_skip(const struct driver_candidates *c,
+				   const struct driver *drv)
+{
+	int i;
+
+	if (c->num < 0 || !drv->of_compatible)
+		return false;
+
+	for (i = 0; i < c->num; i++)
+		if (c->drv[i] == drv)
+			return false;
+
+	return true;
+}
+
 struct device *find_device(const char *str)
 {
 	struct device *dev;
@@ -121,6 +276,7 @@ static void dev_report_permanent_probe_deferral(struct device *dev)
 int device_probe(struct device *dev)
 {
 	static int depth = 0;
+	u64 start;
 	int ret;
 
 	ret = of_feature_controller_check(dev->of_node);
@@ -140,6 +296,8 @@ int device_probe(struct device *dev)
 
 	list_add(&dev->active, &active_device_list);
 
+	start = bootprofile_start();
+
 	if (dev->bus->probe)
 		ret = dev->bus->probe(dev);
 	else if (dev->driver->probe)
@@ -147,10 +305,13 @@ int device_probe(struct device *dev)
 	else
 		ret = 0;
 
+	bootprofile_probe(BOOTPROFILE_PROBE, dev, depth, start, ret);
+
 	depth--;
 
 	switch (ret) {
 	case 0:
+		device_bind_seq++;
 		return 0;
 	case -EPROBE_DEFER:
 		/*
@@ -163,6 +324,7 @@ int device_probe(struct device *dev)
 		}
 
 		list_move(&dev->active, &deferred);
+		dev->deferred_bind_seq = device_bind_seq;
 
 		dev_dbg(dev, "probe deferred\n");
 		return -EPROBE_DEFER;
@@ -198,6 +360,9 @@ int device_detect_by_name(const char *__devname)
 		strsep(&str, ".");
 
 		dev = get_device_by_name(devname);
+		if (!dev && deep_probe_is_lazy() &&
+		    !of_device_ensure_probed_by_alias(devname))
+			dev = get_device_by_name(devname);
 		if (dev)
 			ret = device_detect(dev);
 
@@ -241,10 +406,26 @@ static int match(struct driver *drv, struct device *dev)
 	return -1;
 }
 
-int register_device(struct device *new_device)
+/* Bind a device to the first matching driver of its bus */
+static int match_device(struct device *dev)
 {
+	struct driver_candidates c;
 	struct driver *drv;
 
+	driver_candidates_get(dev, &c);
+
+	bus_for_each_driver(dev->bus, drv) {
+		if (driver_candidates_skip(&c, drv))
+			continue;
+		if (!match(drv, dev))
+			return 0;
+	}
+
+	return -ENODEV;
+}
+
+int register_device(struct device *new_device)
+{
 	if (new_device->id == DEVICE_ID_DYNAMIC) {
 		new_device->id = get_free_deviceid(new_device->name);
 	} else {
@@ -279,10 +460,7 @@ int register_device(struct device *new_device)
 
 		list_add_tail(&new_device->bus_list, &new_device->bus->device_list);
 
-		bus_for_each_driver(new_device->bus, drv) {
-			if (!match(drv, new_device))
-				break;
-		}
+		match_device(new_device);
 	}
 
 	if (new_device->parent)
@@ -379,14 +557,19 @@ EXPORT_SYMBOL(free_device);
  * Loop over list of deferred devices as long as at least one
  * device is successfully probed. Devices that again request
  * deferral are re-added to deferred list in device_probe().
+ * After the first pass, a device is only retried if some other
+ * device was bound since it deferred, as whatever it waits for
+ * can't have shown up otherwise.
  * For devices finally left in deferred list -EPROBE_DEFER
  * becomes a fatal error.
  */
 static int device_probe_deferred(void)
 {
 	struct device *dev, *tmp;
-	struct driver *drv;
+	bool first = true;
 	bool success;
+	u64 start;
+	int ret;
 
 	do {
 		success = false;
@@ -395,17 +578,22 @@ static int device_probe_deferred(void)
 			return 0;
 
 		list_for_each_entry_safe(dev, tmp, &deferred, active) {
+			if (!first && dev->deferred_bind_seq == device_bind_seq)
+				continue;
+
 			list_del(&dev->active);
 			INIT_LIST_HEAD(&dev->active);
 
 			dev_dbg(dev, "re-probe device\n");
-			bus_for_each_driver(dev->bus, drv) {
-				if (match(drv, dev))
-					continue;
+			start = bootprofile_start();
+			ret = match_device(dev);
+			if (!ret)
 				success = true;
-				break;
-			}
+			bootprofile_probe(BOOTPROFILE_DEFERRED, dev, 0, start,
+					  ret ? -EPROBE_DEFER : 0);
 		}
+
+		first = false;
 	} while (success);
 
 	list_for_each_entry(dev, &deferred, active)
@@ -440,9 +628,12 @@ int register_driver(struct driver *drv)
 
 	list_add_tail(&drv->list, &driver_list);
 	list_add_tail(&drv->bus_list, &drv->bus->driver_list);
+	driver_compat_add(drv);
 
-	bus_for_each_device(drv->bus, dev)
-		match(drv, dev);
+	bus_for_each_device(drv->bus, dev) {
+		if (!dev->driver && driver_compat_may_match(drv, dev))
+			match(drv, dev);
+	}
 
 	return 0;
 }
@@ -454,6 +645,7 @@ void unregister_driver(struct driver *drv)
 
 	list_del(&drv->list);
 	list_del(&drv->bus_list);
+	driver_compat_del(drv);
 
 	bus_for_each_device(drv->bus, dev) {
 		if (dev->driver == drv) {
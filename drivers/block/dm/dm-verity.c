@@ -15,6 +15,7 @@
 #include <digest.h>
 #include <disks.h>
 #include <fcntl.h>
+#include <offload.h>
 #include <xfuncs.h>
 #include <unistd.h>
 
@@ -51,6 +52,23 @@ struct dm_verity {
 			sector_t block;
 		} hblock;
 	} verify;
+
+	struct {
+		struct dm_verity_job *jobs;
+		unsigned int num_jobs;
+		u8 *digests;
+		blkcnt_t num_digests;
+	} offload;
+};
+
+/* Hashes a run of data blocks on a secondary CPU */
+struct dm_verity_job {
+	struct offload_job job;
+	struct dm_verity *v;
+	struct digest *digest;
+	const void *buf;
+	u8 *out;
+	blkcnt_t num_blocks;
 };
 
 static sector_t dm_verity_position_at_level(struct dm_verity *v, sector_t dblock,
@@ -74,17 +92,24 @@ static void dm_verity_hash_at_level(struct dm_verity *v, sector_t dblock, int le
 	*offset = idx << (v->hdev.blk.bits - v->hash_per_block_bits);
 }
 
-static int dm_verity_set_digest(struct dm_verity *v, const void *buf, size_t buflen)
+static int __dm_verity_digest(struct dm_verity *v, struct digest *d,
+			      const void *buf, size_t buflen, u8 *out)
 {
 	int err;
 
-	err = digest_init(v->digest_algo);
-	err = err ? : digest_update(v->digest_algo, v->salt, v->salt_size);
-	err = err ? : digest_update(v->digest_algo, buf, buflen);
-	err = err ? : digest_final(v->digest_algo, v->verify.digest);
+	err = digest_init(d);
+	err = err ? : digest_update(d, v->salt, v->salt_size);
+	err = err ? : digest_update(d, buf, buflen);
+	err = err ? : digest_final(d, out);
 	return err;
 }
 
+static int dm_verity_set_digest(struct dm_verity *v, const void *buf, size_t buflen)
+{
+	return __dm_verity_digest(v, v->digest_algo, buf, buflen,
+				  v->verify.digest);
+}
+
 static int dm_verity_set_hblock(struct dm_verity *v, sector_t hblock)
 {
 	int err;
@@ -105,7 +130,8 @@ static int dm_verity_set_hblock(struct dm_verity *v, sector_t hblock)
 	return 0;
 }
 
-static int dm_verity_verify(struct dm_target *ti, const void *buf, sector_t dblock)
+/* Check v->verify.digest, the digest of data block dblock, against the tree */
+static int dm_verity_verify_digest(struct dm_target *ti, sector_t dblock)
 {
 	struct dm_verity *v = ti->private;
 	const u8 *expected;
@@ -113,10 +139,6 @@ static int dm_verity_verify(struct dm_target *ti, const void *buf, sector_t dblo
 	sector_t hblock;
 	int err, level;
 
-	err = dm_verity_set_digest(v, buf, 1 << v->ddev.blk.bits);
-	if (err)
-		return err;
-
 	for (level = 0; level < v->levels; level++) {
 		dm_verity_hash_at_level(v, dblock, level, &hblock, &hoffs);
 
@@ -178,12 +200,97 @@ static int dm_verity_verify(struct dm_target *ti, const void *buf, sector_t dblo
 	return 0;
 }
 
+static int dm_verity_verify(struct dm_target *ti, const void *buf, sector_t dblock)
+{
+	struct dm_verity *v = ti->private;
+	int err;
+
+	err = dm_verity_set_digest(v, buf, 1 << v->ddev.blk.bits);
+	if (err)
+		return err;
+
+	return dm_verity_verify_digest(ti, dblock);
+}
+
+static int dm_verity_job_fn(struct offload_job *job)
+{
+	struct dm_verity_job *vj = container_of(job, struct dm_verity_job, job);
+	struct dm_verity *v = vj->v;
+	size_t bsize = 1 << v->ddev.blk.bits;
+	blkcnt_t i;
+	int err;
+
+	for (i = 0; i < vj->num_blocks; i++) {
+		err = __dm_verity_digest(v, vj->digest, vj->buf + i * bsize, bsize,
+					 vj->out + i * v->digest_len);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+/* Hash all data blocks of the range on all CPUs, then walk the tree */
+static int dm_verity_verify_range_offload(struct dm_target *ti, const void *buf,
+					  sector_t block, blkcnt_t num_blocks)
+{
+	struct dm_verity *v = ti->private;
+	blkcnt_t per_job, i;
+	unsigned int j, njobs;
+	int err, ret = 0;
+
+	if (num_blocks > v->offload.num_digests) {
+		free(v->offload.digests);
+		v->offload.digests = xmalloc(num_blocks * v->digest_len);
+		v->offload.num_digests = num_blocks;
+	}
+
+	njobs = min_t(blkcnt_t, v->offload.num_jobs, num_blocks);
+	per_job = DIV_ROUND_UP(num_blocks, njobs);
+
+	for (i = 0, j = 0; i < num_blocks; i += per_job, j++) {
+		struct dm_verity_job *vj = &v->offload.jobs[j];
+
+		vj->buf = buf + (i << v->ddev.blk.bits);
+		vj->out = v->offload.digests + i * v->digest_len;
+		vj->num_blocks = min(per_job, num_blocks - i);
+
+		offload_job_init(&vj->job, dm_verity_job_fn);
+		offload_job_submit(&vj->job);
+	}
+
+	njobs = j;
+
+	for (j = 0; j < njobs; j++) {
+		err = offload_job_wait(&v->offload.jobs[j].job);
+		if (err && !ret)
+			ret = err;
+	}
+
+	if (ret)
+		return ret;
+
+	for (i = 0; i < num_blocks; i++) {
+		memcpy(v->verify.digest, v->offload.digests + i * v->digest_len,
+		       v->digest_len);
+
+		err = dm_verity_verify_digest(ti, block + i);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
 static int dm_verity_verify_range(struct dm_target *ti, const void *buf,
 				  sector_t block, blkcnt_t num_blocks)
 {
 	struct dm_verity *v = ti->private;
 	int err;
 
+	if (v->offload.num_jobs > 1 && num_blocks > 1)
+		return dm_verity_verify_range_offload(ti, buf, block, num_blocks);
+
 	for (; num_blocks; block++, num_blocks--, buf += 1 << v->ddev.blk.bits) {
 		err = dm_verity_verify(ti, buf, block);
 		if (err)
@@ -330,6 +437,39 @@ static int dm_verity_cdev_init(struct dm_target *ti, struct dm_cdev *dmcdev,
 	return err;
 }
 
+static void dm_verity_offload_free(struct dm_verity *v)
+{
+	unsigned int i;
+
+	for (i = 0; i < v->offload.num_jobs; i++)
+		digest_free(v->offload.jobs[i].digest);
+
+	free(v->offload.jobs);
+	free(v->offload.digests);
+}
+
+/* Jobs run concurrently, so each needs its own digest context */
+static void dm_verity_offload_init(struct dm_verity *v, const char *algo)
+{
+	unsigned int i, num = offload_num_cpus();
+
+	if (num == 1)
+		return;
+
+	v->offload.jobs = xzalloc(num * sizeof(*v->offload.jobs));
+
+	for (i = 0; i < num; i++) {
+		struct dm_verity_job *vj = &v->offload.jobs[i];
+
+		vj->digest = digest_alloc(algo);
+		if (!vj->digest)
+			break;
+
+		vj->v = v;
+		v->offload.num_jobs++;
+	}
+}
+
 static int dm_verity_create(struct dm_target *ti, unsigned int argc, char **argv)
 {
 	struct dm_verity *v;
@@ -404,6 +544,8 @@ static int dm_verity_create(struct dm_target *ti, unsigned int argc, char **argv
 
 	v->verify.digest = xmalloc(v->digest_len);
 	v->verify.trusted = bitmap_xzalloc(v->hdev.blk.num);
+
+	dm_verity_offload_init(v, argv[7]);
 	return 0;
 
 err:
@@ -426,6 +568,7 @@ static int dm_verity_destroy(struct dm_target *ti)
 {
 	struct dm_verity *v = ti->private;
 
+	dm_verity_offload_free(v);
 	free(v->verify.digest);
 	free(v->verify.hblock.data);
 	free(v->verify.trusted);
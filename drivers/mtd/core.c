@@ -370,6 +370,26 @@ int mtd_block_markgood(struct mtd_info *mtd, loff_t ofs)
 	return ret;
 }
 
+#ifdef CONFIG_MTD_STATS
+#define mtd_stats_start()	iostat_start()
+#define mtd_stats_account(mtd, stats, start, bytes, ret) \
+	iostat_account(&(mtd)->stats, start, bytes, ret)
+
+static void mtd_stats_add_params(struct mtd_info *mtd)
+{
+	iostat_add_params(&mtd->dev, "read", &mtd->read_stats);
+	iostat_add_params(&mtd->dev, "write", &mtd->write_stats);
+	iostat_add_params(&mtd->dev, "erase", &mtd->erase_stats);
+}
+#else
+#define mtd_stats_start()	0
+#define mtd_stats_account(mtd, stats, start, bytes, ret) do { } while (0)
+
+static void mtd_stats_add_params(struct mtd_info *mtd)
+{
+}
+#endif
+
 int mtd_read(struct mtd_info *mtd, loff_t from, size_t len, size_t *retlen,
 	     u_char *buf)
 {
@@ -392,6 +412,7 @@ int mtd_read(struct mtd_info *mtd, loff_t from, size_t len, size_t *retlen,
 int mtd_write_oob(struct mtd_info *mtd, loff_t to,
 				struct mtd_oob_ops *ops)
 {
+	u64 start;
 	int ret;
 
 	ops->retlen = ops->oobretlen = 0;
@@ -403,12 +424,16 @@ int mtd_write_oob(struct mtd_info *mtd, loff_t to,
 	if (!mtd->_write_oob && (!mtd->_write || ops->oobbuf))
 		return -EOPNOTSUPP;
 
+	start = mtd_stats_start();
+
 	if (mtd->_write_oob)
 		ret = mtd->_write_oob(mtd, to, ops);
 	else
 		ret = mtd->_write(mtd, to, ops->len, &ops->retlen,
 				     ops->datbuf);
 
+	mtd_stats_account(mtd, write_stats, start, ops->retlen, ret);
+
 	return ret;
 }
 
@@ -434,6 +459,9 @@ int mtd_write(struct mtd_info *mtd, loff_t to, size_t len, size_t *retlen,
 
 int mtd_erase(struct mtd_info *mtd, struct erase_info *instr)
 {
+	u64 start;
+	int ret;
+
 	if (instr->addr >= mtd->size || instr->len > mtd->size - instr->addr)
 		return -EINVAL;
 	if (!IS_ENABLED(CONFIG_MTD_WRITE))
@@ -444,11 +472,16 @@ int mtd_erase(struct mtd_info *mtd, struct erase_info *instr)
 	if (!instr->len)
 		return 0;
 
-	return mtd->_erase(mtd, instr);
+	start = mtd_stats_start();
+	ret = mtd->_erase(mtd, instr);
+	mtd_stats_account(mtd, erase_stats, start, instr->len, ret);
+
+	return ret;
 }
 
 int mtd_read_oob(struct mtd_info *mtd, loff_t from, struct mtd_oob_ops *ops)
 {
+	u64 start;
 	int ret_code;
 
 	ops->retlen = ops->oobretlen = 0;
@@ -463,12 +496,16 @@ int mtd_read_oob(struct mtd_info *mtd, loff_t from, struct mtd_oob_ops *ops)
 	 * representing max bitflips. In other cases, mtd->_read_oob() may
 	 * return -EUCLEAN. In all cases, perform similar logic to mtd_read().
 	 */
+	start = mtd_stats_start();
+
 	if (mtd->_read_oob)
 		ret_code = mtd->_read_oob(mtd, from, ops);
 	else
 		ret_code = mtd->_read(mtd, from, ops->len, &ops->retlen,
 				    ops->datbuf);
 
+	mtd_stats_account(mtd, read_stats, start, ops->retlen, ret_code);
+
 	if (unlikely(ret_code < 0))
 		return ret_code;
 	if (mtd->ecc_strength == 0)
@@ -707,6 +744,7 @@ int add_mtd_device(struct mtd_info *mtd, const char *devname, int device_id)
 		dev_add_param_uint32_ro(&mtd->dev, "erasesize", &mtd->erasesize, "%u");
 		dev_add_param_uint32_ro(&mtd->dev, "writesize", &mtd->writesize, "%u");
 		dev_add_param_uint32_ro(&mtd->dev, "oobsize", &mtd->oobsize, "%u");
+		mtd_stats_add_params(mtd);
 	}
 
 	ret = devfs_create(&mtd->cdev);
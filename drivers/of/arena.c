@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Arena allocation for unflattened device trees
+ *
+ * Unflattening a device tree allocates a device_node per node and a
+ * property per property, along with their names and values. Instead
+ * of doing tens of thousands of small heap allocations, these are
+ * carved out of a few large chunks that are freed in one go when the
+ * root node is deleted. Nodes and properties added to the tree later
+ * on are allocated from the heap as usual, so freeing functions must
+ * skip memory for which of_arena_owns() returns true.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <of.h>
+#include <linux/list.h>
+#include <linux/sizes.h>
+
+#include "arena.h"
+
+#define OF_ARENA_MIN_CHUNK	SZ_64K
+
+struct of_arena_chunk {
+	struct list_head list;
+	void *start;
+	void *end;
+};
+
+struct of_arena {
+	struct list_head list;
+	struct list_head chunks;
+	void *cur;
+	void *end;
+};
+
+static LIST_HEAD(of_arenas);
+
+static int of_arena_add_chunk(struct of_arena *arena, size_t size)
+{
+	struct of_arena_chunk *chunk;
+
+	size = max_t(size_t, ALIGN(size, SZ_4K), OF_ARENA_MIN_CHUNK);
+
+	chunk = malloc(sizeof(*chunk));
+	if (!chunk)
+		return -ENOMEM;
+
+	chunk->start = calloc(1, size);
+	if (!chunk->start) {
+		free(chunk);
+		return -ENOMEM;
+	}
+
+	chunk->end = chunk->start + size;
+	list_add(&chunk->list, &arena->chunks);
+
+	arena->cur = chunk->start;
+	arena->end = chunk->end;
+
+	return 0;
+}
+
+/**
+ * of_arena_new - create an arena for a new device tree
+ * @size_hint: expected total size of the allocations
+ *
+ * Return: the new arena or NULL if out of memory, in which case the
+ * caller should fall back to heap allocations.
+ */
+struct of_arena *of_arena_new(size_t size_hint)
+{
+	struct of_arena *arena;
+
+	arena = malloc(sizeof(*arena));
+	if (!arena)
+		return NULL;
+
+	INIT_LIST_HEAD(&arena->chunks);
+
+	if (of_arena_add_chunk(arena, size_hint)) {
+		free(arena);
+		return NULL;
+	}
+
+	list_add(&arena->list, &of_arenas);
+
+	return arena;
+}
+
+/**
+ * of_arena_alloc - allocate zeroed memory from an arena
+ * @arena: the arena
+ * @size: size of the allocation
+ *
+ * Allocations can't fail: if no new chunk can be allocated, this
+ * panics just like xzalloc() would.
+ */
+void *of_arena_alloc(struct of_arena *arena, size_t size)
+{
+	void *p;
+
+	/* zero sized properties still need a distinct non-NULL value */
+	size = ALIGN(size ?: 1, sizeof(long));
+
+	if (arena->end - arena->cur < size &&
+	    of_arena_add_chunk(arena, size))
+		panic("out of memory allocating device tree\n");
+
+	p = arena->cur;
+	arena->cur += size;
+
+	return p;
+}
+
+/**
+ * of_arena_strings - copy the strings block of a FDT into an arena
+ * @arena: the arena
+ * @strings: the strings block
+ * @size: size of the strings block
+ *
+ * Property names can then point into the copy instead of being
+ * duplicated one by one.
+ */
+const char *of_arena_strings(struct of_arena *arena, const void *strings,
+			     size_t size)
+{
+	char *copy = of_arena_alloc(arena, size);
+
+	memcpy(copy, strings, size);
+
+	return copy;
+}
+
+/**
+ * of_arena_new_node - arena backed version of of_new_node()
+ * @arena: the arena
+ * @parent: parent node or NULL for a new root node
+ * @name: node name, copied into the arena
+ */
+struct device_node *of_arena_new_node(struct of_arena *arena,
+				      struct device_node *parent,
+				      const char *name)
+{
+	struct device_node *node;
+	size_t namelen, parentlen;
+	char *full_name;
+
+	node = of_arena_alloc(arena, sizeof(*node));
+	node->parent = parent;
+
+	INIT_LIST_HEAD(&node->children);
+	INIT_LIST_HEAD(&node->properties);
+
+	if (!parent) {
+		node->name = "";
+		node->full_name = of_arena_alloc(arena, 1);
+		INIT_LIST_HEAD(&node->list);
+		return node;
+	}
+
+	namelen = strlen(name);
+	parentlen = strlen(parent->full_name);
+
+	full_name = of_arena_alloc(arena, parentlen + 1 + namelen + 1);
+	memcpy(full_name, parent->full_name, parentlen);
+	full_name[parentlen] = '/';
+	memcpy(full_name + parentlen + 1, name, namelen + 1);
+
+	node->full_name = full_name;
+	node->name = full_name + parentlen + 1;
+
+	list_add_tail(&node->parent_list, &parent->children);
+	list_add(&node->list, &parent->list);
+
+	return node;
+}
+
+/**
+ * of_arena_new_property - arena backed version of of_new_property()
+ * @arena: the arena
+ * @node: node the property is added to
+ * @name: property name, must be valid for the lifetime of the arena
+ * @data: property value
+ * @len: length of @data
+ * @constprop: if true, @data is used directly as in of_new_property_const(),
+ *             otherwise it is copied into the arena
+ */
+struct property *of_arena_new_property(struct of_arena *arena,
+				       struct device_node *node,
+				       const char *name, const void *data,
+				       int len, bool constprop)
+{
+	struct property *prop;
+
+	prop = of_arena_alloc(arena, sizeof(*prop));
+	prop->name = name;
+	prop->length = len;
+
+	if (constprop) {
+		prop->value_const = data;
+	} else {
+		prop->value = of_arena_alloc(arena, len);
+		memcpy(prop->value, data, len);
+	}
+
+	list_add_tail(&prop->list, &node->properties);
+
+	return prop;
+}
+
+static struct of_arena *of_arena_find(const void *ptr)
+{
+	struct of_arena_chunk *chunk;
+	struct of_arena *arena;
+
+	list_for_each_entry(arena, &of_arenas, list) {
+		list_for_each_entry(chunk, &arena->chunks, list) {
+			if (ptr >= chunk->start && ptr < chunk->end)
+				return arena;
+		}
+	}
+
+	return NULL;
+}
+
+bool of_arena_owns(const void *ptr)
+{
+	return of_arena_find(ptr) != NULL;
+}
+
+/**
+ * of_arena_release - free the arena of a tree
+ * @root: the root node of the tree being deleted
+ *
+ * Must be called last when deleting @root, as @root itself lives
+ * in the arena.
+ */
+void of_arena_release(struct device_node *root)
+{
+	struct of_arena_chunk *chunk, *tmp;
+	struct of_arena *arena;
+
+	arena = of_arena_find(root);
+	if (!arena)
+		return;
+
+	list_del(&arena->list);
+
+	list_for_each_entry_safe(chunk, tmp, &arena->chunks, list) {
+		free(chunk->start);
+		free(chunk);
+	}
+
+	free(arena);
+}
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef __OF_ARENA_H
+#define __OF_ARENA_H
+
+#include <linux/types.h>
+
+struct device_node;
+struct of_arena;
+
+#ifdef CONFIG_OF_ARENA
+struct of_arena *of_arena_new(size_t size_hint);
+void *of_arena_alloc(struct of_arena *arena, size_t size);
+const char *of_arena_strings(struct of_arena *arena, const void *strings,
+			     size_t size);
+struct device_node *of_arena_new_node(struct of_arena *arena,
+				      struct device_node *parent,
+				      const char *name);
+struct property *of_arena_new_property(struct of_arena *arena,
+				       struct device_node *node,
+				       const char *name, const void *data,
+				       int len, bool constprop);
+bool of_arena_owns(const void *ptr);
+void of_arena_release(struct device_node *root);
+#else
+static inline struct of_arena *of_arena_new(size_t size_hint)
+{
+	return NULL;
+}
+
+static inline void *of_arena_alloc(struct of_arena *arena, size_t size)
+{
+	return NULL;
+}
+
+static inline const char *of_arena_strings(struct of_arena *arena,
+					   const void *strings, size_t size)
+{
+	return NULL;
+}
+
+static inline struct device_node *of_arena_new_node(struct of_arena *arena,
+						    struct device_node *parent,
+						    const char *name)
+{
+	return NULL;
+}
+
+static inline struct property *of_arena_new_property(struct of_arena *arena,
+						     struct device_node *node,
+						     const char *name,
+						     const void *data,
+						     int len, bool constprop)
+{
+	return NULL;
+}
+
+static inline bool of_arena_owns(const void *ptr)
+{
+	return false;
+}
+
+static inline void of_arena_release(struct device_node *root)
+{
+}
+#endif
+
+#endif /* __OF_ARENA_H */
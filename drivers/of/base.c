@@ -24,6 +24,8 @@
 #include <linux/err.h>
 #include <pm_domain.h>
 
+#include "arena.h"
+
 static struct device_node *root_node;
 
 /**
@@ -2575,6 +2577,16 @@ int of_diff(struct device_node *a, struct device_node *b, int indent)
 	return diff;
 }
 
+/*
+ * Nodes and properties of unflattened trees may be allocated from an
+ * arena which is freed as a whole when the root node is deleted.
+ */
+static void of_free(const void *ptr)
+{
+	if (!of_arena_owns(ptr))
+		free_const(ptr);
+}
+
 struct device_node *of_new_node(struct device_node *parent, const char *name)
 {
 	struct device_node *node;
@@ -2676,9 +2688,9 @@ void of_delete_property(struct property *pp)
 
 	list_del(&pp->list);
 
-	free_const(pp->name);
-	free(pp->value);
-	free(pp);
+	of_free(pp->name);
+	of_free(pp->value);
+	of_free(pp);
 }
 
 struct property *of_rename_property(struct device_node *np,
@@ -2692,7 +2704,7 @@ struct property *of_rename_property(struct device_node *np,
 
 	of_property_write_bool(np, new_name, false);
 
-	free_const(pp->name);
+	of_free(pp->name);
 	pp->name = xstrdup(new_name);
 	return pp;
 }
@@ -2760,7 +2772,13 @@ int of_append_property(struct device_node *np, const char *name, const void *val
 	}
 
 	orig_len = pp->length;
-	buf = realloc(pp->value, orig_len + len);
+	if (of_arena_owns(pp->value)) {
+		buf = malloc(orig_len + len);
+		if (buf)
+			memcpy(buf, pp->value, orig_len);
+	} else {
+		buf = realloc(pp->value, orig_len + len);
+	}
 	if (!buf)
 		return -ENOMEM;
 
@@ -2799,7 +2817,7 @@ int of_prepend_property(struct device_node *np, const char *name, const void *va
 	memcpy(buf, val, len);
 	memcpy(buf + len, oldval, oldlen);
 
-	free(pp->value);
+	of_free(pp->value);
 	pp->value = buf;
 	pp->length = len + oldlen;
 	pp->value_const = NULL;
@@ -2977,6 +2995,13 @@ int of_probe(void)
 	if (node)
 		of_platform_populate(node, NULL, NULL);
 
+	/*
+	 * In lazy mode, the devices needed for booting are probed on demand
+	 * and the rest only once deep_probe_complete() is called.
+	 */
+	if (deep_probe_is_lazy())
+		return 0;
+
 	of_platform_populate(root_node, of_default_bus_match_table, NULL);
 
 	return 0;
@@ -3082,9 +3107,15 @@ void of_delete_node(struct device_node *node)
 		list_del(&node->list);
 	}
 
-	free_const(node->name);
-	free(node->full_name);
-	free(node);
+	of_free(node->name);
+	of_free(node->full_name);
+
+	if (node->parent)
+		of_free(node);
+	else if (of_arena_owns(node))
+		of_arena_release(node);
+	else
+		free(node);
 }
 
 /*
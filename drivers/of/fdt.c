@@ -20,6 +20,8 @@
 #include <linux/string_helpers.h>
 #include <linux/err.h>
 
+#include "arena.h"
+
 static inline bool __dt_ptr_ok(const struct fdt_header *fdt, const void *p,
 				  unsigned elem_size, unsigned elem_align)
 {
@@ -182,8 +184,10 @@ static struct device_node *__of_unflatten_dtb(const void *infdt, int size,
 	const char *pathp, *name;
 	struct device_node *root, *node = NULL;
 	struct property *p;
+	struct of_arena *arena = NULL;
 	uint32_t dt_struct;
 	const struct fdt_node_header *fnh;
+	const char *arena_strings = NULL;
 	void *dt_strings;
 	struct fdt_header f;
 	int ret;
@@ -197,7 +201,21 @@ static struct device_node *__of_unflatten_dtb(const void *infdt, int size,
 	dt_struct = f.off_dt_struct;
 	dt_strings = (void *)fdt + f.off_dt_strings;
 
-	root = of_new_node(NULL, NULL);
+	/*
+	 * Each FDT_PROP becomes a struct property plus its value and each
+	 * FDT_BEGIN_NODE a struct device_node plus its full name, so twice
+	 * the structure block is a good estimate of what's needed.
+	 */
+	if (IS_ENABLED(CONFIG_OF_ARENA))
+		arena = of_arena_new(2 * f.size_dt_struct + f.size_dt_strings);
+
+	if (arena) {
+		arena_strings = of_arena_strings(arena, dt_strings,
+						 f.size_dt_strings);
+		root = of_arena_new_node(arena, NULL, NULL);
+	} else {
+		root = of_new_node(NULL, NULL);
+	}
 	if (!root)
 		return ERR_PTR(-ENOMEM);
 
@@ -252,7 +270,10 @@ static struct device_node *__of_unflatten_dtb(const void *infdt, int size,
 					ret = -EINVAL;
 					goto err;
 				}
-				node = of_new_node(node, pathp);
+				if (arena)
+					node = of_arena_new_node(arena, node, pathp);
+				else
+					node = of_new_node(node, pathp);
 			}
 
 			break;
@@ -297,7 +318,11 @@ static struct device_node *__of_unflatten_dtb(const void *infdt, int size,
 				goto err;
 			}
 
-			if (constprops)
+			if (arena)
+				p = of_arena_new_property(arena, node,
+						arena_strings + (name - (char *)dt_strings),
+						nodep, len, constprops);
+			else if (constprops)
 				p = of_new_property_const(node, name, nodep, len);
 			else
 				p = of_new_property(node, name, nodep, len);
@@ -161,6 +161,14 @@ static void imx_serial_flush(struct console_device *cdev)
 	while (!(readl(priv->regs + USR2) & USR2_TXDC));
 }
 
+static int imx_serial_tx_ready(struct console_device *cdev)
+{
+	struct imx_serial_priv *priv = container_of(cdev,
+					struct imx_serial_priv, cdev);
+
+	return !(readl(priv->regs + priv->devtype->uts) & UTS_TXFULL);
+}
+
 static int imx_serial_setbaudrate(struct console_device *cdev, int baudrate)
 {
 	struct imx_serial_priv *priv = container_of(cdev,
@@ -232,6 +240,7 @@ static int imx_serial_probe(struct device *dev)
 	cdev->putc = imx_serial_putc;
 	cdev->getc = imx_serial_getc;
 	cdev->flush = imx_serial_flush;
+	cdev->tx_ready = imx_serial_tx_ready;
 	cdev->setbrg = priv->clk ? imx_serial_setbaudrate : NULL;
 	cdev->linux_console_name = "ttymxc";
 	cdev->linux_earlycon_name = "ec_imx6q";
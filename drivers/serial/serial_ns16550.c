@@ -328,6 +328,16 @@ static int ns16550_tstc(struct console_device *cdev)
 	return ((ns16550_read(cdev, lsr) & LSR_DR) != 0);
 }
 
+/**
+ * @brief Test if a character can be sent without waiting
+ *
+ * @param[in] cdev pointer to console device
+ */
+static int ns16550_tx_ready(struct console_device *cdev)
+{
+	return (ns16550_read(cdev, lsr) & LSR_THRE) != 0;
+}
+
 /**
  * @brief Flush remaining characters in serial device
  *
@@ -551,6 +561,7 @@ static int ns16550_probe(struct device *dev)
 	cdev->getc = ns16550_getc;
 	cdev->setbrg = priv->plat.clock ? ns16550_setbaudrate : NULL;
 	cdev->flush = ns16550_flush;
+	cdev->tx_ready = ns16550_tx_ready;
 	cdev->linux_console_name = devtype->linux_console_name;
 	cdev->linux_earlycon_name = basprintf("%s,%s", devtype->linux_earlycon_name,
 					      priv->access_type);
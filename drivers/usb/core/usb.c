@@ -777,6 +777,70 @@ int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 	return (dev->status == 0) ? 0 : -1;
 }
 
+/**
+ * usb_bulk_msgs - submit several bulk transfers at once
+ * @dev: the USB device
+ * @xfers: the transfers, in the order they are to be done on the bus
+ * @num: number of transfers
+ * @timeout_ms: timeout for each transfer
+ *
+ * If the host controller supports it, all transfers are queued before
+ * waiting for the first one to complete, so the device can go on with
+ * the next transfer without waiting for us. Transfers on an endpoint
+ * following a failed one on the same endpoint are not done. Otherwise
+ * the transfers are done one after another, stopping at the first
+ * failure.
+ *
+ * Return: 0 if all transfers succeeded, a negative error code otherwise.
+ * The result of each transfer is in its @status and @actual_length.
+ */
+int usb_bulk_msgs(struct usb_device *dev, struct usb_bulk_xfer *xfers,
+		  int num, int timeout_ms)
+{
+	struct usb_host *host = dev->host;
+	int i, ret = 0;
+
+	for (i = 0; i < num; i++) {
+		if (xfers[i].len < 0)
+			return -EINVAL;
+		xfers[i].status = USB_ST_NOT_PROC;
+		xfers[i].actual_length = 0;
+	}
+
+	ret = usb_host_acquire(host);
+	if (ret)
+		return ret;
+
+	if (host->submit_bulk_msgs) {
+		ret = host->submit_bulk_msgs(dev, xfers, num, timeout_ms);
+	} else {
+		for (i = 0; i < num; i++) {
+			dev->status = USB_ST_NOT_PROC;
+			ret = host->submit_bulk_msg(dev, xfers[i].pipe,
+						    xfers[i].data, xfers[i].len,
+						    timeout_ms);
+			if (ret)
+				break;
+
+			xfers[i].status = dev->status;
+			xfers[i].actual_length = dev->act_len;
+			if (dev->status)
+				break;
+		}
+	}
+
+	usb_host_release(host);
+
+	if (ret)
+		return ret;
+
+	for (i = 0; i < num; i++)
+		if (xfers[i].status)
+			return -EIO;
+
+	return 0;
+}
+
 
 /*-------------------------------------------------------------------
  * Max Packet stuff
@@ -216,6 +216,7 @@
 #include <linux/stat.h>
 #include <linux/wait.h>
 #include <fcntl.h>
+#include <fs.h>
 #include <file-list.h>
 #include <dma.h>
 #include <linux/bug.h>
@@ -280,6 +281,16 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	buffhds[FSG_NUM_BUFFERS];
 
+	/*
+	 * Data following the last READ, read from the backing file while
+	 * waiting for the next command.
+	 */
+	void			*ra_buf;
+	loff_t			ra_offset;
+	unsigned int		ra_lun;
+	unsigned int		ra_len;
+	unsigned int		ra_pending:1;
+
 	struct f_ums_opts	*opts;
 
 	int			cmnd_size;
@@ -685,6 +696,59 @@ static int sleep_thread(struct fsg_common *common)
 
 /*-------------------------------------------------------------------------*/
 
+static void fsg_readahead_invalidate(struct fsg_common *common)
+{
+	common->ra_pending = 0;
+	common->ra_len = 0;
+}
+
+/*
+ * Read the data following the last READ into the read-ahead buffer. This
+ * is called after the request for the next CBW has been queued, so the
+ * backing file is read while the host sends the next command.
+ */
+static void fsg_readahead(struct fsg_common *common)
+{
+	struct fsg_lun *curlun = &common->luns[common->ra_lun];
+	loff_t size = (loff_t)curlun->num_sectors << 9;
+	ssize_t nread;
+
+	if (!common->ra_pending)
+		return;
+
+	common->ra_pending = 0;
+
+	if (common->ra_offset >= size)
+		return;
+
+	nread = pread(ums[common->ra_lun].fd, common->ra_buf,
+		      min_t(loff_t, FSG_BUFLEN, size - common->ra_offset),
+		      common->ra_offset);
+	if (nread > 0)
+		common->ra_len = nread - (nread & 511);
+}
+
+/*
+ * If the read-ahead buffer holds the data at @file_offset, exchange it
+ * with the buffer of @bh and return the number of valid bytes.
+ */
+static unsigned int fsg_readahead_take(struct fsg_common *common,
+				       struct fsg_buffhd *bh,
+				       loff_t file_offset)
+{
+	unsigned int len = common->ra_len;
+
+	if (!len || common->ra_lun != common->lun ||
+	    common->ra_offset != file_offset)
+		return 0;
+
+	swap(bh->buf, common->ra_buf);
+	bh->inreq->buf = bh->outreq->buf = bh->buf;
+	common->ra_len = 0;
+
+	return len;
+}
+
 static int do_read(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
@@ -758,8 +822,13 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		/* Perform the read */
-		nread = pread(ums[common->lun].fd, bh->buf, amount, file_offset);
+		/* Perform the read, unless it was already read ahead */
+		nread = fsg_readahead_take(common, bh, file_offset);
+		if (nread)
+			nread = min_t(ssize_t, nread, amount);
+		else
+			nread = pread(ums[common->lun].fd, bh->buf, amount,
+				      file_offset);
 
 		VLDBG(curlun, "file read %u @ %llu -> %zd\n", amount,
 				(unsigned long long) file_offset,
@@ -786,8 +855,13 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		if (amount_left == 0)
+		if (amount_left == 0) {
+			/* Read ahead once the data is on its way */
+			common->ra_pending = 1;
+			common->ra_lun = common->lun;
+			common->ra_offset = file_offset;
 			break;		/* No more left to read */
+		}
 
 		/* Send this buffer and go read some more */
 		bh->inreq->zero = 0;
@@ -822,6 +896,8 @@ static int do_write(struct fsg_common *common)
 		return -EINVAL;
 	}
 
+	fsg_readahead_invalidate(common);
+
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
 	if (common->cmnd[0] == SCSI_WRITE6)
@@ -832,7 +908,7 @@ static int do_write(struct fsg_common *common)
 		/* We allow DPO (Disable Page Out = don't save data in the
 		 * cache) and FUA (Force Unit Access = write directly to the
 		 * medium).  We don't implement DPO; we implement FUA by
-		 * performing synchronous output. */
+		 * flushing the backing file after the write. */
 		if (common->cmnd[1] & ~0x18) {
 			curlun->sense_data = SS_INVALID_FIELD_IN_CDB;
 			return -EINVAL;
@@ -967,13 +1043,28 @@ static int do_write(struct fsg_common *common)
 			return rc;
 	}
 
+	if (amount_left_to_write == 0 && common->cmnd[0] != SCSI_WRITE6 &&
+	    (common->cmnd[1] & 0x08) && flush(ums[common->lun].fd)) {
+		curlun->sense_data = SS_WRITE_ERROR;
+		curlun->info_valid = 1;
+	}
+
 	return -EIO;		/* No default reply */
 }
 
 /*-------------------------------------------------------------------------*/
 
+/*
+ * Writes only go to the block cache of the backing device, write it back
+ * when the host asks for it.
+ */
 static int do_synchronize_cache(struct fsg_common *common)
 {
+	struct fsg_lun	*curlun = &common->luns[common->lun];
+
+	if (flush(ums[common->lun].fd))
+		curlun->sense_data = SS_WRITE_ERROR;
+
 	return 0;
 }
 
@@ -2109,6 +2200,9 @@ static int get_next_command(struct fsg_common *common)
 	 * can reuse it for the next filling.  No need to advance
 	 * next_buffhd_to_fill. */
 
+	/* Read ahead while the host sends the CBW */
+	fsg_readahead(common);
+
 	/* Wait for the CBW to arrive */
 	while (bh->state != BUF_STATE_FULL) {
 		rc = sleep_thread(common);
@@ -2424,6 +2518,10 @@ static void fsg_main_thread(void *fsg_)
 		dma_free(bh->buf);
 	} while (++bh, --i);
 
+	dma_free(common->ra_buf);
+	common->ra_buf = NULL;
+	fsg_readahead_invalidate(common);
+
 	ums_count = 0;
 	ums_files = NULL;
 
@@ -2562,6 +2660,12 @@ static int fsg_common_init(struct fsg_common *common,
 	} while (--i);
 	bh->next = common->buffhds;
 
+	common->ra_buf = dma_alloc(FSG_BUFLEN);
+	if (!common->ra_buf) {
+		rc = -ENOMEM;
+		goto error_release;
+	}
+
 	snprintf(common->inquiry_string, sizeof common->inquiry_string,
 		 "%-8s%-16s%04x",
 		 "Linux   ",
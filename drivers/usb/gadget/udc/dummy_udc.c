@@ -0,0 +1,463 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Dummy USB device controller
+ *
+ * There is no hardware behind this UDC. Instead the host side of the bus is
+ * modelled in software: control and bulk transfers are issued with
+ * dummy_udc_control() and dummy_udc_bulk(), which move the data directly
+ * from and to the requests the gadget functions have queued. This allows
+ * to exercise and benchmark the gadget stack in sandbox.
+ */
+
+#define pr_fmt(fmt) "dummy-udc: " fmt
+
+#include <common.h>
+#include <driver.h>
+#include <init.h>
+#include <clock.h>
+#include <malloc.h>
+#include <of.h>
+#include <linux/usb/gadget.h>
+#include <linux/usb/dummy_udc.h>
+
+#define DUMMY_UDC_NUM_EPS	8	/* in addition to ep0 */
+#define DUMMY_UDC_TIMEOUT	(5 * SECOND)
+
+struct dummy_request {
+	struct usb_request req;
+	struct list_head queue;
+};
+
+struct dummy_ep {
+	struct usb_ep ep;
+	struct dummy_udc *udc;
+	struct list_head queue;
+	char name[16];
+	bool halted;
+	unsigned int queued;
+	struct dummy_udc_ep_stats stats;
+};
+
+struct dummy_udc {
+	struct usb_gadget gadget;
+	struct usb_gadget_driver *driver;
+	struct dummy_ep ep[DUMMY_UDC_NUM_EPS + 1];
+	bool pullup;
+};
+
+static struct dummy_udc *dummy_udc_instance;
+
+static inline struct dummy_ep *to_dummy_ep(struct usb_ep *ep)
+{
+	return container_of(ep, struct dummy_ep, ep);
+}
+
+static inline struct dummy_request *to_dummy_request(struct usb_request *req)
+{
+	return container_of(req, struct dummy_request, req);
+}
+
+static inline struct dummy_udc *to_dummy_udc(struct usb_gadget *gadget)
+{
+	return container_of(gadget, struct dummy_udc, gadget);
+}
+
+static void dummy_ep_done(struct dummy_ep *ep, struct dummy_request *dreq,
+			  int status)
+{
+	list_del_init(&dreq->queue);
+	ep->queued--;
+
+	dreq->req.status = status;
+
+	if (!status) {
+		ep->stats.requests++;
+		ep->stats.bytes += dreq->req.actual;
+	}
+
+	usb_gadget_giveback_request(&ep->ep, &dreq->req);
+}
+
+static void dummy_ep_nuke(struct dummy_ep *ep, int status)
+{
+	struct dummy_request *dreq, *tmp;
+
+	list_for_each_entry_safe(dreq, tmp, &ep->queue, queue)
+		dummy_ep_done(ep, dreq, status);
+}
+
+static int dummy_ep_enable(struct usb_ep *_ep,
+			   const struct usb_endpoint_descriptor *desc)
+{
+	struct dummy_ep *ep = to_dummy_ep(_ep);
+
+	ep->ep.maxpacket = usb_endpoint_maxp(desc);
+	ep->halted = false;
+
+	return 0;
+}
+
+static int dummy_ep_disable(struct usb_ep *_ep)
+{
+	dummy_ep_nuke(to_dummy_ep(_ep), -ESHUTDOWN);
+
+	return 0;
+}
+
+static struct usb_request *dummy_ep_alloc_request(struct usb_ep *_ep)
+{
+	struct dummy_request *dreq;
+
+	dreq = xzalloc(sizeof(*dreq));
+	INIT_LIST_HEAD(&dreq->queue);
+
+	return &dreq->req;
+}
+
+static void dummy_ep_free_request(struct usb_ep *_ep, struct usb_request *req)
+{
+	free(to_dummy_request(req));
+}
+
+static int dummy_ep_queue(struct usb_ep *_ep, struct usb_request *req)
+{
+	struct dummy_ep *ep = to_dummy_ep(_ep);
+	struct dummy_request *dreq = to_dummy_request(req);
+
+	if (!list_empty(&dreq->queue))
+		return -EBUSY;
+
+	req->status = -EINPROGRESS;
+	req->actual = 0;
+
+	list_add_tail(&dreq->queue, &ep->queue);
+	ep->queued++;
+	ep->stats.max_queued = max(ep->stats.max_queued, ep->queued);
+
+	return 0;
+}
+
+static int dummy_ep_dequeue(struct usb_ep *_ep, struct usb_request *req)
+{
+	struct dummy_ep *ep = to_dummy_ep(_ep);
+	struct dummy_request *dreq = to_dummy_request(req);
+
+	if (list_empty(&dreq->queue))
+		return -EINVAL;
+
+	dummy_ep_done(ep, dreq, -ECONNRESET);
+
+	return 0;
+}
+
+static int dummy_ep_set_halt(struct usb_ep *_ep, int value)
+{
+	to_dummy_ep(_ep)->halted = value;
+
+	return 0;
+}
+
+static const struct usb_ep_ops dummy_ep_ops = {
+	.enable = dummy_ep_enable,
+	.disable = dummy_ep_disable,
+	.alloc_request = dummy_ep_alloc_request,
+	.free_request = dummy_ep_free_request,
+	.queue = dummy_ep_queue,
+	.dequeue = dummy_ep_dequeue,
+	.set_halt = dummy_ep_set_halt,
+};
+
+static int dummy_udc_pullup(struct usb_gadget *gadget, int is_on)
+{
+	struct dummy_udc *udc = to_dummy_udc(gadget);
+
+	udc->pullup = is_on;
+	gadget->speed = is_on ? USB_SPEED_HIGH : USB_SPEED_UNKNOWN;
+
+	return 0;
+}
+
+static int dummy_udc_start(struct usb_gadget *gadget,
+			   struct usb_gadget_driver *driver)
+{
+	struct dummy_udc *udc = to_dummy_udc(gadget);
+
+	udc->driver = driver;
+	dummy_udc_reset_stats(udc);
+
+	return 0;
+}
+
+static int dummy_udc_stop(struct usb_gadget *gadget)
+{
+	struct dummy_udc *udc = to_dummy_udc(gadget);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(udc->ep); i++)
+		dummy_ep_nuke(&udc->ep[i], -ESHUTDOWN);
+
+	udc->driver = NULL;
+
+	return 0;
+}
+
+static const struct usb_gadget_ops dummy_udc_ops = {
+	.pullup = dummy_udc_pullup,
+	.udc_start = dummy_udc_start,
+	.udc_stop = dummy_udc_stop,
+};
+
+/*
+ * Wait for the gadget to queue a request. The gadget functions may defer
+ * work to pollers, workqueues or bthreads, so keep scheduling while waiting.
+ */
+static struct dummy_request *dummy_ep_wait(struct dummy_ep *ep)
+{
+	u64 start;
+
+	if (list_empty(&ep->queue)) {
+		ep->stats.starved++;
+
+		start = get_time_ns();
+		while (list_empty(&ep->queue)) {
+			if (is_timeout(start, DUMMY_UDC_TIMEOUT))
+				return NULL;
+		}
+	}
+
+	return list_first_entry(&ep->queue, struct dummy_request, queue);
+}
+
+static struct dummy_ep *dummy_udc_find_ep(struct dummy_udc *udc, u8 epaddr)
+{
+	int i;
+
+	for (i = 1; i < ARRAY_SIZE(udc->ep); i++) {
+		struct dummy_ep *ep = &udc->ep[i];
+
+		if (ep->ep.enabled && ep->ep.address == epaddr)
+			return ep;
+	}
+
+	return NULL;
+}
+
+/**
+ * dummy_udc_get - get the dummy UDC
+ *
+ * Return: the dummy UDC or NULL if there is none
+ */
+struct dummy_udc *dummy_udc_get(void)
+{
+	return dummy_udc_instance;
+}
+
+/**
+ * dummy_udc_control - issue a control transfer on ep0
+ * @udc: the dummy UDC
+ * @ctrl: the setup packet
+ * @data: buffer for the data stage, wLength bytes
+ *
+ * Return: number of bytes transferred in the data stage or a negative
+ * error code, -EPIPE if the gadget stalled the request.
+ */
+int dummy_udc_control(struct dummy_udc *udc, const struct usb_ctrlrequest *ctrl,
+		      void *data)
+{
+	struct dummy_ep *ep0 = &udc->ep[0];
+	struct dummy_request *dreq;
+	unsigned int len = le16_to_cpu(ctrl->wLength);
+	int ret;
+
+	if (!udc->driver || !udc->pullup)
+		return -ENODEV;
+
+	ret = udc->driver->setup(&udc->gadget, ctrl);
+	if (ret < 0)
+		return -EPIPE;
+
+	dreq = dummy_ep_wait(ep0);
+	if (!dreq)
+		return -ETIMEDOUT;
+
+	len = min(len, dreq->req.length);
+
+	if (ctrl->bRequestType & USB_DIR_IN)
+		memcpy(data, dreq->req.buf, len);
+	else
+		memcpy(dreq->req.buf, data, len);
+
+	dreq->req.actual = len;
+	dummy_ep_done(ep0, dreq, 0);
+
+	return len;
+}
+
+/**
+ * dummy_udc_bulk - issue a bulk transfer
+ * @udc: the dummy UDC
+ * @epaddr: endpoint address, including USB_DIR_IN for IN endpoints
+ * @buf: the data
+ * @len: size of @buf
+ *
+ * An OUT transfer is spread over as many requests as needed, the last one
+ * completing early if it's not filled up. An IN transfer ends after @len
+ * bytes or after a request not ending on a packet boundary.
+ *
+ * Return: number of bytes transferred or a negative error code
+ */
+int dummy_udc_bulk(struct dummy_udc *udc, u8 epaddr, void *buf, size_t len)
+{
+	struct dummy_ep *ep = dummy_udc_find_ep(udc, epaddr);
+	bool in = epaddr & USB_DIR_IN;
+	size_t done = 0;
+
+	if (!ep)
+		return -ENODEV;
+	if (ep->halted)
+		return -EPIPE;
+
+	while (done < len) {
+		struct dummy_request *dreq = dummy_ep_wait(ep);
+		struct usb_request *req;
+		size_t n;
+		bool last;
+
+		if (!dreq)
+			return -ETIMEDOUT;
+
+		req = &dreq->req;
+		n = min_t(size_t, len - done, req->length - req->actual);
+
+		if (in)
+			memcpy(buf + done, req->buf + req->actual, n);
+		else
+			memcpy(req->buf + req->actual, buf + done, n);
+
+		req->actual += n;
+		done += n;
+
+		last = in && req->actual == req->length &&
+		       (!req->length || req->length % ep->ep.maxpacket);
+
+		if (req->actual == req->length || (!in && done == len))
+			dummy_ep_done(ep, dreq, 0);
+
+		if (last)
+			break;
+	}
+
+	return done;
+}
+
+/**
+ * dummy_udc_ep_stats - get the request statistics of an endpoint
+ * @udc: the dummy UDC
+ * @epaddr: endpoint address, including USB_DIR_IN for IN endpoints
+ * @stats: returns the statistics
+ */
+int dummy_udc_ep_stats(struct dummy_udc *udc, u8 epaddr,
+		       struct dummy_udc_ep_stats *stats)
+{
+	struct dummy_ep *ep = dummy_udc_find_ep(udc, epaddr);
+
+	if (!ep)
+		return -ENODEV;
+
+	*stats = ep->stats;
+
+	return 0;
+}
+
+void dummy_udc_reset_stats(struct dummy_udc *udc)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(udc->ep); i++) {
+		memset(&udc->ep[i].stats, 0, sizeof(udc->ep[i].stats));
+		udc->ep[i].stats.max_queued = udc->ep[i].queued;
+	}
+}
+
+static void dummy_ep_setup(struct dummy_udc *udc, int i)
+{
+	struct dummy_ep *ep = &udc->ep[i];
+	bool in = i & 1;
+
+	ep->udc = udc;
+	INIT_LIST_HEAD(&ep->queue);
+	ep->ep.ops = &dummy_ep_ops;
+	ep->ep.name = ep->name;
+
+	if (!i) {
+		strcpy(ep->name, "ep0");
+		ep->ep.caps.type_control = true;
+		ep->ep.caps.dir_in = true;
+		ep->ep.caps.dir_out = true;
+		usb_ep_set_maxpacket_limit(&ep->ep, 64);
+		return;
+	}
+
+	sprintf(ep->name, "ep%d%s", (i + 1) / 2, in ? "in" : "out");
+	ep->ep.caps.type_bulk = true;
+	ep->ep.caps.type_int = true;
+	ep->ep.caps.dir_in = in;
+	ep->ep.caps.dir_out = !in;
+	usb_ep_set_maxpacket_limit(&ep->ep, 512);
+	list_add_tail(&ep->ep.ep_list, &udc->gadget.ep_list);
+}
+
+static int dummy_udc_probe(struct device *dev)
+{
+	struct dummy_udc *udc;
+	int i, ret;
+
+	if (dummy_udc_instance)
+		return -EBUSY;
+
+	udc = xzalloc(sizeof(*udc));
+
+	udc->gadget.ops = &dummy_udc_ops;
+	udc->gadget.ep0 = &udc->ep[0].ep;
+	INIT_LIST_HEAD(&udc->gadget.ep_list);
+	udc->gadget.speed = USB_SPEED_UNKNOWN;
+	udc->gadget.max_speed = USB_SPEED_HIGH;
+	udc->gadget.name = "dummy-udc";
+
+	for (i = 0; i < ARRAY_SIZE(udc->ep); i++)
+		dummy_ep_setup(udc, i);
+
+	ret = usb_add_gadget_udc(dev, &udc->gadget);
+	if (ret) {
+		free(udc);
+		return ret;
+	}
+
+	dev->priv = udc;
+	dummy_udc_instance = udc;
+
+	return 0;
+}
+
+static void dummy_udc_remove(struct device *dev)
+{
+	struct dummy_udc *udc = dev->priv;
+
+	usb_del_gadget_udc(&udc->gadget);
+	dummy_udc_instance = NULL;
+	free(udc);
+}
+
+static __maybe_unused struct of_device_id dummy_udc_dt_ids[] = {
+	{ .compatible = "barebox,dummy-udc" },
+	{ /* sentinel */ }
+};
+MODULE_DEVICE_TABLE(of, dummy_udc_dt_ids);
+
+static struct driver dummy_udc_driver = {
+	.name = "dummy-udc",
+	.of_compatible = DRV_OF_COMPAT(dummy_udc_dt_ids),
+	.probe = dummy_udc_probe,
+	.remove = dummy_udc_remove,
+};
+device_platform_driver(dummy_udc_driver);
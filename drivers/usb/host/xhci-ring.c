@@ -600,111 +600,80 @@ static void abort_td(struct usb_device *udev, int ep_index)
 	xhci_acknowledge_event(ctrl);
 }
 
-static void record_transfer_result(struct usb_device *udev,
-				   union xhci_trb *event, int length)
+static unsigned long xhci_comp_to_status(u32 comp)
 {
-	udev->act_len = min(length, length -
-		(int)EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len)));
-
-	switch (GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len))) {
+	switch (comp) {
 	case COMP_SUCCESS:
-		BUG_ON(udev->act_len != length);
-		fallthrough;
 	case COMP_SHORT_TX:
-		udev->status = 0;
-		break;
+		return 0;
 	case COMP_STALL:
-		udev->status = USB_ST_STALLED;
-		break;
+		return USB_ST_STALLED;
 	case COMP_DB_ERR:
 	case COMP_TRB_ERR:
-		udev->status = USB_ST_BUF_ERR;
-		break;
+		return USB_ST_BUF_ERR;
 	case COMP_BABBLE:
-		udev->status = USB_ST_BABBLE_DET;
-		break;
+		return USB_ST_BABBLE_DET;
 	default:
-		udev->status = 0x80;  /* USB_ST_TOO_LAZY_TO_MAKE_A_NEW_MACRO */
+		return 0x80;  /* USB_ST_TOO_LAZY_TO_MAKE_A_NEW_MACRO */
 	}
 }
 
+static void record_transfer_result(struct usb_device *udev,
+				   union xhci_trb *event, int length)
+{
+	u32 comp = GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len));
+
+	udev->act_len = min(length, length -
+		(int)EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len)));
+
+	BUG_ON(comp == COMP_SUCCESS && udev->act_len != length);
+
+	udev->status = xhci_comp_to_status(comp);
+}
+
 /**** Bulk and Control transfer methods ****/
-/**
- * Queues up the BULK Request
- *
- * @param udev		pointer to the USB device structure
- * @param pipe		contains the DIR_IN or OUT , devnum
- * @param length	length of the buffer
- * @param buffer	buffer to be read/written based on the request
- * @return returns 0 if successful else -1 on failure
+
+/*
+ * A TRB may not cross a 64KiB boundary, so a TD needs one TRB for each
+ * 64KiB chunk of the bounce buffer it touches.
  */
-int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
-			int length, void *buffer, unsigned int timeout_ms)
+#define XHCI_BULK_MAX_TRBS	(XHCI_BOUNCE_SIZE / TRB_MAX_BUFF_SIZE + 1)
+
+struct xhci_bulk_td {
+	struct usb_bulk_xfer *xfer;
+	int ep_index;
+	void *bounce;
+	dma_addr_t map;
+	enum dma_data_direction direction;
+	int num_trbs;
+	dma_addr_t trb[XHCI_BULK_MAX_TRBS];
+	u32 trb_len[XHCI_BULK_MAX_TRBS];
+	bool done;
+};
+
+/*
+ * Queues the TRBs of one bulk TD and hands them over to the hardware.
+ */
+static int xhci_queue_bulk_td(struct usb_device *udev, struct xhci_bulk_td *td)
 {
-	int num_trbs = 0;
-	struct xhci_generic_trb *start_trb;
-	bool first_trb = false;
-	int start_cycle;
-	u32 field = 0;
-	u32 length_field = 0;
 	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
-	int slot_id = udev->slot_id;
-	int ep_index;
-	struct xhci_virt_device *virt_dev;
+	struct xhci_virt_device *virt_dev = ctrl->devs[udev->slot_id];
+	struct xhci_ring *ring = virt_dev->eps[td->ep_index].ring;
+	unsigned long pipe = td->xfer->pipe;
+	int length = td->xfer->len;
+	struct xhci_generic_trb *start_trb;
 	struct xhci_ep_ctx *ep_ctx;
-	struct xhci_ring *ring;		/* EP transfer ring */
-	union xhci_trb *event;
-
 	int running_total, trb_buff_len;
 	unsigned int total_packet_count;
 	int maxpacketsize;
-	u64 addr;
-	int ret;
+	int num_trbs = 0;
+	int start_cycle;
 	u32 trb_fields[4];
-	enum dma_data_direction direction;
-	void *bounce = ctrl->bounce_buffer;
-	dma_addr_t map;
-
-	/*
-	 * XHCI has the restriction that a single TRB may not cross a 64KiB
-	 * boundary. The U-Boot code we derived this from is somewhat prepared
-	 * for this, but it doesn't work, at least not for the case when a short
-	 * packet is received. For now just limit the maximum buffer length to
-	 * 64KiB and use a 64KiB aligned bounce buffer to make sure we do not
-	 * cross a boundary.
-	 */
-	if (length > SZ_64K)
-		return -EINVAL;
-
-	if (usb_pipein(pipe)) {
-		direction = DMA_FROM_DEVICE;
-	} else {
-		direction = DMA_TO_DEVICE;
-		memcpy(bounce, buffer, length);
-	}
-
-	map = addr = dma_map_single(ctrl->host.hw_dev, bounce, length, direction);
-
-	dev_dbg(&udev->dev, "pipe=0x%lx, buffer=%p, length=%d\n",
-		pipe, buffer, length);
-
-	ep_index = usb_pipe_ep_index(pipe);
-	virt_dev = ctrl->devs[slot_id];
+	u64 addr = td->map;
+	int ret;
 
-	xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
-			 virt_dev->out_ctx->size);
-
-	ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
+	ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, td->ep_index);
 
-	/*
-	 * If the endpoint was halted due to a prior error, resume it before
-	 * the next transfer. It is the responsibility of the upper layer to
-	 * have dealt with whatever caused the error.
-	 */
-	if ((le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK) == EP_STATE_HALTED)
-		reset_ep(udev, ep_index, timeout_ms);
-
-	ring = virt_dev->eps[ep_index].ring;
 	/*
 	 * How much data is (potentially) left before the 64KB boundary?
 	 * XHCI Spec puts restriction( TABLE 49 and 6.4.1 section of XHCI Spec)
@@ -729,17 +698,10 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		running_total += TRB_MAX_BUFF_SIZE;
 	}
 
-	/*
-	 * XXX: Calling routine prepare_ring() called in place of
-	 * prepare_trasfer() as there in 'Linux' since we are not
-	 * maintaining multiple TDs/transfer at the same time.
-	 */
 	ret = prepare_ring(ctrl, ring,
 			   le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK);
-	if (ret < 0) {
-		dma_unmap_single(ctrl->host.hw_dev, map, length, direction);
+	if (ret < 0)
 		return ret;
-	}
 
 	/*
 	 * Don't give the first TRB to the hardware (by toggling the cycle bit)
@@ -757,18 +719,15 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	if (trb_buff_len > length)
 		trb_buff_len = length;
 
-	first_trb = true;
-
-	/* flush the buffer before use */
-	xhci_flush_cache((uintptr_t)buffer, length);
+	td->num_trbs = 0;
 
 	/* Queue the first TRB, even if it's zero-length */
 	do {
 		u32 remainder = 0;
-		field = 0;
+		u32 field = 0;
+
 		/* Don't change the cycle bit of the first TRB until later */
-		if (first_trb) {
-			first_trb = false;
+		if (!td->num_trbs) {
 			if (start_cycle == 0)
 				field |= TRB_CYCLE;
 		} else {
@@ -784,7 +743,11 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		else
 			field |= TRB_IOC;
 
-		/* Only set interrupt on short packet for IN endpoints */
+		/*
+		 * Only set interrupt on short packet for IN endpoints. It is
+		 * set on every TRB, so a short packet always generates an
+		 * event telling us which TRB it ended in.
+		 */
 		if (usb_pipein(pipe))
 			field |= TRB_ISP;
 
@@ -798,16 +761,15 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 							   maxpacketsize,
 							   num_trbs - 1);
 
-		length_field = (TRB_LEN(trb_buff_len) |
-				remainder |
-				TRB_INTR_TARGET(0));
-
 		trb_fields[0] = lower_32_bits(addr);
 		trb_fields[1] = upper_32_bits(addr);
-		trb_fields[2] = length_field;
+		trb_fields[2] = TRB_LEN(trb_buff_len) | remainder |
+				TRB_INTR_TARGET(0);
 		trb_fields[3] = field | TRB_TYPE(TRB_NORMAL);
 
-		queue_trb(ctrl, ring, (num_trbs > 1), trb_fields);
+		td->trb_len[td->num_trbs] = trb_buff_len;
+		td->trb[td->num_trbs++] = queue_trb(ctrl, ring, (num_trbs > 1),
+						    trb_fields);
 
 		--num_trbs;
 
@@ -818,34 +780,263 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		trb_buff_len = min((length - running_total), TRB_MAX_BUFF_SIZE);
 	} while (running_total < length);
 
-	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+	giveback_first_trb(udev, td->ep_index, start_cycle, start_trb);
 
-	event = xhci_wait_for_event(ctrl, TRB_TRANSFER, timeout_ms);
-	if (!event) {
-		dev_dbg(&udev->dev, "XHCI bulk transfer timed out, aborting...\n");
-		abort_td(udev, ep_index);
-		udev->status = USB_ST_NAK_REC;  /* closest thing to a timeout */
-		udev->act_len = 0;
-		dma_unmap_single(ctrl->host.hw_dev, map, length, direction);
-		return -ETIMEDOUT;
+	return 0;
+}
+
+/*
+ * Find the TD a transfer event belongs to. TDs on an endpoint complete in
+ * order, so this can only be the oldest pending one. Events not matching
+ * one of its TRBs are left over from an earlier TD, like the success
+ * event some controllers send for the last TRB after a short packet.
+ */
+static struct xhci_bulk_td *xhci_bulk_find_td(struct xhci_bulk_td *tds,
+					      int num, union xhci_trb *event,
+					      int *trb)
+{
+	u32 field = le32_to_cpu(event->trans_event.flags);
+	dma_addr_t addr = le64_to_cpu(event->trans_event.buffer);
+	int i, j;
+
+	for (i = 0; i < num; i++) {
+		if (tds[i].done || tds[i].ep_index != TRB_TO_EP_INDEX(field))
+			continue;
+
+		for (j = 0; j < tds[i].num_trbs; j++) {
+			if (tds[i].trb[j] == addr) {
+				*trb = j;
+				return &tds[i];
+			}
+		}
+
+		break;
 	}
-	field = le32_to_cpu(event->trans_event.flags);
 
-	if (TRB_TO_SLOT_ID(field) != slot_id)
-		dev_err(&udev->dev, "Unexpected slot_id %d, expected %d\n",
-			TRB_TO_SLOT_ID(field), slot_id);
+	return NULL;
+}
 
-	if (TRB_TO_EP_INDEX(field) != ep_index)
-		dev_err(&udev->dev, "Unexpected ep_index %d, expected %d\n",
-			TRB_TO_EP_INDEX(field), ep_index);
+static void xhci_bulk_td_complete(struct xhci_bulk_td *td, int trb,
+				  union xhci_trb *event)
+{
+	u32 len = le32_to_cpu(event->trans_event.transfer_len);
+	int i, actual = 0;
 
-	record_transfer_result(udev, event, length);
-	xhci_acknowledge_event(ctrl);
+	/* the event reports the residue of the TRB the TD ended in */
+	for (i = 0; i < trb; i++)
+		actual += td->trb_len[i];
+	actual += td->trb_len[trb] - min(EVENT_TRB_LEN(len), td->trb_len[trb]);
 
-	dma_unmap_single(ctrl->host.hw_dev, map, length, direction);
+	td->xfer->actual_length = actual;
+	td->xfer->status = xhci_comp_to_status(GET_COMP_CODE(len));
+	td->done = true;
+}
 
-	if (usb_pipein(pipe))
-		memcpy(buffer, bounce, length);
+/**
+ * Queues up several BULK Requests
+ *
+ * All transfers are queued as separate TDs before waiting for the first one
+ * to complete, so the device doesn't have to wait for us between transfers,
+ * e.g. between the data and the status phase of a mass storage command.
+ * TDs queued on an endpoint behind a failed one are not done.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param xfers		the transfers, in the order they are done on the bus
+ * @param num		number of transfers
+ * @param timeout_ms	timeout for each transfer
+ * @return 0 if all TDs have completed, negative error code otherwise
+ */
+int xhci_bulk_tx_multi(struct usb_device *udev, struct usb_bulk_xfer *xfers,
+		       int num, unsigned int timeout_ms)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int slot_id = udev->slot_id;
+	struct xhci_virt_device *virt_dev = ctrl->devs[slot_id];
+	struct xhci_bulk_td *tds, *td;
+	union xhci_trb *event;
+	int i, j, trb, pending = 0;
+	size_t offset = 0;
+	int ret = 0;
+
+	/*
+	 * The bounce buffer is 64KiB aligned, so we only have to split TDs at
+	 * 64KiB boundaries of it. If the batch doesn't fit, do the transfers
+	 * one by one.
+	 */
+	for (i = 0; i < num; i++)
+		offset += ALIGN(xfers[i].len, DMA_ALIGNMENT);
+
+	if (offset > XHCI_BOUNCE_SIZE) {
+		if (num == 1)
+			return -EINVAL;
+
+		for (i = 0; i < num; i++) {
+			ret = xhci_bulk_tx_multi(udev, &xfers[i], 1, timeout_ms);
+			if (ret || xfers[i].status)
+				break;
+		}
+
+		return ret;
+	}
+
+	tds = xzalloc(num * sizeof(*tds));
+
+	for (i = 0, offset = 0; i < num; i++) {
+		td = &tds[i];
+		td->xfer = &xfers[i];
+		td->xfer->status = USB_ST_NOT_PROC;
+		td->xfer->actual_length = 0;
+		td->ep_index = usb_pipe_ep_index(xfers[i].pipe);
+		td->bounce = ctrl->bounce_buffer + offset;
+		offset += ALIGN(xfers[i].len, DMA_ALIGNMENT);
+
+		if (usb_pipein(xfers[i].pipe)) {
+			td->direction = DMA_FROM_DEVICE;
+		} else {
+			td->direction = DMA_TO_DEVICE;
+			memcpy(td->bounce, xfers[i].data, xfers[i].len);
+		}
+
+		td->map = dma_map_single(ctrl->host.hw_dev, td->bounce,
+					 xfers[i].len, td->direction);
+
+		dev_dbg(&udev->dev, "pipe=0x%lx, buffer=%p, length=%d\n",
+			xfers[i].pipe, xfers[i].data, xfers[i].len);
+	}
+
+	xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
+			 virt_dev->out_ctx->size);
+
+	/*
+	 * If an endpoint was halted due to a prior error, resume it before
+	 * the next transfer. It is the responsibility of the upper layer to
+	 * have dealt with whatever caused the error.
+	 */
+	for (i = 0; i < num; i++) {
+		struct xhci_ep_ctx *ep_ctx;
+
+		for (j = 0; j < i; j++)
+			if (tds[j].ep_index == tds[i].ep_index)
+				break;
+		if (j < i)
+			continue;
+
+		ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx,
+					 tds[i].ep_index);
+		if ((le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK) == EP_STATE_HALTED)
+			reset_ep(udev, tds[i].ep_index, timeout_ms);
+	}
+
+	for (i = 0; i < num; i++) {
+		ret = xhci_queue_bulk_td(udev, &tds[i]);
+		if (ret)
+			break;
+		pending++;
+	}
+
+	/* whatever could not be queued is not done */
+	for (j = i; j < num; j++)
+		tds[j].done = true;
+
+	while (pending) {
+		event = xhci_wait_for_event(ctrl, TRB_TRANSFER, timeout_ms);
+		if (!event) {
+			dev_dbg(&udev->dev, "XHCI bulk transfer timed out, aborting...\n");
+
+			for (i = 0; i < num; i++) {
+				if (tds[i].done)
+					continue;
+
+				abort_td(udev, tds[i].ep_index);
+
+				/* this threw away all TDs of the endpoint */
+				for (j = num - 1; j >= i; j--) {
+					if (tds[j].done ||
+					    tds[j].ep_index != tds[i].ep_index)
+						continue;
+					tds[j].done = true;
+					/* closest thing to a timeout */
+					tds[j].xfer->status = USB_ST_NAK_REC;
+				}
+			}
+
+			ret = -ETIMEDOUT;
+			break;
+		}
+
+		if (TRB_TO_SLOT_ID(le32_to_cpu(event->trans_event.flags)) != slot_id) {
+			dev_err(&udev->dev, "Unexpected slot_id %d, expected %d\n",
+				TRB_TO_SLOT_ID(le32_to_cpu(event->trans_event.flags)),
+				slot_id);
+			xhci_acknowledge_event(ctrl);
+			continue;
+		}
+
+		td = xhci_bulk_find_td(tds, num, event, &trb);
+		if (!td) {
+			dev_dbg(&udev->dev, "Skipping stale transfer event\n");
+			xhci_acknowledge_event(ctrl);
+			continue;
+		}
+
+		xhci_bulk_td_complete(td, trb, event);
+		xhci_acknowledge_event(ctrl);
+		pending--;
+
+		if (!td->xfer->status)
+			continue;
+
+		/* The endpoint halted, the TDs queued behind this one won't run */
+		for (j = td - tds + 1; j < num; j++) {
+			if (tds[j].done || tds[j].ep_index != td->ep_index)
+				continue;
+			tds[j].done = true;
+			pending--;
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		td = &tds[i];
+
+		dma_unmap_single(ctrl->host.hw_dev, td->map, td->xfer->len,
+				 td->direction);
+
+		if (td->direction == DMA_FROM_DEVICE &&
+		    td->xfer->status != USB_ST_NOT_PROC)
+			memcpy(td->xfer->data, td->bounce, td->xfer->actual_length);
+	}
+
+	free(tds);
+
+	return ret;
+}
+
+/**
+ * Queues up the BULK Request
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param length	length of the buffer
+ * @param buffer	buffer to be read/written based on the request
+ * @return returns 0 if successful else -1 on failure
+ */
+int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
+			int length, void *buffer, unsigned int timeout_ms)
+{
+	struct usb_bulk_xfer xfer = {
+		.pipe = pipe,
+		.data = buffer,
+		.len = length,
+	};
+	int ret;
+
+	ret = xhci_bulk_tx_multi(udev, &xfer, 1, timeout_ms);
+
+	udev->status = xfer.status;
+	udev->act_len = xfer.actual_length;
+
+	if (ret)
+		return ret;
 
 	return (udev->status != USB_ST_NOT_PROC) ? 0 : -1;
 }
@@ -1271,6 +1271,23 @@ static int xhci_submit_bulk_msg(struct usb_device *udev,
 	return _xhci_submit_bulk_msg(udev, pipe, buffer, length, timeout_ms);
 }
 
+static int xhci_submit_bulk_msgs(struct usb_device *udev,
+				 struct usb_bulk_xfer *xfers, int num,
+				 int timeout_ms)
+{
+	int i;
+
+	for (i = 0; i < num; i++) {
+		if (usb_pipetype(xfers[i].pipe) != PIPE_BULK) {
+			dev_err(&udev->dev, "non-bulk pipe (type=%lu)",
+				usb_pipetype(xfers[i].pipe));
+			return -EINVAL;
+		}
+	}
+
+	return xhci_bulk_tx_multi(udev, xfers, num, timeout_ms);
+}
+
 static int xhci_submit_int_msg(struct usb_device *udev,
 			       unsigned long pipe, void *buffer, int length,
 			       int interval)
@@ -1388,6 +1405,8 @@ int xhci_register(struct xhci_ctrl *ctrl)
 	host->submit_int_msg = xhci_submit_int_msg;
 	host->submit_control_msg = xhci_submit_control_msg;
 	host->submit_bulk_msg = xhci_submit_bulk_msg;
+	host->submit_bulk_msgs = xhci_submit_bulk_msgs;
+	host->max_bulk_size = XHCI_MAX_BULK_SIZE;
 	host->alloc_device = xhci_alloc_device;
 	host->update_hub_device = xhci_update_hub_device;
 
@@ -20,6 +20,7 @@
 #include <io.h>
 #include <io-64-nonatomic-lo-hi.h>
 #include <linux/list.h>
+#include <linux/sizes.h>
 
 #define MAX_EP_CTX_NUM		31
 #define XHCI_ALIGNMENT		64
@@ -1256,10 +1257,16 @@ void xhci_queue_command(struct xhci_ctrl *ctrl, dma_addr_t addr,
 			u32 slot_id, u32 ep_index, trb_type cmd);
 void xhci_acknowledge_event(struct xhci_ctrl *ctrl);
 #define XHCI_TIMEOUT_DEFAULT 5000
+/* largest single bulk transfer */
+#define XHCI_MAX_BULK_SIZE	SZ_256K
+/* room for a maximum sized bulk transfer and the small ones queued with it */
+#define XHCI_BOUNCE_SIZE	(XHCI_MAX_BULK_SIZE + SZ_4K)
 union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected,
 	unsigned int timeout_ms);
 int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		 int length, void *buffer, unsigned int timeout_ms);
+int xhci_bulk_tx_multi(struct usb_device *udev, struct usb_bulk_xfer *xfers,
+		       int num, unsigned int timeout_ms);
 int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 		 struct devrequest *req, int length, void *buffer, unsigned int timeout_ms);
 int xhci_check_maxpacket(struct usb_device *udev);
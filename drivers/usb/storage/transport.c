@@ -80,51 +80,53 @@ int usb_stor_Bulk_max_lun(struct us_data *us)
 	return ret;
 }
 
-int usb_stor_Bulk_transport(struct us_blk_dev *usb_blkdev,
-			    const u8 *cmd, u8 cmdlen,
-			    void *data, u32 datalen)
+/* Read the CSW, clearing a stall on the bulk-in endpoint first */
+static int usb_stor_Bulk_read_csw(struct us_data *us, struct bulk_cs_wrap *csw)
 {
-	struct us_data *us = usb_blkdev->us;
 	struct device *dev = &us->pusb_dev->dev;
-	struct bulk_cb_wrap *cbw;
-	struct bulk_cs_wrap *csw;
-	int actlen, data_actlen;
-	int result;
-	unsigned int residue;
 	unsigned int pipein = usb_rcvbulkpipe(us->pusb_dev, us->recv_bulk_ep);
-	unsigned int pipeout = usb_sndbulkpipe(us->pusb_dev, us->send_bulk_ep);
-	int dir_in = US_DIRECTION(cmd[0]);
-	int ret = 0;
+	int actlen;
+	int result;
 
-	cbw = dma_alloc(sizeof(*cbw));
-	csw = dma_alloc(sizeof(*csw));
+	dev_dbg(dev, "Attempting to get CSW...\n");
+	result = usb_bulk_msg(us->pusb_dev, pipein, csw, US_BULK_CS_WRAP_LEN,
+	                      &actlen, USB_BULK_TO);
 
-	/* set up the command wrapper */
-	cbw->Signature = cpu_to_le32(US_BULK_CB_SIGN);
-	cbw->DataTransferLength = cpu_to_le32(datalen);
-	cbw->Flags = (dir_in ? US_BULK_FLAG_IN : US_BULK_FLAG_OUT);
-	cbw->Tag = ++cbw_tag;
-	cbw->Lun = usb_blkdev->lun;
-	cbw->Length = cmdlen;
+	/* did the endpoint stall? */
+	if ((result < 0) && (us->pusb_dev->status & USB_ST_STALLED)) {
+		dev_dbg(dev, "STATUS: stall\n");
+		/* clear the STALL on the endpoint */
+		result = usb_stor_Bulk_clear_endpt_stall(us, pipein);
+		if (result >= 0) {
+			dev_dbg(dev, "Attempting to get CSW...\n");
+			result = usb_bulk_msg(us->pusb_dev, pipein,
+			                      csw, US_BULK_CS_WRAP_LEN,
+			                      &actlen, USB_BULK_TO);
+		}
+	}
 
-	/* copy the command payload */
-	memset(cbw->CDB, 0, sizeof(cbw->CDB));
-	memcpy(cbw->CDB, cmd, cbw->Length);
+	if (result < 0)
+		dev_dbg(dev, "Device status: %lx\n", us->pusb_dev->status);
+
+	return result;
+}
+
+/* Do the command, data and status phase one after another */
+static int usb_stor_Bulk_phases(struct us_data *us, struct bulk_cb_wrap *cbw,
+				struct bulk_cs_wrap *csw, void *data,
+				u32 datalen, int dir_in)
+{
+	struct device *dev = &us->pusb_dev->dev;
+	unsigned int pipein = usb_rcvbulkpipe(us->pusb_dev, us->recv_bulk_ep);
+	unsigned int pipeout = usb_sndbulkpipe(us->pusb_dev, us->send_bulk_ep);
+	int actlen, data_actlen;
+	int result;
 
-	/* send it to out endpoint */
-	dev_dbg(dev, "Bulk Command S 0x%x T 0x%x L %d F %d Trg %d LUN %d CL %d\n",
-		le32_to_cpu(cbw->Signature), cbw->Tag,
-		le32_to_cpu(cbw->DataTransferLength), cbw->Flags,
-		(cbw->Lun >> 4), (cbw->Lun & 0x0F),
-		cbw->Length);
 	result = usb_bulk_msg(us->pusb_dev, pipeout, cbw, US_BULK_CB_WRAP_LEN,
 			      &actlen, USB_BULK_TO);
 	dev_dbg(dev, "Bulk command transfer result=%d\n", result);
-	if (result < 0) {
-		usb_stor_Bulk_reset(us);
-		ret = USB_STOR_TRANSPORT_FAILED;
-		goto fail;
-	}
+	if (result < 0)
+		return result;
 
 	/* DATA STAGE */
 	/* send/receive data payload, if there is any */
@@ -145,32 +147,125 @@ int usb_stor_Bulk_transport(struct us_blk_dev *usb_blkdev,
 		}
 		if (result < 0) {
 			dev_dbg(dev, "Device status: %lx\n", us->pusb_dev->status);
-			usb_stor_Bulk_reset(us);
-			ret = USB_STOR_TRANSPORT_FAILED;
-			goto fail;
+			return result;
 		}
 	}
 
 	/* STATUS phase + error handling */
-	dev_dbg(dev, "Attempting to get CSW...\n");
-	result = usb_bulk_msg(us->pusb_dev, pipein, csw, US_BULK_CS_WRAP_LEN,
-	                      &actlen, USB_BULK_TO);
+	return usb_stor_Bulk_read_csw(us, csw);
+}
 
-	/* did the endpoint stall? */
-	if ((result < 0) && (us->pusb_dev->status & USB_ST_STALLED)) {
-		dev_dbg(dev, "STATUS: stall\n");
-		/* clear the STALL on the endpoint */
-		result = usb_stor_Bulk_clear_endpt_stall(us, pipein);
-		if (result >= 0) {
-			dev_dbg(dev, "Attempting to get CSW...\n");
-			result = usb_bulk_msg(us->pusb_dev, pipein,
-			                      csw, US_BULK_CS_WRAP_LEN,
-			                      &actlen, USB_BULK_TO);
+/*
+ * Queue the command, data and status phase at once, so the host controller
+ * goes on with the next phase without waiting for us in between.
+ */
+static int usb_stor_Bulk_queued(struct us_data *us, struct bulk_cb_wrap *cbw,
+				struct bulk_cs_wrap *csw, void *data,
+				u32 datalen, int dir_in)
+{
+	struct device *dev = &us->pusb_dev->dev;
+	unsigned int pipein = usb_rcvbulkpipe(us->pusb_dev, us->recv_bulk_ep);
+	unsigned int pipeout = usb_sndbulkpipe(us->pusb_dev, us->send_bulk_ep);
+	struct usb_bulk_xfer xfers[3], *xfer_data = NULL, *xfer_csw;
+	int num = 0;
+	int result;
+
+	xfers[num++] = (struct usb_bulk_xfer) {
+		.pipe = pipeout,
+		.data = cbw,
+		.len = US_BULK_CB_WRAP_LEN,
+	};
+
+	if (datalen) {
+		xfer_data = &xfers[num++];
+		*xfer_data = (struct usb_bulk_xfer) {
+			.pipe = dir_in ? pipein : pipeout,
+			.data = data,
+			.len = datalen,
+		};
+	}
+
+	xfer_csw = &xfers[num++];
+	*xfer_csw = (struct usb_bulk_xfer) {
+		.pipe = pipein,
+		.data = csw,
+		.len = US_BULK_CS_WRAP_LEN,
+	};
+
+	result = usb_bulk_msgs(us->pusb_dev, xfers, num, USB_BULK_TO);
+	dev_dbg(dev, "Bulk transfer result=%d\n", result);
+	if (!result)
+		return 0;
+
+	if (xfers[0].status) {
+		dev_dbg(dev, "Bulk command transfer failed: %lx\n",
+			xfers[0].status);
+		return -EIO;
+	}
+
+	/* special handling of STALL in DATA phase */
+	if (xfer_data && xfer_data->status) {
+		if (!(xfer_data->status & USB_ST_STALLED)) {
+			dev_dbg(dev, "Device status: %lx\n", xfer_data->status);
+			return -EIO;
 		}
+
+		dev_dbg(dev, "DATA: stall\n");
+		/* clear the STALL on the endpoint */
+		result = usb_stor_Bulk_clear_endpt_stall(us, xfer_data->pipe);
+		if (result < 0)
+			return result;
 	}
 
+	/* The CSW may already have arrived, or not have been tried at all */
+	if (!xfer_csw->status)
+		return 0;
+
+	return usb_stor_Bulk_read_csw(us, csw);
+}
+
+int usb_stor_Bulk_transport(struct us_blk_dev *usb_blkdev,
+			    const u8 *cmd, u8 cmdlen,
+			    void *data, u32 datalen)
+{
+	struct us_data *us = usb_blkdev->us;
+	struct device *dev = &us->pusb_dev->dev;
+	struct bulk_cb_wrap *cbw;
+	struct bulk_cs_wrap *csw;
+	int result;
+	unsigned int residue;
+	int dir_in = US_DIRECTION(cmd[0]);
+	int ret = 0;
+
+	cbw = dma_alloc(sizeof(*cbw));
+	csw = dma_alloc(sizeof(*csw));
+
+	/* set up the command wrapper */
+	cbw->Signature = cpu_to_le32(US_BULK_CB_SIGN);
+	cbw->DataTransferLength = cpu_to_le32(datalen);
+	cbw->Flags = (dir_in ? US_BULK_FLAG_IN : US_BULK_FLAG_OUT);
+	cbw->Tag = ++cbw_tag;
+	cbw->Lun = usb_blkdev->lun;
+	cbw->Length = cmdlen;
+
+	/* copy the command payload */
+	memset(cbw->CDB, 0, sizeof(cbw->CDB));
+	memcpy(cbw->CDB, cmd, cbw->Length);
+
+	/* send it to out endpoint */
+	dev_dbg(dev, "Bulk Command S 0x%x T 0x%x L %d F %d Trg %d LUN %d CL %d\n",
+		le32_to_cpu(cbw->Signature), cbw->Tag,
+		le32_to_cpu(cbw->DataTransferLength), cbw->Flags,
+		(cbw->Lun >> 4), (cbw->Lun & 0x0F),
+		cbw->Length);
+
+	if (usb_host_queues_bulk(us->pusb_dev))
+		result = usb_stor_Bulk_queued(us, cbw, csw, data, datalen,
+					      dir_in);
+	else
+		result = usb_stor_Bulk_phases(us, cbw, csw, data, datalen,
+					      dir_in);
 	if (result < 0) {
-		dev_dbg(dev, "Device status: %lx\n", us->pusb_dev->status);
 		usb_stor_Bulk_reset(us);
 		ret = USB_STOR_TRANSPORT_FAILED;
 		goto fail;
@@ -268,6 +268,17 @@ static int usb_stor_io_10(struct us_blk_dev *usb_blkdev, u8 opcode,
 
 #define US_MAX_IO_BLK 32
 
+/* Number of sectors to transfer with a single READ/WRITE command */
+static u16 usb_stor_max_io_blk(struct us_data *us)
+{
+	size_t max = us->pusb_dev->host->max_bulk_size;
+
+	if (!max)
+		return US_MAX_IO_BLK;
+
+	return min_t(size_t, max / SECTOR_SIZE, U16_MAX);
+}
+
 /* Read / write a chunk of sectors on media */
 static int usb_stor_blk_io(struct block_device *disk_dev,
 			   sector_t sector_start, blkcnt_t sector_count, void *buffer,
@@ -278,6 +289,7 @@ static int usb_stor_blk_io(struct block_device *disk_dev,
 						   blk);
 	struct us_data *us = pblk_dev->us;
 	struct device *dev = &us->pusb_dev->dev;
+	u16 max_blk = usb_stor_max_io_blk(us);
 	int result;
 
 	/* ensure unit ready */
@@ -293,7 +305,7 @@ static int usb_stor_blk_io(struct block_device *disk_dev,
 		sector_count, sector_start);
 
 	while (sector_count > 0) {
-		u16 n = min_t(blkcnt_t, sector_count, US_MAX_IO_BLK);
+		u16 n = min_t(blkcnt_t, sector_count, max_blk);
 
 		if (disk_dev->num_blocks > 0xffffffff) {
 			result = usb_stor_io_16(pblk_dev,
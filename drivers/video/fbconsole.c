@@ -7,6 +7,9 @@
 #include <malloc.h>
 #include <getopt.h>
 #include <fb.h>
+#include <clock.h>
+#include <poller.h>
+#include <linux/bitmap.h>
 #include <gui/image_renderer.h>
 #include <gui/graphic_utils.h>
 #include <linux/font.h>
@@ -39,6 +42,23 @@ enum ansi_color {
 
 #define DEFAULT_COLOR	WHITE
 
+/* number of (fg, bg) color pairs with pre-rendered glyphs */
+#define FBC_ATLAS_SLOTS		4
+
+/* how long changes may stay in the render buffer before they are flushed */
+#define FBC_FLUSH_DELAY		(20 * MSECOND)
+
+/*
+ * Glyphs pre-rendered in the native pixel format and rotation of the
+ * framebuffer for one color pair, so that drawing a character is a
+ * memcpy per line.
+ */
+struct fbc_atlas {
+	int color, bgcolor;	/* -1 if the slot is unused */
+	void *glyphs;
+	DECLARE_BITMAP(rendered, 256);
+};
+
 struct fbc_priv {
 	struct console_device cdev;
 	struct fb_info *fb;
@@ -76,6 +96,21 @@ struct fbc_priv {
 
 	int active;
 	int in_console;
+	bool cursor_drawn;
+
+	struct fbc_atlas atlas[FBC_ATLAS_SLOTS];
+	unsigned int atlas_next;
+
+	/* area of the render buffer not yet blitted to the screen */
+	struct fb_rect dirty;
+	struct poller_async flush_poller;
+
+	/*
+	 * With a shadow framebuffer, scrolling doesn't move the render buffer
+	 * contents. Instead, the text rows are used as a ring starting at this
+	 * row, which is unrolled once before the screen is updated.
+	 */
+	unsigned int ring_top;
 };
 
 static int fbc_getc(struct console_device *cdev)
@@ -88,6 +123,28 @@ static int fbc_tstc(struct console_device *cdev)
 	return 0;
 }
 
+static void fbc_damage(struct fbc_priv *priv, int x, int y, int width,
+		       int height)
+{
+	struct fb_rect *d = &priv->dirty;
+
+	x += priv->margin.left;
+	y += priv->margin.top;
+
+	if (d->x2 <= d->x1) {
+		d->x1 = x;
+		d->y1 = y;
+		d->x2 = x + width;
+		d->y2 = y + height;
+		return;
+	}
+
+	d->x1 = min_t(u32, d->x1, x);
+	d->y1 = min_t(u32, d->y1, y);
+	d->x2 = max_t(u32, d->x2, x + width);
+	d->y2 = max_t(u32, d->y2, y + height);
+}
+
 static void cls(struct fbc_priv *priv)
 {
 	void *buf = gui_screen_render_buffer(priv->sc);
@@ -109,8 +166,11 @@ static void cls(struct fbc_priv *priv)
 			adr += priv->fb->line_length;
 		}
 	}
-	gu_screen_blit_area(priv->sc, priv->margin.left, priv->margin.top,
-			    width, height);
+
+	priv->ring_top = 0;
+	priv->cursor_drawn = false;
+
+	fbc_damage(priv, 0, 0, width, height);
 }
 
 struct rgb {
@@ -136,26 +196,149 @@ static struct rgb colors[] = {
 	[BRIGHT + WHITE]	= { 255, 255, 255 },
 };
 
+/*
+ * The screen area of the character cell at @x/@y relative to the margins.
+ * Row @y is mapped through the scroll ring.
+ */
+static void fbc_cell(struct fbc_priv *priv, int x, int y, int *startx,
+		     int *starty, int *width, int *height)
+{
+	int fw = priv->font->width;
+	int fh = priv->font->height;
+
+	switch (priv->rotation) {
+	case FBCONSOLE_ROTATE_0:
+		y = (y + priv->ring_top) % priv->rows;
+		*startx = x * fw;
+		*starty = y * fh;
+		*width = fw;
+		*height = fh;
+		break;
+	case FBCONSOLE_ROTATE_90:
+		*startx = (priv->rows - y - 1) * fh;
+		*starty = x * fw;
+		*width = fh;
+		*height = fw;
+		break;
+	case FBCONSOLE_ROTATE_180:
+		*startx = (priv->cols - x - 1) * fw;
+		*starty = (priv->rows - y - 1) * fh;
+		*width = fw;
+		*height = fh;
+		break;
+	case FBCONSOLE_ROTATE_270:
+	default:
+		*startx = y * fh;
+		*starty = (priv->cols - x - 1) * fw;
+		*width = fh;
+		*height = fw;
+		break;
+	}
+}
+
+/* render a glyph into a character cell at @dst, rotated as the console */
+static void fbc_render_glyph(struct fbc_priv *priv, int c, void *dst,
+			     int pitch, u32 color, u32 bgcolor)
+{
+	const struct font_desc *font = priv->font;
+	const uint8_t *inbuf = font->data + find_font_index(font, c);
+	int bpp = priv->fb->bits_per_pixel >> 3;
+	int fw = font->width;
+	int fh = font->height;
+	int i, j, sx, sy;
+
+	for (i = 0; i < fh; i++) {
+		for (j = 0; j < fw; j++) {
+			bool set = inbuf[j / 8] & (0x80 >> (j % 8));
+
+			switch (priv->rotation) {
+			case FBCONSOLE_ROTATE_0:
+				sx = j;
+				sy = i;
+				break;
+			case FBCONSOLE_ROTATE_90:
+				sx = fh - 1 - i;
+				sy = j;
+				break;
+			case FBCONSOLE_ROTATE_180:
+				sx = fw - 1 - j;
+				sy = fh - 1 - i;
+				break;
+			case FBCONSOLE_ROTATE_270:
+			default:
+				sx = i;
+				sy = fw - 1 - j;
+				break;
+			}
+
+			gu_set_pixel(priv->fb, dst + sy * pitch + sx * bpp,
+				     set ? color : bgcolor);
+		}
+
+		inbuf += DIV_ROUND_UP(fw, 8);
+	}
+}
+
+static void fbc_atlas_release(struct fbc_priv *priv)
+{
+	int i;
+
+	for (i = 0; i < FBC_ATLAS_SLOTS; i++) {
+		free(priv->atlas[i].glyphs);
+		priv->atlas[i].glyphs = NULL;
+		priv->atlas[i].color = -1;
+		priv->atlas[i].bgcolor = -1;
+	}
+}
+
+static struct fbc_atlas *fbc_atlas_get(struct fbc_priv *priv, int color,
+				       int bgcolor)
+{
+	struct fbc_atlas *atlas;
+	size_t size;
+	int i;
+
+	for (i = 0; i < FBC_ATLAS_SLOTS; i++) {
+		atlas = &priv->atlas[i];
+		if (atlas->glyphs && atlas->color == color &&
+		    atlas->bgcolor == bgcolor)
+			return atlas;
+	}
+
+	atlas = &priv->atlas[priv->atlas_next];
+	priv->atlas_next = (priv->atlas_next + 1) % FBC_ATLAS_SLOTS;
+
+	if (!atlas->glyphs) {
+		size = priv->font->width * priv->font->height *
+			(priv->fb->bits_per_pixel >> 3);
+		atlas->glyphs = malloc(size * 256);
+		if (!atlas->glyphs)
+			return NULL;
+	}
+
+	atlas->color = color;
+	atlas->bgcolor = bgcolor;
+	bitmap_zero(atlas->rendered, 256);
+
+	return atlas;
+}
+
 static void drawchar(struct fbc_priv *priv, int x, int y, int c)
 {
 	void *buf;
 	int bpp = priv->fb->bits_per_pixel >> 3;
 	void *adr;
 	int i;
-	const uint8_t *inbuf;
 	int line_length;
-	u32 color, bgcolor;
+	int color, bgcolor;
+	u32 pixel, bgpixel;
 	struct rgb *rgb;
-	int xstep;
-	int ystep;
-	int startx;
-	int starty;
+	struct fbc_atlas *atlas;
+	const void *glyph;
+	int startx, starty, width, height;
 
 	buf = gui_screen_render_buffer(priv->sc);
 
-	i = find_font_index(priv->font, c);
-	inbuf = priv->font->data + i;
-
 	line_length = priv->fb->line_length;
 
 	color = priv->flags & ANSI_FLAG_INVERT ? priv->bgcolor : priv->color;
@@ -164,164 +347,173 @@ static void drawchar(struct fbc_priv *priv, int x, int y, int c)
 	if (priv->flags & ANSI_FLAG_BRIGHT)
 		color += BRIGHT;
 
-	rgb = &colors[color];
-	color = gu_rgb_to_pixel(priv->fb, rgb->r, rgb->g, rgb->b, 0xff);
-
-	rgb = &colors[bgcolor];
-	bgcolor = gu_rgb_to_pixel(priv->fb, rgb->r, rgb->g, rgb->b, 0x0);
+	fbc_cell(priv, x, y, &startx, &starty, &width, &height);
 
 	adr = buf;
-
-	switch (priv->rotation) {
-	case FBCONSOLE_ROTATE_0:
-		xstep = bpp;
-		ystep = line_length;
-		startx = x * priv->font->width;
-		starty = y * priv->font->height;
-		break;
-	case FBCONSOLE_ROTATE_90:
-		xstep = line_length;
-		ystep = -bpp;
-		startx = (priv->rows - y) * priv->font->height - 1;
-		starty = x * priv->font->width;
-		break;
-	case FBCONSOLE_ROTATE_180:
-		xstep = -bpp;
-		ystep = -line_length;
-		startx = (priv->cols - x) * priv->font->width - 1;
-		starty = (priv->rows - y) * priv->font->height - 1;
-		break;
-	case FBCONSOLE_ROTATE_270:
-		xstep = -line_length;
-		ystep = bpp;
-		startx = priv->font->height * y;
-		starty = (priv->cols - x) * priv->font->width - 1;
-		break;
-	default:
-		return;
-	}
-
 	adr += (priv->margin.left + startx) * bpp;
 	adr += (priv->margin.top + starty) * line_length;
 
-	for (i = 0; i < priv->font->height; i++) {
-		uint8_t mask = 0x80;
-		int j;
-
-		for (j = 0; j < priv->font->width; j++) {
-			if (!mask) {
-				inbuf++;
-				mask = 0x80;
-			}
+	fbc_damage(priv, startx, starty, width, height);
 
-			if (*inbuf & mask)
-				gu_set_pixel(priv->fb, adr + j * xstep, color);
-			else
-				gu_set_pixel(priv->fb, adr + j * xstep, bgcolor);
+	c = (unsigned char)c;
 
-			mask >>= 1;
+	atlas = fbc_atlas_get(priv, color, bgcolor);
+	if (atlas && test_bit(c, atlas->rendered)) {
+		glyph = atlas->glyphs + c * width * height * bpp;
 
+		for (i = 0; i < height; i++) {
+			memcpy(adr, glyph, width * bpp);
+			adr += line_length;
+			glyph += width * bpp;
 		}
 
-		adr += ystep;
-
-		inbuf++;
-		mask = 0x80;
+		return;
 	}
-}
 
-static void fb_blit_area(struct fbc_priv *priv, int x, int y)
-{
-	int startx, starty, width, height, fw, fh;
-	int mx, my;
-
-	mx = priv->margin.left;
-	my = priv->margin.top;
+	rgb = &colors[color];
+	pixel = gu_rgb_to_pixel(priv->fb, rgb->r, rgb->g, rgb->b, 0xff);
 
-	fw = priv->font->width;
-	fh = priv->font->height;
+	rgb = &colors[bgcolor];
+	bgpixel = gu_rgb_to_pixel(priv->fb, rgb->r, rgb->g, rgb->b, 0x0);
 
-	switch (priv->rotation) {
-	case FBCONSOLE_ROTATE_0:
-		startx = mx + x * fw;
-		starty = my + y * fh;
-		width = fw;
-		height = fh;
-		break;
-	case FBCONSOLE_ROTATE_90:
-		startx = mx + (priv->rows - y - 1) * fh;
-		starty = my + x * fw;
-		width = fh;
-		height = fw;
-		break;
-	case FBCONSOLE_ROTATE_180:
-		startx = mx + (priv->cols - x - 1) * fw;
-		starty = my + (priv->rows - y - 1) * fh;
-		width = fw;
-		height = fh;
-		break;
-	case FBCONSOLE_ROTATE_270:
-		startx = mx + y * fh;
-		starty = my + (priv->cols - x - 1) * fw;
-		width = fh;
-		height = fw;
-		break;
-	default:
+	if (!atlas) {
+		/* no memory for the atlas, draw directly */
+		fbc_render_glyph(priv, c, adr, line_length, pixel, bgpixel);
 		return;
 	}
 
-	gu_screen_blit_area(priv->sc, startx, starty, width, height);
+	glyph = atlas->glyphs + c * width * height * bpp;
+	fbc_render_glyph(priv, c, (void *)glyph, width * bpp, pixel, bgpixel);
+	__set_bit(c, atlas->rendered);
+
+	for (i = 0; i < height; i++) {
+		memcpy(adr, glyph, width * bpp);
+		adr += line_length;
+		glyph += width * bpp;
+	}
 }
 
 static void video_invertchar(struct fbc_priv *priv, int x, int y)
 {
-	int startx, starty, width, height, fw, fh;
+	int startx, starty, width, height;
 	void *buf;
 
 	buf = gui_screen_render_buffer(priv->sc);
 	buf += priv->margin.top * priv->fb->line_length;
 	buf += priv->margin.left * (priv->fb->bits_per_pixel >> 3);
 
-	fw = priv->font->width;
-	fh = priv->font->height;
+	fbc_cell(priv, x, y, &startx, &starty, &width, &height);
 
-	switch (priv->rotation) {
-	case FBCONSOLE_ROTATE_0:
-		startx = x * fw;
-		starty = y * fh;
-		width = fw;
-		height = fh;
-		break;
-	case FBCONSOLE_ROTATE_90:
-		startx = (priv->rows - y - 1) * fh;
-		starty = x * fw;
-		width = fh;
-		height = fw;
-		break;
-	case FBCONSOLE_ROTATE_180:
-		startx = (priv->cols - x - 1) * fw;
-		starty = (priv->rows - y - 1) * fh;
-		width = fw;
-		height = fh;
-		break;
-	case FBCONSOLE_ROTATE_270:
-		startx = y * fh;
-		starty = (priv->cols - x - 1) * fw;
-		width = fh;
-		height = fw;
-		break;
-	default:
+	gu_invert_area(priv->fb, buf, startx, starty, width, height);
+	fbc_damage(priv, startx, starty, width, height);
+}
+
+static void fbc_hide_cursor(struct fbc_priv *priv)
+{
+	if (!priv->cursor_drawn)
+		return;
+
+	video_invertchar(priv, priv->x, priv->y);
+	priv->cursor_drawn = false;
+}
+
+static void fbc_show_cursor(struct fbc_priv *priv)
+{
+	if (priv->cursor_drawn || (priv->flags & HIDE_CURSOR))
 		return;
+
+	video_invertchar(priv, priv->x, priv->y);
+	priv->cursor_drawn = true;
+}
+
+/* rotate the text rows back into order, so that the ring starts at row 0 */
+static void fbc_ring_unroll(struct fbc_priv *priv)
+{
+	size_t line_height = priv->fb->line_length * priv->font->height;
+	size_t total = line_height * priv->rows;
+	size_t ofs = line_height * priv->ring_top;
+	void *adr, *tmp;
+	int i;
+
+	adr = gui_screen_render_buffer(priv->sc);
+	adr += priv->margin.top * priv->fb->line_length;
+
+	tmp = malloc(ofs);
+	if (tmp) {
+		memcpy(tmp, adr, ofs);
+		memmove(adr, adr + ofs, total - ofs);
+		memcpy(adr + total - ofs, tmp, ofs);
+	} else {
+		/* low on memory, rotate one text row at a time */
+		tmp = xmalloc(line_height);
+
+		for (i = 0; i < priv->ring_top; i++) {
+			memcpy(tmp, adr, line_height);
+			memmove(adr, adr + line_height, total - line_height);
+			memcpy(adr + total - line_height, tmp, line_height);
+		}
 	}
 
-	gu_invert_area(priv->fb, buf, startx, starty, width, height);
-	fb_blit_area(priv, x, y);
+	free(tmp);
+
+	priv->ring_top = 0;
+}
+
+static void fbc_flush(struct fbc_priv *priv)
+{
+	struct fb_rect *d = &priv->dirty;
+
+	if (priv->ring_top)
+		fbc_ring_unroll(priv);
+
+	if (d->x2 > d->x1)
+		gu_screen_blit_area(priv->sc, d->x1, d->y1,
+				    fb_rect_width(d), fb_rect_height(d));
+
+	memset(d, 0, sizeof(*d));
+
+	fb_flush(priv->fb);
 }
 
-static void show_cursor(struct fbc_priv *priv, int x, int y)
+static void fbc_flush_async(void *ctx)
 {
-	if (!(priv->flags & HIDE_CURSOR))
-		video_invertchar(priv, x, y);
+	struct fbc_priv *priv = ctx;
+
+	if (priv->in_console) {
+		poller_call_async(&priv->flush_poller, FBC_FLUSH_DELAY,
+				  fbc_flush_async, priv);
+		return;
+	}
+
+	if (priv->active)
+		fbc_flush(priv);
+}
+
+/*
+ * Called after writing to the console. The screen is updated from a poller
+ * shortly after, so that a burst of output only updates it once. When no
+ * pollers run in the meantime, it's updated on a later write.
+ */
+static void fbc_write_done(struct fbc_priv *priv)
+{
+	struct poller_async *pa = &priv->flush_poller;
+
+	fbc_show_cursor(priv);
+
+	if (IS_ENABLED(CONFIG_POLLER)) {
+		if (!poller_async_active(pa)) {
+			poller_call_async(pa, FBC_FLUSH_DELAY, fbc_flush_async,
+					  priv);
+			return;
+		}
+
+		if (get_time_ns() < pa->end)
+			return;
+
+		poller_async_cancel(pa);
+	}
+
+	fbc_flush(priv);
 }
 
 static void fb_scroll_up_0(struct fbc_priv *priv, void *adr, int width, int height)
@@ -330,6 +522,13 @@ static void fb_scroll_up_0(struct fbc_priv *priv, void *adr, int width, int heig
 	int line_height = line_length * priv->font->height;
 
 	if (!priv->margin.left && !priv->margin.right) {
+		if (priv->fb->screen_base_shadow) {
+			/* reuse the top row as the new bottom row */
+			memset(adr + line_height * priv->ring_top, 0, line_height);
+			priv->ring_top = (priv->ring_top + 1) % priv->rows;
+			return;
+		}
+
 		memcpy(adr, adr + line_height, line_height * (priv->rows - 1));
 		memset(adr + line_height * (priv->rows - 1), 0, line_height);
 	} else {
@@ -432,13 +631,12 @@ static void fb_scroll_up(struct fbc_priv *priv)
 		break;
 	}
 
-	gu_screen_blit_area(priv->sc, priv->margin.left, priv->margin.top,
-			    width, height);
+	fbc_damage(priv, 0, 0, width, height);
 }
 
 static void printchar(struct fbc_priv *priv, int c)
 {
-	video_invertchar(priv, priv->x, priv->y);
+	fbc_hide_cursor(priv);
 
 	switch (c) {
 	case '\007': /* bell: ignore */
@@ -466,7 +664,6 @@ static void printchar(struct fbc_priv *priv, int c)
 
 	default:
 		drawchar(priv, priv->x, priv->y, c);
-		fb_blit_area(priv, priv->x, priv->y);
 
 		priv->x++;
 		if (priv->x >= priv->cols) {
@@ -479,10 +676,6 @@ static void printchar(struct fbc_priv *priv, int c)
 		fb_scroll_up(priv);
 		priv->y = priv->rows - 1;
 	}
-
-	show_cursor(priv, priv->x, priv->y);
-
-	return;
 }
 
 static void fbc_parse_colors(struct fbc_priv *priv)
@@ -551,12 +744,7 @@ static void fbc_parse_csi(struct fbc_priv *priv)
 		switch (priv->csi_cmd) {
 		case '?': /* cursor visible */
 			priv->csi_cmd = -1;
-			if (!(priv->flags & HIDE_CURSOR))
-				break;
-
 			priv->flags &= ~HIDE_CURSOR;
-			/* show cursor now */
-			show_cursor(priv, priv->x, priv->y);
 			break;
 		}
 		break;
@@ -567,7 +755,7 @@ static void fbc_parse_csi(struct fbc_priv *priv)
 			priv->csi_cmd = -1;
 
 			/* hide cursor now */
-			video_invertchar(priv, priv->x, priv->y);
+			fbc_hide_cursor(priv);
 			priv->flags |= HIDE_CURSOR;
 
 			break;
@@ -575,22 +763,19 @@ static void fbc_parse_csi(struct fbc_priv *priv)
 		break;
 	case 'J':
 		cls(priv);
-		show_cursor(priv, priv->x, priv->y);
 		return;
 	case 'H':
-		show_cursor(priv, priv->x, priv->y);
+		fbc_hide_cursor(priv);
 
 		pos = simple_strtoul(priv->csi, &end, 10);
 		priv->y = clamp(pos - 1, 0, (int) priv->rows - 1);
 
 		pos = simple_strtoul(end + 1, NULL, 10);
 		priv->x = clamp(pos - 1, 0, (int) priv->cols - 1);
-
-		show_cursor(priv, priv->x, priv->y);
 		break;
 	case 'K':
 		pos = simple_strtoul(priv->csi, &end, 10);
-		video_invertchar(priv, priv->x, priv->y);
+		fbc_hide_cursor(priv);
 		switch (pos) {
 		case 0:
 			for (i = priv->x; i < priv->cols; i++)
@@ -601,22 +786,12 @@ static void fbc_parse_csi(struct fbc_priv *priv)
 				drawchar(priv, i, priv->y, ' ');
 			break;
 		}
-		video_invertchar(priv, priv->x, priv->y);
-
 		break;
 	}
 }
 
-static void fbc_putc(struct console_device *cdev, char c)
+static void fbc_process(struct fbc_priv *priv, char c)
 {
-	struct fbc_priv *priv = container_of(cdev,
-					struct fbc_priv, cdev);
-	struct fb_info *fb = priv->fb;
-
-	if (priv->in_console)
-		return;
-	priv->in_console = 1;
-
 	switch (priv->state) {
 	case LIT:
 		switch (c) {
@@ -669,9 +844,58 @@ static void fbc_putc(struct console_device *cdev, char c)
 		break;
 
 	}
+}
+
+static void fbc_putc(struct console_device *cdev, char c)
+{
+	struct fbc_priv *priv = container_of(cdev,
+					struct fbc_priv, cdev);
+
+	if (priv->in_console)
+		return;
+	priv->in_console = 1;
+
+	fbc_process(priv, c);
+	fbc_write_done(priv);
+
+	priv->in_console = 0;
+}
+
+static int fbc_puts(struct console_device *cdev, const char *s, size_t nbytes)
+{
+	struct fbc_priv *priv = container_of(cdev,
+					struct fbc_priv, cdev);
+	size_t i;
+
+	if (priv->in_console)
+		return 0;
+	priv->in_console = 1;
+
+	for (i = 0; i < nbytes; i++) {
+		if (s[i] == '\n')
+			fbc_process(priv, '\r');
+		fbc_process(priv, s[i]);
+	}
+
+	fbc_write_done(priv);
+
 	priv->in_console = 0;
 
-	fb_flush(fb);
+	return nbytes;
+}
+
+static void fbc_console_flush(struct console_device *cdev)
+{
+	struct fbc_priv *priv = container_of(cdev,
+					struct fbc_priv, cdev);
+
+	if (!priv->active || priv->in_console)
+		return;
+
+	if (IS_ENABLED(CONFIG_POLLER))
+		poller_async_cancel(&priv->flush_poller);
+
+	fbc_flush(priv);
 }
 
 static int setup_font(struct fbc_priv *priv)
@@ -688,6 +912,9 @@ static int setup_font(struct fbc_priv *priv)
 
 	priv->font = font;
 
+	/* the glyphs depend on the font, rotation and pixel format */
+	fbc_atlas_release(priv);
+
 	switch (priv->rotation) {
 	case FBCONSOLE_ROTATE_0:
 	case FBCONSOLE_ROTATE_180:
@@ -707,6 +934,7 @@ static int setup_font(struct fbc_priv *priv)
 		priv->rows = newrows;
 		priv->cols = newcols;
 		priv->x = priv->y = 0;
+		priv->ring_top = 0;
 	}
 
 	return 0;
@@ -730,6 +958,9 @@ static int fbc_open(struct console_device *cdev)
 	fb_enable(fb);
 
 	priv->state = LIT;
+	priv->cursor_drawn = false;
+	priv->ring_top = 0;
+	memset(&priv->dirty, 0, sizeof(priv->dirty));
 
 	dev_info(priv->cdev.dev, "framebuffer console %dx%d activated\n",
 		priv->cols, priv->rows);
@@ -745,6 +976,11 @@ static int fbc_close(struct console_device *cdev)
 					struct fbc_priv, cdev);
 
 	if (priv->active) {
+		if (IS_ENABLED(CONFIG_POLLER))
+			poller_async_cancel(&priv->flush_poller);
+		fbc_flush(priv);
+		fbc_atlas_release(priv);
+
 		fb_close(priv->sc);
 		priv->active = false;
 
@@ -762,6 +998,7 @@ static int set_font(struct param_d *p, void *vpriv)
 	if (cdev->f_active & (CONSOLE_STDOUT | CONSOLE_STDERR)) {
 		cls(priv);
 		setup_font(priv);
+		fbc_flush(priv);
 	}
 
 	return 0;
@@ -791,6 +1028,7 @@ static int set_margin(struct param_d *p, void *vpriv)
 	if (cdev->f_active & (CONSOLE_STDOUT | CONSOLE_STDERR)) {
 		cls(priv);
 		setup_font(priv);
+		fbc_flush(priv);
 	}
 
 	return 0;
@@ -804,6 +1042,7 @@ static int set_rotation(struct param_d *p, void *vpriv)
 	priv->x = 0;
 	priv->y = 0;
 	setup_font(priv);
+	fbc_flush(priv);
 
 	return 0;
 }
@@ -836,11 +1075,17 @@ int register_fbconsole(struct fb_info *fb)
 	priv->y = 0;
 	priv->color = WHITE;
 	priv->bgcolor = BLACK;
+	fbc_atlas_release(priv);
+
+	if (IS_ENABLED(CONFIG_POLLER))
+		poller_async_register(&priv->flush_poller, "fbconsole");
 
 	cdev = &priv->cdev;
 	cdev->dev = &fb->dev;
 	cdev->tstc = fbc_tstc;
 	cdev->putc = fbc_putc;
+	cdev->puts = fbc_puts;
+	cdev->flush = fbc_console_flush;
 	cdev->getc = fbc_getc;
 	cdev->devname = basprintf("fbconsole%s", fbname);
 	cdev->devid = DEVICE_ID_SINGLE;
@@ -850,6 +1095,8 @@ int register_fbconsole(struct fb_info *fb)
 	ret = console_register(cdev);
 	if (ret) {
 		pr_err("registering failed with %pe\n", ERR_PTR(ret));
+		if (IS_ENABLED(CONFIG_POLLER))
+			poller_async_unregister(&priv->flush_poller);
 		kfree(priv);
 		return ret;
 	}
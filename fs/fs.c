@@ -35,6 +35,7 @@
 #include <slice.h>
 #include <libfile.h>
 #include <parseopt.h>
+#include <bootprofile.h>
 #include <linux/namei.h>
 #include <security/config.h>
 
@@ -408,6 +409,7 @@ int ioctl(int fd, unsigned int request, void *buf)
 static ssize_t __read(struct file *f, void *buf, size_t count)
 {
 	struct fs_driver *fsdrv;
+	u64 start;
 	int ret;
 
 	if ((f->f_flags & O_ACCMODE) == O_WRONLY) {
@@ -426,7 +428,9 @@ static ssize_t __read(struct file *f, void *buf, size_t count)
 	if (!count)
 		return 0;
 
+	start = bootprofile_start();
 	ret = f->f_inode->i_fop->read(f, buf, count);
+	bootprofile_event(BOOTPROFILE_FILE, f->path ?: "", start, ret);
 out:
 	return errno_set(ret);
 }
@@ -28,6 +28,7 @@
 #include <console.h>
 #include <malloc.h>
 #include <linux/printk.h>
+#include <logbuf.h>
 #include <module.h>
 
 #include "internal.h"
@@ -76,12 +77,17 @@ void pstore_log(const char *str)
 static void pstore_console_capture_log(void)
 {
 	uint64_t id;
-	struct log_entry *log, *tmp;
+	struct logbuf *lb;
+	struct log_entry *log;
 
 	if (IS_ENABLED(CONFIG_CONSOLE_NONE))
 		return;
 
-	list_for_each_entry_safe(log, tmp, &barebox_logbuf, list) {
+	lb = barebox_log();
+	if (!lb)
+		return;
+
+	logbuf_for_each_entry(lb, log) {
 		psinfo->write_buf(PSTORE_TYPE_CONSOLE, 0, &id, 0,
 				  log->msg, 0, strlen(log->msg), psinfo);
 	}
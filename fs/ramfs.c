@@ -21,6 +21,7 @@
 #include <fs.h>
 #include <command.h>
 #include <errno.h>
+#include <ramfs.h>
 #include <linux/stat.h>
 #include <xfuncs.h>
 #include <linux/sizes.h>
@@ -48,6 +49,9 @@ struct ramfs_inode {
 	struct list_head data;
 
 	struct ramfs_chunk *current_chunk;
+
+	/* contents not copied into chunks yet, see RAMFS_IOC_SET_EXT_DATA */
+	struct ramfs_ext_data *ext;
 };
 
 static inline struct ramfs_inode *to_ramfs_inode(struct inode *inode)
@@ -242,6 +246,48 @@ static struct ramfs_chunk *ramfs_find_chunk(struct ramfs_inode *node,
 	return NULL;
 }
 
+static void ramfs_release_ext(struct ramfs_inode *node)
+{
+	struct ramfs_ext_data *ext = node->ext;
+
+	if (!ext)
+		return;
+
+	if (ext->release)
+		ext->release(ext->priv);
+
+	free(ext);
+	node->ext = NULL;
+}
+
+static int ramfs_truncate_up(struct ramfs_inode *node, unsigned long size);
+
+/* copy external contents into chunks before the file is modified */
+static int ramfs_materialize(struct ramfs_inode *node)
+{
+	struct ramfs_ext_data *ext = node->ext;
+	struct ramfs_chunk *data;
+	int ret;
+
+	if (!ext)
+		return 0;
+
+	ret = ramfs_truncate_up(node, ext->size);
+	if (ret)
+		return ret;
+
+	list_for_each_entry(data, &node->data, list) {
+		if (data->ofs >= ext->size)
+			break;
+		memcpy(data->data, ext->data + data->ofs,
+		       min_t(unsigned long, data->size, ext->size - data->ofs));
+	}
+
+	ramfs_release_ext(node);
+
+	return 0;
+}
+
 static int ramfs_read(struct file *f, void *buf, size_t insize)
 {
 	struct inode *inode = f->f_inode;
@@ -253,6 +299,11 @@ static int ramfs_read(struct file *f, void *buf, size_t insize)
 
 	pr_vdebug("%s: %p %zu @ %lld\n", __func__, node, insize, f->f_pos);
 
+	if (node->ext) {
+		memcpy(buf, node->ext->data + pos, insize);
+		return insize;
+	}
+
 	while (size) {
 		data = ramfs_find_chunk(node, pos, &ofs, &len);
 		if (!data)
@@ -280,9 +331,14 @@ static int ramfs_write(struct file *f, const void *buf, size_t insize)
 	int ofs, len, now;
 	unsigned long pos = f->f_pos;
 	int size = insize;
+	int ret;
 
 	pr_vdebug("%s: %p %zu @ %lld\n", __func__, node, insize, f->f_pos);
 
+	ret = ramfs_materialize(node);
+	if (ret)
+		return ret;
+
 	while (size) {
 		data = ramfs_find_chunk(node, pos, &ofs, &len);
 		if (!data)
@@ -395,6 +451,14 @@ static int ramfs_truncate(struct file *f, loff_t size)
 	if (size == node->size)
 		return 0;
 
+	if (!size) {
+		ramfs_release_ext(node);
+	} else {
+		ret = ramfs_materialize(node);
+		if (ret)
+			return ret;
+	}
+
 	if (size < node->size) {
 		ramfs_truncate_down(node, size);
 	} else {
@@ -413,6 +477,16 @@ static int ramfs_memmap(struct file *f, void **map, int flags)
 	struct inode *inode = f->f_inode;
 	struct ramfs_inode *node = to_ramfs_inode(inode);
 	struct ramfs_chunk *data;
+	int ret;
+
+	if (node->ext && !(flags & PROT_WRITE)) {
+		*map = (void *)node->ext->data;
+		return 0;
+	}
+
+	ret = ramfs_materialize(node);
+	if (ret)
+		return ret;
 
 	if (list_empty(&node->data))
 		return -EINVAL;
@@ -427,11 +501,33 @@ static int ramfs_memmap(struct file *f, void **map, int flags)
 	return 0;
 }
 
+static int ramfs_ioctl(struct file *f, unsigned int request, void *buf)
+{
+	struct ramfs_inode *node = to_ramfs_inode(f->f_inode);
+	struct ramfs_ext_data *ext = buf;
+
+	if (request != RAMFS_IOC_SET_EXT_DATA)
+		return -ENOSYS;
+
+	if ((f->f_flags & O_ACCMODE) == O_RDONLY)
+		return -EBADF;
+
+	ramfs_truncate_down(node, 0);
+	ramfs_release_ext(node);
+
+	node->ext = xmemdup(ext, sizeof(*ext));
+	node->size = ext->size;
+	f->f_size = ext->size;
+
+	return 0;
+}
+
 static const struct file_operations ramfs_file_operations = {
 	.read      = ramfs_read,
 	.write     = ramfs_write,
 	.memmap    = ramfs_memmap,
 	.truncate  = ramfs_truncate,
+	.ioctl     = ramfs_ioctl,
 };
 
 static struct inode *ramfs_alloc_inode(struct super_block *sb)
@@ -450,6 +546,7 @@ static void ramfs_destroy_inode(struct inode *inode)
 	struct ramfs_inode *node = to_ramfs_inode(inode);
 
 	ramfs_truncate_down(node, 0);
+	ramfs_release_ext(node);
 
 	free(node);
 }
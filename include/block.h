@@ -5,6 +5,7 @@
 #include <driver.h>
 #include <linux/list.h>
 #include <linux/types.h>
+#include <iostat.h>
 
 struct block_device;
 struct file_list;
@@ -33,10 +34,28 @@ enum blk_type {
 
 const char *blk_type_str(enum blk_type);
 
+/**
+ * struct block_device_stats - block device statistics
+ * @read_sectors: sectors read from the device
+ * @write_sectors: sectors written to the device
+ * @erase_sectors: sectors erased
+ * @read: device read requests, one per cache chunk read
+ * @write: device write requests, one per cache chunk written back
+ * @cache_hits: block lookups served from the cache
+ * @cache_misses: block lookups which had to read from the device
+ * @dev: device carrying the statistics as parameters
+ * @registered: @dev is registered
+ */
 struct block_device_stats {
 	blkcnt_t read_sectors;
 	blkcnt_t write_sectors;
 	blkcnt_t erase_sectors;
+	struct iostat read;
+	struct iostat write;
+	u64 cache_hits;
+	u64 cache_misses;
+	struct device dev;
+	bool registered;
 };
 
 struct block_device {
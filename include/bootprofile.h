@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef __BOOTPROFILE_H
+#define __BOOTPROFILE_H
+
+#include <linux/types.h>
+#include <linux/bits.h>
+#include <clock.h>
+
+struct device;
+
+enum bootprofile_type {
+	BOOTPROFILE_INITCALL,
+	BOOTPROFILE_PROBE,
+	BOOTPROFILE_DEFERRED,
+	BOOTPROFILE_BOOTM,
+	BOOTPROFILE_BLOCK_READ,
+	BOOTPROFILE_BLOCK_WRITE,
+	BOOTPROFILE_FILE,
+	BOOTPROFILE_DIGEST,
+	BOOTPROFILE_DECOMPRESS,
+	BOOTPROFILE_NET_RX,
+	BOOTPROFILE_NET_TX,
+	BOOTPROFILE_TYPE_MAX,
+};
+
+#define BOOTPROFILE_NAME_LEN	24
+
+/* the event has no duration, like a network packet */
+#define BOOTPROFILE_F_INSTANT	BIT(0)
+
+/**
+ * struct bootprofile_entry - one timed boot event
+ * @start: get_time_ns() when the event started
+ * @duration: duration of the event in ns, including nested events
+ * @ret: return value of the timed function
+ * @type: one of enum bootprofile_type
+ * @depth: nesting level of driver probes
+ * @flags: BOOTPROFILE_F_* flags
+ * @fn: the initcall, for BOOTPROFILE_INITCALL
+ * @phase: static name of the bootm phase, for BOOTPROFILE_BOOTM
+ * @name: device, file or algorithm name, for all other types
+ */
+struct bootprofile_entry {
+	u64 start;
+	u64 duration;
+	int ret;
+	u8 type;
+	u8 depth;
+	u8 flags;
+	union {
+		const void *fn;
+		const char *phase;
+		char name[BOOTPROFILE_NAME_LEN];
+	};
+};
+
+#ifdef CONFIG_BOOTPROFILE
+static inline u64 bootprofile_start(void)
+{
+	return get_time_ns();
+}
+
+void bootprofile_initcall(const void *fn, u64 start, int ret);
+void bootprofile_probe(enum bootprofile_type type, struct device *dev,
+		       int depth, u64 start, int ret);
+void bootprofile_bootm(const char *phase, u64 start, int ret);
+void bootprofile_event(enum bootprofile_type type, const char *name,
+		       u64 start, int ret);
+void bootprofile_instant(enum bootprofile_type type, const char *name,
+			 int ret);
+unsigned int bootprofile_set_mask(unsigned int mask);
+unsigned int bootprofile_get_mask(void);
+
+unsigned int bootprofile_num_entries(unsigned int *dropped);
+const struct bootprofile_entry *bootprofile_get_entry(unsigned int i);
+int bootprofile_entry_name(const struct bootprofile_entry *e,
+			   char *buf, size_t len);
+const char *bootprofile_type_name(enum bootprofile_type type);
+void bootprofile_clear(void);
+#else
+static inline u64 bootprofile_start(void)
+{
+	return 0;
+}
+
+static inline void bootprofile_initcall(const void *fn, u64 start, int ret)
+{
+}
+
+static inline void bootprofile_probe(enum bootprofile_type type,
+				     struct device *dev, int depth,
+				     u64 start, int ret)
+{
+}
+
+static inline void bootprofile_bootm(const char *phase, u64 start, int ret)
+{
+}
+
+static inline void bootprofile_event(enum bootprofile_type type,
+				     const char *name, u64 start, int ret)
+{
+}
+
+static inline void bootprofile_instant(enum bootprofile_type type,
+				       const char *name, int ret)
+{
+}
+#endif
+
+#endif /* __BOOTPROFILE_H */
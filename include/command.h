@@ -38,6 +38,7 @@ struct command {
 	const char	*opts;		/* command options */
 
 	struct list_head list;		/* List of commands		*/
+	struct hlist_node hnode;	/* find_cmd() hash table	*/
 	uint32_t	group;
 #ifdef	CONFIG_LONGHELP
 	const char	*help;		/* Help  message	(long)	*/
@@ -36,6 +36,7 @@ struct console_device {
 	int  (*getc)(struct console_device *cdev);
 	int (*setbrg)(struct console_device *cdev, int baudrate);
 	void (*flush)(struct console_device *cdev);
+	int (*tx_ready)(struct console_device *cdev);
 	int (*set_mode)(struct console_device *cdev, enum console_mode mode);
 	int (*open)(struct console_device *cdev);
 	int (*close)(struct console_device *cdev);
@@ -50,6 +51,8 @@ struct console_device {
 
 	unsigned int open_count;
 
+	struct kfifo *tx_fifo;
+
 	unsigned int baudrate;
 	unsigned int baudrate_param;
 
@@ -102,6 +105,7 @@ int console_set_active(struct console_device *cdev, unsigned active);
 unsigned console_get_active(struct console_device *cdev);
 int console_set_baudrate(struct console_device *cdev, unsigned baudrate);
 unsigned console_get_baudrate(struct console_device *cdev);
+void console_tx_flush(struct console_device *cdev);
 void console_set_stdoutpath(struct console_device *cdev, unsigned baudrate);
 
 struct console_device *of_console_by_stdout_path(void);
@@ -15,6 +15,8 @@ extern u16 crc_itu_t(u16 crc, const u8 *buffer, size_t len);
 uint32_t crc32(uint32_t, const void *, unsigned int);
 uint32_t crc32_be(uint32_t, const void *, unsigned int);
 uint32_t crc32_no_comp(uint32_t, const void *, unsigned int);
+uint32_t crc32_le_base(uint32_t, const void *, unsigned int);
+uint32_t crc32_le_arch(uint32_t, const void *, unsigned int);
 int file_crc(char *filename, unsigned long start, unsigned long size,
 	     unsigned long *crc, unsigned long *total);
 
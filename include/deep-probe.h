@@ -20,6 +20,20 @@ static inline bool deep_probe_is_supported(void)
 }
 #endif
 
+#ifdef CONFIG_DEEP_PROBE_LAZY
+bool deep_probe_is_lazy(void);
+void deep_probe_complete(void);
+#else
+static inline bool deep_probe_is_lazy(void)
+{
+	return false;
+}
+
+static inline void deep_probe_complete(void)
+{
+}
+#endif
+
 extern struct deep_probe_entry __barebox_deep_probe_start[];
 extern struct deep_probe_entry __barebox_deep_probe_end[];
 
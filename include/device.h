@@ -61,6 +61,7 @@ struct of_device_id;
  *          should actually detect client devices.
  * @rescan: Callback to rescan the device.
  * @deferred_probe_reason: If a driver probe is deferred, this stores the last error.
+ * @deferred_bind_seq: Number of bound devices when the probe was last deferred.
  */
 struct device {
 	union {
@@ -122,6 +123,7 @@ struct device {
 	void (*rescan)(struct device *);
 
 	char *deferred_probe_reason;
+	unsigned int deferred_bind_seq;
 };
 
 #define bobj_to_dev(__bobj)	container_of_const(__bobj, struct device, bobject)
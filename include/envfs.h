@@ -9,11 +9,12 @@
 #endif
 
 #define ENVFS_MAJOR		1
-#define ENVFS_MINOR		0
+#define ENVFS_MINOR		1
 
 #define ENVFS_MAGIC		    0x798fba79	/* some random number */
 #define ENVFS_INODE_MAGIC	0x67a8c78d
 #define ENVFS_INODE_END_MAGIC	0x68a8c78d
+#define ENVFS_INDEX_MAGIC	0x69a8c78d
 
 struct envfs_inode {
 	uint32_t magic;	/* ENVFS_INODE_MAGIC */
@@ -31,6 +32,25 @@ struct envfs_inode_end {
 	uint32_t mode;	/* file mode */
 };
 
+/*
+ * Since envfs 1.1 the inodes are followed by an index of all files. It is
+ * not covered by the superblock size and crc, so older loaders ignore it.
+ */
+struct envfs_index_entry {
+	uint32_t name;	/* offset of the zero terminated name in the data */
+	uint32_t data;	/* offset of the file data */
+	uint32_t size;	/* data size in bytes */
+	uint32_t mode;	/* file mode */
+};
+
+struct envfs_index {
+	uint32_t magic;	/* ENVFS_INDEX_MAGIC */
+	uint32_t num;	/* number of entries */
+	uint32_t crc;	/* crc for the entries */
+	uint32_t future;	/* reserved for future use */
+	struct envfs_index_entry entries[];
+};
+
 /*
  * Superblock information at the beginning of the FS.
  */
@@ -44,6 +64,7 @@ struct envfs_super {
 	uint16_t future;		/* reserved for future use */
 	uint32_t flags;			/* feature flags */
 #define ENVFS_FLAGS_FORCE_BUILT_IN	(1 << 0)
+#define ENVFS_FLAGS_INDEX		(1 << 1)	/* struct envfs_index follows the data */
 	uint32_t sb_crc;		/* crc for the superblock */
 };
 
@@ -97,9 +118,12 @@ int envfs_load(const char *filename, const char *dirname, unsigned flags);
 int envfs_save(const char *filename, const char *dirname, unsigned flags);
 int envfs_check_super(struct envfs_super *super, size_t *size);
 int envfs_check_data(struct envfs_super *super, const void *buf, size_t size);
+int envfs_check_index(struct envfs_super *super, const void *buf, size_t size,
+		size_t len);
 int envfs_load_data(struct envfs_super *super, void *buf, size_t size,
-		const char *dir, unsigned flags);
-int envfs_load_from_buf(void *buf, int len, const char *dir, unsigned flags);
+		size_t len, const char *dir, unsigned flags, void *freep);
+int envfs_load_from_buf(void *buf, int len, const char *dir, unsigned flags,
+		void *freep);
 
 /* defaults to /dev/env0 */
 #ifdef CONFIG_ENV_HANDLING
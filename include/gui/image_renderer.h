@@ -37,7 +37,10 @@ void image_renderer_unregister(struct image_renderer *ir);
 int image_renderer_image(struct screen *sc, struct surface *s, struct image *img);
 
 struct image *image_renderer_open(const char* file);
+struct image *image_renderer_open_buf(void *data, size_t size);
 void image_renderer_close(struct image *img);
+void image_renderer_area(struct screen *sc, struct surface *s,
+			 struct image *img, struct surface *area);
 
 #else
 static inline int image_renderer_register(struct image_renderer *ir)
@@ -74,4 +77,18 @@ static inline int image_renderer_file(struct screen *sc, struct surface *s, cons
 	return ret;
 }
 
+#ifdef CONFIG_IMAGE_RENDERER_CACHE
+int image_renderer_file_cached(struct screen *sc, struct surface *s,
+			       const char *file, const char *cache,
+			       u64 cookie);
+#else
+static inline int image_renderer_file_cached(struct screen *sc,
+					     struct surface *s,
+					     const char *file,
+					     const char *cache, u64 cookie)
+{
+	return image_renderer_file(sc, s, file);
+}
+#endif
+
 #endif /* __IMAGE_RENDERER_H__ */
@@ -25,6 +25,10 @@ struct fit_handle {
 	struct device_node *root;
 	struct device_node *images;
 	struct device_node *configurations;
+
+	/* images whose hash was already checked by fit_config_hash_images() */
+	struct device_node **hashed_images;
+	unsigned int num_hashed_images;
 };
 
 struct fit_handle *fit_open(const char *filename, bool verbose,
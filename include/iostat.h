@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef __IOSTAT_H
+#define __IOSTAT_H
+
+#include <linux/types.h>
+#include <linux/bitops.h>
+#include <linux/math64.h>
+#include <linux/minmax.h>
+#include <clock.h>
+
+struct device;
+
+#define IOSTAT_LATENCY_BUCKETS	24
+
+/**
+ * struct iostat - statistics of one kind of device request
+ * @requests: number of requests
+ * @errors: number of failed requests
+ * @bytes: bytes transferred by successful requests
+ * @time_ns: time spent in all requests
+ * @latency: log2 histogram of the request latencies. Bucket 0 counts
+ *           requests that took less than 1us, bucket n those that took
+ *           at least 2^(n-1)us and less than 2^n us. The last bucket
+ *           counts all slower requests as well.
+ * @latency_str: @latency formatted for the device parameter
+ */
+struct iostat {
+	u64 requests;
+	u64 errors;
+	u64 bytes;
+	u64 time_ns;
+	u32 latency[IOSTAT_LATENCY_BUCKETS];
+	char *latency_str;
+};
+
+static inline u64 iostat_start(void)
+{
+	return get_time_ns();
+}
+
+/**
+ * iostat_account - account a finished request
+ * @s: the statistics
+ * @start: iostat_start() before the request was issued
+ * @bytes: bytes transferred
+ * @ret: result of the request, negative for errors
+ */
+static inline void iostat_account(struct iostat *s, u64 start, u64 bytes,
+				  int ret)
+{
+	u64 ns = get_time_ns() - start;
+	unsigned int bucket = fls64(div_u64(ns, NSEC_PER_USEC));
+
+	s->requests++;
+	if (ret < 0)
+		s->errors++;
+	else
+		s->bytes += bytes;
+	s->time_ns += ns;
+	s->latency[min_t(unsigned int, bucket, IOSTAT_LATENCY_BUCKETS - 1)]++;
+}
+
+void iostat_add_params(struct device *dev, const char *prefix,
+		       struct iostat *s);
+
+#endif /* __IOSTAT_H */
@@ -2,10 +2,15 @@
 #ifndef LINUX_DECOMPRESS_UNZSTD_H
 #define LINUX_DECOMPRESS_UNZSTD_H
 
+#include <linux/types.h>
+
 int unzstd(unsigned char *inbuf, long len,
 	   long (*fill)(void*, unsigned long),
 	   long (*flush)(void*, unsigned long),
 	   unsigned char *output,
 	   long *pos,
 	   void (*error_fn)(char *x));
+
+ssize_t unzstd_parallel(const void *in, size_t in_len, void **out,
+			void (*error)(char *x));
 #endif
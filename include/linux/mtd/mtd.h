@@ -16,6 +16,7 @@
 #include <linux/list.h>
 #include <linux/mtd/mtd-abi.h>
 #include <linux/math64.h>
+#include <iostat.h>
 
 #define MTD_CHAR_MAJOR 90
 #define MTD_BLOCK_MAJOR 31
@@ -254,6 +255,13 @@ struct mtd_info {
 	char *partition_string;
 
 	unsigned int of_binding;
+
+#ifdef CONFIG_MTD_STATS
+	/* requests through this device, not through its partitions */
+	struct iostat read_stats;
+	struct iostat write_stats;
+	struct iostat erase_stats;
+#endif
 };
 
 int mtd_ooblayout_ecc(struct mtd_info *mtd, int section,
@@ -176,16 +176,21 @@ int __pr_memory_display(int level, const void *addr, loff_t offs, unsigned nbyte
 				(offs), (nbytes), (size), (swab), pr_fmt("")) : 0; \
 	 })
 
-struct log_entry {
-	struct list_head list;
-	uint64_t timestamp;
-	int level;
-	char msg[];
-};
+struct logbuf;
 
-extern struct list_head barebox_logbuf;
+#ifdef CONFIG_LOGBUF
+struct logbuf *barebox_log(void);
+void log_clean(unsigned int limit);
+#else
+static inline struct logbuf *barebox_log(void)
+{
+	return NULL;
+}
 
-extern void log_clean(unsigned int limit);
+static inline void log_clean(unsigned int limit)
+{
+}
+#endif
 
 #define BAREBOX_LOG_PRINT_RAW		BIT(2)
 #define BAREBOX_LOG_DIFF_TIME		BIT(1)
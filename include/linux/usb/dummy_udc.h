@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef __LINUX_USB_DUMMY_UDC_H
+#define __LINUX_USB_DUMMY_UDC_H
+
+#include <linux/types.h>
+#include <linux/usb/ch9.h>
+
+struct dummy_udc;
+
+/**
+ * struct dummy_udc_ep_stats - request statistics of a dummy UDC endpoint
+ * @requests: number of completed requests
+ * @bytes: number of bytes transferred
+ * @max_queued: maximum number of requests queued at the same time
+ * @starved: number of times the host had to wait for a request
+ */
+struct dummy_udc_ep_stats {
+	u64 requests;
+	u64 bytes;
+	unsigned int max_queued;
+	unsigned int starved;
+};
+
+#ifdef CONFIG_USB_GADGET_DRIVER_DUMMY
+struct dummy_udc *dummy_udc_get(void);
+int dummy_udc_control(struct dummy_udc *udc, const struct usb_ctrlrequest *ctrl,
+		      void *data);
+int dummy_udc_bulk(struct dummy_udc *udc, u8 epaddr, void *buf, size_t len);
+int dummy_udc_ep_stats(struct dummy_udc *udc, u8 epaddr,
+		       struct dummy_udc_ep_stats *stats);
+void dummy_udc_reset_stats(struct dummy_udc *udc);
+#else
+static inline struct dummy_udc *dummy_udc_get(void)
+{
+	return NULL;
+}
+#endif
+
+#endif /* __LINUX_USB_DUMMY_UDC_H */
@@ -144,6 +144,22 @@ extern struct bus_type usb_bus_type;
 
 int usb_driver_register(struct usb_driver *);
 
+/**
+ * struct usb_bulk_xfer - one bulk transfer of a usb_bulk_msgs() batch
+ * @pipe: bulk pipe to transfer on
+ * @data: data buffer
+ * @len: length of @data
+ * @actual_length: number of bytes transferred
+ * @status: USB_ST_* status, USB_ST_NOT_PROC if the transfer did not run
+ */
+struct usb_bulk_xfer {
+	unsigned long pipe;
+	void *data;
+	int len;
+	int actual_length;
+	unsigned long status;
+};
+
 struct usb_host {
 	int (*init)(struct usb_host *);
 	int (*exit)(struct usb_host *);
@@ -153,11 +169,15 @@ struct usb_host {
 			int transfer_len, struct devrequest *setup, int timeout_ms);
 	int (*submit_int_msg)(struct usb_device *dev, unsigned long pipe, void *buffer,
 			int transfer_len, int interval);
+	int (*submit_bulk_msgs)(struct usb_device *dev, struct usb_bulk_xfer *xfers,
+			int num, int timeout_ms);
 	void (*usb_event_poll)(void);
 	int (*alloc_device)(struct usb_device *dev);
 	int (*update_hub_device)(struct usb_device *dev);
 
 	bool no_desc_before_addr;
+	/* largest bulk transfer the host can do at once, 0 if unknown */
+	size_t max_bulk_size;
 
 	struct list_head list;
 
@@ -176,6 +196,12 @@ static inline struct slice *usb_device_slice(struct usb_device *udev)
 	return &udev->host->slice;
 }
 
+/* Can the host have several bulk transfers in flight at the same time? */
+static inline bool usb_host_queues_bulk(struct usb_device *udev)
+{
+	return udev->host->submit_bulk_msgs != NULL;
+}
+
 int usb_host_detect(struct usb_host *host);
 
 int usb_set_protocol(struct usb_device *dev, int ifnum, int protocol);
@@ -187,6 +213,8 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, unsigned short size, int timeout_ms);
 int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, int len, int *actual_length, int timeout_ms);
+int usb_bulk_msgs(struct usb_device *dev, struct usb_bulk_xfer *xfers,
+		  int num, int timeout_ms);
 int usb_submit_int_msg(struct usb_device *dev, unsigned long pipe,
 			void *buffer, int transfer_len, int interval);
 int usb_maxpacket(struct usb_device *dev, unsigned long pipe);
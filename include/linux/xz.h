@@ -270,4 +270,7 @@ STATIC int decompress_unxz(unsigned char *in, long in_size,
 		     unsigned char *out, long *in_used,
 		     void (*error)(char *x));
 
+ssize_t unxz_parallel(const void *in, size_t in_len, void **out,
+		      void (*error)(char *x));
+
 #endif
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef __LOGBUF_H
+#define __LOGBUF_H
+
+#include <linux/types.h>
+
+#define LOGBUF_MAGIC	0x6c6f6762	/* "logb" */
+#define LOGBUF_VERSION	1
+
+/**
+ * struct log_entry - one record in a log ring buffer
+ * @timestamp: get_time_ns() when the message was logged, 0 in PBL
+ * @size: size of the record including this header, 0 marks a wrap
+ * @level: log level of the message
+ * @flags: LOG_ENTRY_* flags
+ * @msg: NUL terminated message
+ */
+struct log_entry {
+	u64 timestamp;
+	u16 size;
+	u8 level;
+	u8 flags;
+#define LOG_ENTRY_PBL		BIT(0)
+#define LOG_ENTRY_TRUNCATED	BIT(1)
+	char msg[];
+};
+
+/**
+ * struct logbuf - header of a log ring buffer
+ *
+ * The header is placed at the start of the buffer memory, so that the
+ * buffer can be parsed by whoever gets hold of the memory, e.g. barebox
+ * proper for the PBL log or the kernel for the barebox log. All offsets
+ * are relative to the start of the header.
+ *
+ * @magic: LOGBUF_MAGIC
+ * @version: LOGBUF_VERSION
+ * @size: total size of the buffer including this header
+ * @head: offset of the oldest record
+ * @tail: offset where the next record is written
+ * @num: number of records in the buffer
+ * @dropped: number of records overwritten so far
+ */
+struct logbuf {
+	u32 magic;
+	u32 version;
+	u32 size;
+	u32 head;
+	u32 tail;
+	u32 num;
+	u32 dropped;
+	u32 reserved;
+};
+
+struct logbuf *logbuf_init(void *buf, size_t size);
+struct log_entry *logbuf_add(struct logbuf *lb, u64 timestamp, int level,
+			     unsigned int flags, const char *msg);
+void logbuf_drop_oldest(struct logbuf *lb);
+struct log_entry *logbuf_first(const struct logbuf *lb);
+struct log_entry *logbuf_next(const struct logbuf *lb,
+			      const struct log_entry *e);
+bool logbuf_valid(const struct logbuf *lb, size_t size);
+
+#define logbuf_for_each_entry(lb, e) \
+	for (e = logbuf_first(lb); e; e = logbuf_next(lb, e))
+
+#endif /* __LOGBUF_H */
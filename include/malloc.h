@@ -91,6 +91,18 @@ static inline bool want_init_on_free(void)
 	return IS_ENABLED(CONFIG_INIT_ON_FREE_DEFAULT_ON);
 }
 
+#if defined(CONFIG_MALLOC_PROFILE) && IN_PROPER
+void malloc_profile_caller(unsigned long caller);
+void malloc_profile_phase(const char *name);
+void malloc_profile_print(unsigned int num, bool by_allocs);
+void malloc_profile_reset(void);
+#else
+static inline void malloc_profile_caller(unsigned long caller) {}
+static inline void malloc_profile_phase(const char *name) {}
+static inline void malloc_profile_print(unsigned int num, bool by_allocs) {}
+static inline void malloc_profile_reset(void) {}
+#endif
+
 #ifdef CONFIG_DEBUG_MEMLEAK
 void memleak_check(void);
 #else
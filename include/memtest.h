@@ -15,8 +15,19 @@ void mem_test_release_regions(struct list_head *list);
 struct mem_test_resource *mem_test_biggest_region(struct list_head *list);
 
 #define MEMTEST_VERBOSE		BIT(0)
+/* fused multi pattern test instead of plain moving inversions */
+#define MEMTEST_EXTENDED	BIT(1)
+/*
+ * spread the test over the offload CPUs. Their TLBs are not maintained
+ * by remap_range(), so only use this on regions that stay mapped cached.
+ */
+#define MEMTEST_OFFLOAD		BIT(2)
 
 int mem_test_bus_integrity(resource_size_t _start, resource_size_t _end, unsigned flags);
 int mem_test_moving_inversions(resource_size_t _start, resource_size_t _end, unsigned flags);
 
+/* for selftests only, see test/self/memtest.c */
+extern void (*mem_test_pass_hook)(unsigned long *words, unsigned long num_words,
+				  unsigned int pass);
+
 #endif /* __MEMTEST_H */
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __OFFLOAD_H
+#define __OFFLOAD_H
+
+#include <linux/types.h>
+#include <linux/list.h>
+#include <linux/string.h>
+#include <digest.h>
+
+/**
+ * struct offload_job - a self-contained unit of work for a secondary CPU
+ * @fn: function to run. Its return value is stored in @ret
+ * @ret: result of @fn, valid once offload_job_wait() returned
+ *
+ * Jobs run on a secondary CPU concurrently to the boot CPU. barebox is
+ * not SMP safe, so @fn must only touch memory it owns: no malloc, no
+ * console output, no pollers, no device access. Hashing and
+ * decompressing into preallocated buffers is fine.
+ */
+struct offload_job {
+	int (*fn)(struct offload_job *job);
+	int ret;
+
+	/* private */
+	bool done;
+};
+
+/**
+ * struct offload_cpu - a secondary CPU parked in the offload loop
+ *
+ * Registered by architecture code once the CPU is executing
+ * offload_cpu_main(). @job is only written by the boot CPU while it
+ * is NULL and only cleared by the secondary, so no atomics are needed.
+ */
+struct offload_cpu {
+	struct list_head list;
+	unsigned int id;
+	struct offload_job *job;
+	bool stop;
+	bool running;
+};
+
+static inline void offload_job_init(struct offload_job *job,
+				    int (*fn)(struct offload_job *))
+{
+	job->fn = fn;
+	job->ret = 0;
+	job->done = false;
+}
+
+/**
+ * struct offload_digest_job - hash a buffer on a secondary CPU
+ * @d: digest to use. Must not be shared with other running jobs
+ * @buf: data to hash
+ * @len: length of @buf
+ * @out: buffer of digest_length(@d) bytes receiving the hash
+ */
+struct offload_digest_job {
+	struct offload_job job;
+	struct digest *d;
+	const void *buf;
+	size_t len;
+	u8 *out;
+};
+
+#ifdef CONFIG_OFFLOAD
+unsigned int offload_num_cpus(void);
+void offload_job_submit(struct offload_job *job);
+int offload_job_wait(struct offload_job *job);
+
+void offload_cpu_register(struct offload_cpu *cpu);
+void offload_cpu_main(struct offload_cpu *cpu);
+void offload_cpus_stop(void);
+
+void offload_digest_submit(struct offload_digest_job *dj);
+void offload_memset(void *s, int c, size_t n);
+#else
+static inline unsigned int offload_num_cpus(void)
+{
+	return 1;
+}
+
+static inline void offload_job_submit(struct offload_job *job)
+{
+	job->ret = job->fn(job);
+	job->done = true;
+}
+
+static inline int offload_job_wait(struct offload_job *job)
+{
+	return job->ret;
+}
+
+static inline void offload_digest_submit(struct offload_digest_job *dj)
+{
+	dj->job.ret = digest_digest(dj->d, dj->buf, dj->len, dj->out);
+	dj->job.done = true;
+}
+
+static inline void offload_memset(void *s, int c, size_t n)
+{
+	memset(s, c, n);
+}
+#endif
+
+#endif /* __OFFLOAD_H */
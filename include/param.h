@@ -39,6 +39,7 @@ struct param_d {
 	struct bobject *bobj;
 	void *driver_priv;
 	struct list_head list;
+	struct hlist_node hnode;
 	enum param_type type;
 };
 
@@ -51,6 +52,8 @@ const char *get_param_type(struct param_d *param);
 const char *bobject_get_param(bobject_t bobj, const char *name);
 int bobject_set_param(bobject_t bobj, const char *name, const char *val);
 struct param_d *get_param_by_name(bobject_t bobj, const char *name);
+struct param_d *param_first_with_prefix(bobject_t bobj, const char *prefix);
+struct param_d *param_next_with_prefix(struct param_d *p, const char *prefix);
 
 struct param_d *bobject_add_param(bobject_t bobj, const char *name,
 			      int (*set)(bobject_t bobj, struct param_d *p, const char *val),
@@ -136,6 +139,18 @@ static inline struct param_d *get_param_by_name(bobject_t bobj,
 	return NULL;
 }
 
+static inline struct param_d *param_first_with_prefix(bobject_t bobj,
+						      const char *prefix)
+{
+	return NULL;
+}
+
+static inline struct param_d *param_next_with_prefix(struct param_d *p,
+						     const char *prefix)
+{
+	return NULL;
+}
+
 static inline struct param_d *bobject_add_param(bobject_t bobj,
 					    const char *name,
 					    int (*set)(bobject_t bobj, struct param_d *p, const char *val),
@@ -447,4 +462,12 @@ static inline struct param_d *bobject_add_param_bitmask_ro(bobject_t bobj,
  * dev_add_param_mac_ro
  * dev_add_param_mac_fixed
  */
+/*
+ * Iterate over the parameters of @bobj whose name starts with @prefix. The
+ * parameters must not be removed while iterating.
+ */
+#define bobject_for_each_param_prefix(bobj, p, prefix)			\
+	for ((p) = param_first_with_prefix(bobj, prefix); (p);		\
+	     (p) = param_next_with_prefix(p, prefix))
+
 #endif /* PARAM_H */
@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef __RAMFS_H
+#define __RAMFS_H
+
+#include <ioctl.h>
+#include <linux/types.h>
+
+/**
+ * struct ramfs_ext_data - contents of a ramfs file kept outside of ramfs
+ * @data: the file contents, must stay valid until @release is called
+ * @size: size of @data in bytes
+ * @release: called when the file no longer refers to @data, may be NULL
+ * @priv: passed to @release
+ */
+struct ramfs_ext_data {
+	const void *data;
+	size_t size;
+	void (*release)(void *priv);
+	void *priv;
+};
+
+/*
+ * Let a regular ramfs file refer to @data instead of holding a copy of it.
+ * Reads are served from @data directly, it is copied into the file on the
+ * first modification.
+ */
+#define RAMFS_IOC_SET_EXT_DATA	_IOW('r', 1, struct ramfs_ext_data)
+
+#endif /* __RAMFS_H */
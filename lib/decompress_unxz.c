@@ -382,3 +382,312 @@ STATIC int decompress_unxz(unsigned char *in, long in_size,
  * the kernel image.
  */
 #define decompress decompress_unxz
+
+#ifndef XZ_PREBOOT
+#include <malloc.h>
+#include <offload.h>
+#include <linux/kernel.h>
+#include <linux/overflow.h>
+#include <asm/unaligned.h>
+#include "xz/xz_stream.h"
+
+#define XZ_STREAM_FOOTER_SIZE	12
+/* index indicator, count, two records of at most 9 bytes, padding, CRC32 */
+#define XZ_INDEX_MAX_SIZE	ALIGN(1 + 1 + 9 + 9 + 4, 4)
+
+struct xz_block {
+	const u8 *in;
+	size_t unpadded;
+	size_t out_off;
+	size_t out_len;
+};
+
+static int xz_vli_decode(const u8 **p, const u8 *end, u64 *val)
+{
+	unsigned int i;
+
+	*val = 0;
+
+	for (i = 0; i < 9 && *p < end; i++) {
+		u8 byte = *(*p)++;
+
+		*val |= (u64)(byte & 0x7f) << (i * 7);
+		if (!(byte & 0x80))
+			return byte || !i ? 0 : -EINVAL;
+	}
+
+	return -EINVAL;
+}
+
+static u8 *xz_vli_encode(u8 *p, u64 val)
+{
+	while (val >= 0x80) {
+		*p++ = val | 0x80;
+		val >>= 7;
+	}
+
+	*p++ = val;
+
+	return p;
+}
+
+/*
+ * Index the blocks of a single stream from the index at its end, which
+ * records unpadded and uncompressed size of every block.
+ */
+static int xz_index_blocks(const u8 *in, size_t in_len, struct xz_block **blocks)
+{
+	const u8 *footer, *index, *p;
+	size_t index_size, in_off, out_off = 0;
+	u64 count, unpadded, uncompressed;
+	unsigned int i;
+
+	/* Skip stream padding */
+	while (in_len >= STREAM_HEADER_SIZE + XZ_STREAM_FOOTER_SIZE + 4 &&
+	       !get_unaligned_le32(in + in_len - 4))
+		in_len -= 4;
+
+	if (in_len < STREAM_HEADER_SIZE + XZ_STREAM_FOOTER_SIZE ||
+	    memcmp(in, HEADER_MAGIC, HEADER_MAGIC_SIZE))
+		return -ENOTSUPP;
+
+	footer = in + in_len - XZ_STREAM_FOOTER_SIZE;
+	if (memcmp(footer + 10, FOOTER_MAGIC, FOOTER_MAGIC_SIZE) ||
+	    memcmp(footer + 8, in + HEADER_MAGIC_SIZE, 2) ||
+	    xz_crc32(footer + 4, 6, 0) != get_unaligned_le32(footer))
+		return -ENOTSUPP;
+
+	index_size = ((size_t)get_unaligned_le32(footer + 4) + 1) * 4;
+	if (index_size > in_len - STREAM_HEADER_SIZE - XZ_STREAM_FOOTER_SIZE)
+		return -ENOTSUPP;
+
+	index = footer - index_size;
+	if (xz_crc32(index, index_size - 4, 0) !=
+	    get_unaligned_le32(footer - 4))
+		return -ENOTSUPP;
+
+	p = index + 1;
+	if (index[0] || xz_vli_decode(&p, footer, &count) ||
+	    !count || count > index_size / 2)
+		return -ENOTSUPP;
+
+	*blocks = xmalloc(count * sizeof(**blocks));
+	in_off = STREAM_HEADER_SIZE;
+
+	for (i = 0; i < count; i++) {
+		struct xz_block *b = &(*blocks)[i];
+
+		if (xz_vli_decode(&p, footer, &unpadded) ||
+		    xz_vli_decode(&p, footer, &uncompressed) ||
+		    !unpadded || ALIGN(unpadded, 4) > index - in - in_off)
+			goto err;
+
+		/* the sizes are untrusted and may not fit into size_t */
+		if (uncompressed > SIZE_MAX)
+			goto err;
+
+		b->in = in + in_off;
+		b->unpadded = unpadded;
+		b->out_off = out_off;
+		b->out_len = uncompressed;
+
+		in_off += ALIGN(unpadded, 4);
+		if (check_add_overflow(out_off, b->out_len, &out_off))
+			goto err;
+	}
+
+	if (in + in_off != index)
+		goto err;
+
+	return count;
+err:
+	free(*blocks);
+	return -ENOTSUPP;
+}
+
+struct xz_blocks_job {
+	struct offload_job job;
+	const u8 *stream_header;
+	const struct xz_block *blocks;
+	unsigned int nblocks;
+	struct xz_dec *s;
+	u8 *out;
+	u8 *scratch;
+};
+
+/*
+ * Wrap a single block into a stream of its own with a matching index,
+ * so it can be decoded with the unmodified stream decoder.
+ */
+static size_t xz_block_to_stream(u8 *stream, const u8 *stream_header,
+				 const struct xz_block *b)
+{
+	size_t block_size = ALIGN(b->unpadded, 4);
+	u8 *p, *index, *footer;
+	u32 backward;
+
+	memcpy(stream, stream_header, STREAM_HEADER_SIZE);
+	memcpy(stream + STREAM_HEADER_SIZE, b->in, block_size);
+
+	index = p = stream + STREAM_HEADER_SIZE + block_size;
+	*p++ = 0;
+	p = xz_vli_encode(p, 1);
+	p = xz_vli_encode(p, b->unpadded);
+	p = xz_vli_encode(p, b->out_len);
+	while ((p - index) % 4)
+		*p++ = 0;
+	put_unaligned_le32(xz_crc32(index, p - index, 0), p);
+	p += 4;
+
+	footer = p;
+	backward = (footer - index) / 4 - 1;
+	put_unaligned_le32(backward, footer + 4);
+	memcpy(footer + 8, stream_header + HEADER_MAGIC_SIZE, 2);
+	put_unaligned_le32(xz_crc32(footer + 4, 6, 0), footer);
+	memcpy(footer + 10, FOOTER_MAGIC, FOOTER_MAGIC_SIZE);
+
+	return footer + XZ_STREAM_FOOTER_SIZE - stream;
+}
+
+static int xz_blocks_job_fn(struct offload_job *job)
+{
+	struct xz_blocks_job *xj = container_of(job, struct xz_blocks_job, job);
+	unsigned int i;
+
+	for (i = 0; i < xj->nblocks; i++) {
+		const struct xz_block *blk = &xj->blocks[i];
+		struct xz_buf b = {
+			.in = xj->scratch,
+			.out = xj->out + blk->out_off,
+			.out_size = blk->out_len,
+		};
+
+		b.in_size = xz_block_to_stream(xj->scratch, xj->stream_header, blk);
+
+		if (xz_dec_run(xj->s, &b) != XZ_STREAM_END ||
+		    b.out_pos != blk->out_len)
+			return -EILSEQ;
+	}
+
+	return 0;
+}
+
+/**
+ * unxz_parallel - decompress a multi-block xz buffer on all CPUs
+ * @in: compressed input
+ * @in_len: size of @in
+ * @out: returns the newly allocated output buffer
+ * @error: error reporting callback
+ *
+ * Multi-threaded xz (xz -T) splits the input into blocks that are
+ * compressed independently and records their sizes in the stream index.
+ * Using the index, each block is decompressed straight to its final
+ * offset, independently of the others.
+ *
+ * Return: decompressed size, -ENOTSUPP if the input is not a single
+ * stream with an index, in which case the caller should fall back to
+ * decompress_unxz(), or another negative error code.
+ */
+ssize_t unxz_parallel(const void *in, size_t in_len, void **out,
+		      void (*error)(char *x))
+{
+	struct xz_blocks_job *jobs;
+	struct xz_block *blocks;
+	unsigned int i, j, njobs, nblocks, first;
+	size_t total, share, scratch;
+	u8 *buf;
+	int ret;
+
+	xz_crc32_init();
+
+	ret = xz_index_blocks(in, in_len, &blocks);
+	if (ret < 0)
+		return ret;
+
+	nblocks = ret;
+	total = blocks[nblocks - 1].out_off + blocks[nblocks - 1].out_len;
+	if (!total) {
+		free(blocks);
+		return -ENOTSUPP;
+	}
+
+	for (i = 0; i < nblocks; i++) {
+		if (blocks[i].out_off > total ||
+		    blocks[i].out_len > total - blocks[i].out_off) {
+			free(blocks);
+			return -EINVAL;
+		}
+	}
+
+	buf = malloc(total);
+	if (!buf) {
+		free(blocks);
+		return -ENOMEM;
+	}
+
+	njobs = min(offload_num_cpus(), nblocks);
+	jobs = xzalloc(njobs * sizeof(*jobs));
+	share = DIV_ROUND_UP(total, njobs);
+
+	/* split blocks into runs of about the same decompressed size */
+	for (i = 0, j = 0, first = 0, scratch = 0; i < nblocks && j < njobs; i++) {
+		size_t end = blocks[i].out_off + blocks[i].out_len;
+
+		scratch = max(scratch, ALIGN(blocks[i].unpadded, 4));
+
+		if (end < share * (j + 1) && i != nblocks - 1)
+			continue;
+
+		jobs[j].stream_header = in;
+		jobs[j].blocks = &blocks[first];
+		jobs[j].nblocks = i - first + 1;
+		jobs[j].out = buf;
+		jobs[j].s = xz_dec_init(XZ_SINGLE, 0);
+		jobs[j].scratch = malloc(STREAM_HEADER_SIZE + scratch +
+					 XZ_INDEX_MAX_SIZE + XZ_STREAM_FOOTER_SIZE);
+		if (!jobs[j].s || !jobs[j].scratch) {
+			ret = -ENOMEM;
+			j++;
+			goto out;
+		}
+
+		first = i + 1;
+		scratch = 0;
+		j++;
+	}
+
+	njobs = j;
+
+	for (j = 0; j < njobs; j++) {
+		offload_job_init(&jobs[j].job, xz_blocks_job_fn);
+		offload_job_submit(&jobs[j].job);
+	}
+
+	ret = 0;
+	for (j = 0; j < njobs; j++) {
+		int err = offload_job_wait(&jobs[j].job);
+
+		if (err && !ret)
+			ret = err;
+	}
+
+	if (ret)
+		error("XZ-compressed data is corrupt");
+
+out:
+	while (j--) {
+		xz_dec_end(jobs[j].s);
+		free(jobs[j].scratch);
+	}
+	free(jobs);
+	free(blocks);
+
+	if (ret) {
+		free(buf);
+		return ret;
+	}
+
+	*out = buf;
+	return total;
+}
+#endif /* XZ_PREBOOT */
@@ -53,8 +53,27 @@
  *                 <= 22 + (uncompressed_size >> 15) + 131072
  */
 
-#ifndef STATIC
+/*
+ * STATIC is defined by linux/decompress/mm.h in any case, so remember
+ * here whether we are built for the pre-boot environment.
+ */
+#ifdef STATIC
+#define ZSTD_PREBOOT
+#include "xxhash.c"
+#include "zstd/entropy_common.c"
+#include "zstd/fse_decompress.c"
+/* a local variant, zstd_internal.h defines the common one */
+#undef CHECK_F
+#include "zstd/huf_decompress.c"
+#include "zstd/zstd_common.c"
+#include "zstd/decompress.c"
+#else
 #include <linux/decompress/unzstd.h>
+#include <malloc.h>
+#include <offload.h>
+#include <asm/unaligned.h>
+#include <linux/bits.h>
+#include <linux/overflow.h>
 #endif
 
 #include <linux/decompress/mm.h>
@@ -97,6 +116,29 @@ static int INIT handle_zstd_error(size_t ret, void (*error)(char *x))
 	return -1;
 }
 
+/*
+ * Returns the length of the run of zstd and skippable frames at the start
+ * of the buffer. Anything after that is junk we must not pass to zstd.
+ */
+static size_t INIT zstd_frames_size(const u8 *in_buf, size_t in_len)
+{
+	size_t pos, ret;
+
+	/* The first frame must be valid, let zstd report the error if not */
+	pos = ZSTD_findFrameCompressedSize(in_buf, in_len);
+	if (ZSTD_isError(pos))
+		return pos;
+
+	while (in_len - pos >= 4 && ZSTD_isFrame(in_buf + pos, in_len - pos)) {
+		ret = ZSTD_findFrameCompressedSize(in_buf + pos, in_len - pos);
+		if (ZSTD_isError(ret))
+			break;
+		pos += ret;
+	}
+
+	return pos;
+}
+
 /*
  * Handle the case where we have the entire input and output in one segment.
  * We can allocate less memory (no circular buffer for the sliding window),
@@ -118,10 +160,10 @@ static int INIT decompress_single(const u8 *in_buf, long in_len, u8 *out_buf,
 		goto out;
 	}
 	/*
-	 * Find out how large the frame actually is, there may be junk at
-	 * the end of the frame that ZSTD_decompressDCtx() can't handle.
+	 * Find out how large the frames actually are, there may be junk at
+	 * the end of the last frame that ZSTD_decompressDCtx() can't handle.
 	 */
-	ret = ZSTD_findFrameCompressedSize(in_buf, in_len);
+	ret = zstd_frames_size(in_buf, in_len);
 	err = handle_zstd_error(ret, error);
 	if (err)
 		goto out;
@@ -142,6 +184,35 @@ static int INIT decompress_single(const u8 *in_buf, long in_len, u8 *out_buf,
 	return err;
 }
 
+/*
+ * Called in streaming mode when a frame is complete. Returns true if
+ * another frame follows, refilling the input buffer as needed so that
+ * at least the frame magic is available.
+ */
+static bool INIT zstd_stream_next_frame(ZSTD_inBuffer *in, u8 *in_buf,
+					long (*fill)(void*, unsigned long),
+					long *in_pos)
+{
+	size_t left = in->size - in->pos;
+	long len;
+
+	if (left < 4 && fill) {
+		if (in_pos != NULL)
+			*in_pos += in->pos;
+
+		memmove(in_buf, in_buf + in->pos, left);
+		len = fill(in_buf + left, ZSTD_IOBUF_SIZE - left);
+		if (len < 0)
+			len = 0;
+
+		in->pos = 0;
+		in->size = left + len;
+		left = in->size;
+	}
+
+	return left >= 4 && ZSTD_isFrame((const u8 *)in->src + in->pos, left);
+}
+
 static int INIT __unzstd(unsigned char *in_buf, long in_len,
 			 long (*fill)(void*, unsigned long),
 			 long (*flush)(void*, unsigned long),
@@ -293,6 +364,14 @@ static int INIT __unzstd(unsigned char *in_buf, long in_len,
 			}
 			out.pos = 0;
 		}
+		/* Concatenated frames are decoded one after the other */
+		if (ret == 0 && zstd_stream_next_frame(&in, in_buf, fill, in_pos)) {
+			ret = ZSTD_resetDStream(dstream);
+			err = handle_zstd_error(ret, error);
+			if (err)
+				goto out;
+			ret = 1;
+		}
 	} while (ret != 0);
 
 	if (in_pos != NULL)
@@ -318,3 +397,282 @@ STATIC int INIT unzstd(unsigned char *buf, long len,
 {
 	return __unzstd(buf, len, fill, flush, out_buf, 0, pos, error);
 }
+
+/*
+ * This macro is used by architecture-specific files to decompress
+ * the kernel image.
+ */
+#define decompress unzstd
+
+#ifndef ZSTD_PREBOOT
+
+#define ZSTD_SEEKABLE_MAGIC		0x8F92EAB1
+#define ZSTD_SEEKABLE_SKIPPABLE_MAGIC	0x184D2A5E
+#define ZSTD_SEEKABLE_FOOTER_SIZE	9
+#define ZSTD_SEEKABLE_CHECKSUM_FLAG	BIT(7)
+
+struct zstd_frame {
+	const u8 *in;
+	size_t in_len;
+	size_t out_off;
+	size_t out_len;
+};
+
+/*
+ * Index the frames from the seek table of the zstd seekable format,
+ * which stores compressed and decompressed size of each frame in a
+ * skippable frame at the very end of the input.
+ */
+static int zstd_index_seek_table(const u8 *in, size_t in_len,
+				 struct zstd_frame **frames)
+{
+	const u8 *footer, *entry, *table;
+	size_t entry_size, table_size, in_off = 0, out_off = 0;
+	unsigned int i, nframes;
+
+	if (in_len < ZSTD_skippableHeaderSize + ZSTD_SEEKABLE_FOOTER_SIZE)
+		return -ENOENT;
+
+	footer = in + in_len - ZSTD_SEEKABLE_FOOTER_SIZE;
+	if (get_unaligned_le32(footer + 5) != ZSTD_SEEKABLE_MAGIC)
+		return -ENOENT;
+
+	nframes = get_unaligned_le32(footer);
+	entry_size = footer[4] & ZSTD_SEEKABLE_CHECKSUM_FLAG ? 12 : 8;
+	if (!nframes || nframes > in_len / entry_size)
+		return -EINVAL;
+
+	table_size = nframes * entry_size + ZSTD_SEEKABLE_FOOTER_SIZE;
+	if (table_size + ZSTD_skippableHeaderSize > in_len)
+		return -EINVAL;
+
+	table = footer + ZSTD_SEEKABLE_FOOTER_SIZE - table_size;
+	if (get_unaligned_le32(table - 8) != ZSTD_SEEKABLE_SKIPPABLE_MAGIC ||
+	    get_unaligned_le32(table - 4) != table_size)
+		return -EINVAL;
+
+	*frames = xmalloc(nframes * sizeof(**frames));
+
+	for (i = 0, entry = table; i < nframes; i++, entry += entry_size) {
+		struct zstd_frame *f = &(*frames)[i];
+
+		f->in = in + in_off;
+		f->in_len = get_unaligned_le32(entry);
+		f->out_off = out_off;
+		f->out_len = get_unaligned_le32(entry + 4);
+
+		/* the sizes are untrusted, even u32 sums wrap on 32-bit */
+		if (check_add_overflow(in_off, f->in_len, &in_off) ||
+		    check_add_overflow(out_off, f->out_len, &out_off) ||
+		    in_off > table - 8 - in) {
+			free(*frames);
+			return -EINVAL;
+		}
+	}
+
+	return nframes;
+}
+
+/*
+ * Index the frames by walking the frame headers. This only works if
+ * all frames record their decompressed size, which zstd does when the
+ * input size is known at compression time.
+ */
+static int zstd_index_frames(const u8 *in, size_t in_len,
+			     struct zstd_frame **frames)
+{
+	size_t pos = 0, out_off = 0, len;
+	unsigned long long out_len;
+	unsigned int nframes = 0, max = 0;
+	struct zstd_frame *f;
+
+	*frames = NULL;
+
+	while (in_len - pos >= 4 && ZSTD_isFrame(in + pos, in_len - pos)) {
+		len = ZSTD_findFrameCompressedSize(in + pos, in_len - pos);
+		if (ZSTD_isError(len))
+			goto err;
+
+		out_len = ZSTD_getFrameContentSize(in + pos, in_len - pos);
+		if (out_len == ZSTD_CONTENTSIZE_ERROR ||
+		    out_len == ZSTD_CONTENTSIZE_UNKNOWN)
+			goto err;
+
+		if (out_len > SIZE_MAX)
+			goto err_size;
+
+		/* skippable frames have a content size of 0 */
+		if (out_len) {
+			if (nframes == max) {
+				max = max ? max * 2 : 16;
+				*frames = xrealloc(*frames, max * sizeof(**frames));
+			}
+
+			f = &(*frames)[nframes++];
+			f->in = in + pos;
+			f->in_len = len;
+			f->out_off = out_off;
+			f->out_len = out_len;
+
+			if (check_add_overflow(out_off, f->out_len, &out_off))
+				goto err_size;
+		}
+
+		pos += len;
+	}
+
+	if (nframes)
+		return nframes;
+err:
+	free(*frames);
+	return -ENOTSUPP;
+err_size:
+	free(*frames);
+	return -EINVAL;
+}
+
+struct zstd_frames_job {
+	struct offload_job job;
+	const struct zstd_frame *frames;
+	unsigned int nframes;
+	u8 *out;
+	void *wksp;
+	size_t wksp_size;
+};
+
+static int zstd_frames_job_fn(struct offload_job *job)
+{
+	struct zstd_frames_job *zj = container_of(job, struct zstd_frames_job, job);
+	ZSTD_DCtx *dctx = ZSTD_initDCtx(zj->wksp, zj->wksp_size);
+	unsigned int i;
+	size_t ret;
+
+	if (!dctx)
+		return -ENOMEM;
+
+	for (i = 0; i < zj->nframes; i++) {
+		const struct zstd_frame *f = &zj->frames[i];
+
+		ret = ZSTD_decompressDCtx(dctx, zj->out + f->out_off, f->out_len,
+					  f->in, f->in_len);
+		if (ZSTD_isError(ret))
+			return ZSTD_getErrorCode(ret) == ZSTD_error_checksum_wrong ?
+				-EBADMSG : -EILSEQ;
+		if (ret != f->out_len)
+			return -EILSEQ;
+	}
+
+	return 0;
+}
+
+/**
+ * unzstd_parallel - decompress a multi-frame zstd buffer on all CPUs
+ * @in: compressed input
+ * @in_len: size of @in
+ * @out: returns the newly allocated output buffer
+ * @error: error reporting callback
+ *
+ * The frames are indexed up front, either from a seek table or from
+ * the frame headers, so that each frame can be decompressed straight
+ * to its final offset, independently of the others.
+ *
+ * Return: decompressed size, -ENOTSUPP if the frame sizes are not known
+ * up front, in which case the caller should fall back to unzstd(), or
+ * another negative error code.
+ */
+ssize_t unzstd_parallel(const void *in, size_t in_len, void **out,
+			void (*error)(char *x))
+{
+	struct zstd_frames_job *jobs;
+	struct zstd_frame *frames;
+	unsigned int i, j, njobs, nframes, first;
+	size_t total, share;
+	u8 *buf;
+	int ret;
+
+	ret = zstd_index_seek_table(in, in_len, &frames);
+	if (ret < 0)
+		ret = zstd_index_frames(in, in_len, &frames);
+	if (ret < 0)
+		return ret;
+
+	nframes = ret;
+	total = frames[nframes - 1].out_off + frames[nframes - 1].out_len;
+	if (!total) {
+		free(frames);
+		return -ENOTSUPP;
+	}
+
+	for (i = 0; i < nframes; i++) {
+		if (frames[i].out_off > total ||
+		    frames[i].out_len > total - frames[i].out_off) {
+			free(frames);
+			return -EINVAL;
+		}
+	}
+
+	buf = malloc(total);
+	if (!buf) {
+		free(frames);
+		return -ENOMEM;
+	}
+
+	njobs = min(offload_num_cpus(), nframes);
+	jobs = xzalloc(njobs * sizeof(*jobs));
+	share = DIV_ROUND_UP(total, njobs);
+
+	/* split frames into runs of about the same decompressed size */
+	for (i = 0, j = 0, first = 0; i < nframes && j < njobs; i++) {
+		size_t end = frames[i].out_off + frames[i].out_len;
+
+		if (end < share * (j + 1) && i != nframes - 1)
+			continue;
+
+		jobs[j].frames = &frames[first];
+		jobs[j].nframes = i - first + 1;
+		jobs[j].out = buf;
+		jobs[j].wksp_size = ZSTD_DCtxWorkspaceBound();
+		jobs[j].wksp = malloc(jobs[j].wksp_size);
+		if (!jobs[j].wksp) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		first = i + 1;
+		j++;
+	}
+
+	njobs = j;
+
+	for (j = 0; j < njobs; j++) {
+		offload_job_init(&jobs[j].job, zstd_frames_job_fn);
+		offload_job_submit(&jobs[j].job);
+	}
+
+	ret = 0;
+	for (j = 0; j < njobs; j++) {
+		int err = offload_job_wait(&jobs[j].job);
+
+		if (err && !ret)
+			ret = err;
+	}
+
+	if (ret)
+		error("ZSTD-compressed data is corrupt");
+
+out:
+	for (j = 0; j < njobs; j++)
+		free(jobs[j].wksp);
+	free(jobs);
+	free(frames);
+
+	if (ret) {
+		free(buf);
+		return ret;
+	}
+
+	*out = buf;
+	return total;
+}
+
+#endif /* ZSTD_PREBOOT */
@@ -43,31 +43,14 @@ static int bmp_renderer(struct screen *sc, struct surface *s, struct image *img)
 	int bits_per_pixel;
 	void *adr, *buf;
 	char *image;
-	int width = s->width;
-	int height = s->height;
-	int startx = s->x;
-	int starty = s->y;
-
-	if (s->width < 0)
-		width = img->width;
-
-	if (s->height < 0)
-		height = img->height;
-
-	if (startx < 0) {
-		startx = (sc->s.width - width) / 2;
-		if (startx < 0)
-			startx = 0;
-	}
-
-	if (starty < 0) {
-		starty = (sc->s.height - height) / 2;
-		if (starty < 0)
-			starty = 0;
-	}
-
-	width = min(width, sc->s.width - startx);
-	height = min(height, sc->s.height - starty);
+	struct surface area;
+	int width, height, startx, starty;
+
+	image_renderer_area(sc, s, img, &area);
+	width = area.width;
+	height = area.height;
+	startx = area.x;
+	starty = area.y;
 
 	buf = gui_screen_render_buffer(sc);
 
@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Cache for rendered images
+ *
+ * Decoding and converting an image is slow compared to copying the
+ * result into the framebuffer. The cache stores the rendered screen area
+ * in framebuffer native format together with everything the result
+ * depends on. When the key matches, the pixels are copied into the render
+ * buffer, otherwise the image is rendered and the cache is rewritten.
+ */
+
+#define pr_fmt(fmt) "image-cache: " fmt
+
+#include <common.h>
+#include <fb.h>
+#include <fcntl.h>
+#include <fs.h>
+#include <crc.h>
+#include <malloc.h>
+#include <libfile.h>
+#include <linux/stat.h>
+#include <gui/graphic_utils.h>
+#include <gui/image_renderer.h>
+
+#define IMAGE_CACHE_MAGIC	0x43474d49	/* "IMGC" */
+#define IMAGE_CACHE_VERSION	1
+
+struct image_cache_key {
+	u32 src_crc;
+	u32 src_size;
+	u32 xres;
+	u32 yres;
+	u32 bits_per_pixel;
+	u32 line_length;
+	struct fb_bitfield red;
+	struct fb_bitfield green;
+	struct fb_bitfield blue;
+	struct fb_bitfield transp;
+	struct surface s;
+	u64 cookie;
+};
+
+/*
+ * The cache is only ever read back on the machine that wrote it, so the
+ * header is stored in native byte order.
+ */
+struct image_cache_header {
+	u32 magic;
+	u32 version;
+	struct image_cache_key key;
+	struct surface area;
+	u32 data_size;
+	u32 data_crc;
+	u32 header_crc;
+};
+
+static void image_cache_key_init(struct image_cache_key *key,
+				 struct screen *sc, struct surface *s,
+				 const void *src, size_t src_size, u64 cookie)
+{
+	struct fb_info *info = sc->info;
+
+	memset(key, 0, sizeof(*key));
+
+	key->src_crc = crc32(0, src, src_size);
+	key->src_size = src_size;
+	key->xres = info->xres;
+	key->yres = info->yres;
+	key->bits_per_pixel = info->bits_per_pixel;
+	key->line_length = info->line_length;
+	key->red = info->red;
+	key->green = info->green;
+	key->blue = info->blue;
+	key->transp = info->transp;
+	key->s = *s;
+	key->cookie = cookie;
+}
+
+static u32 image_cache_header_crc(const struct image_cache_header *hdr)
+{
+	return crc32(0, hdr, offsetof(struct image_cache_header, header_crc));
+}
+
+static int image_cache_area_valid(struct screen *sc, const struct surface *a)
+{
+	return a->x >= 0 && a->y >= 0 && a->width > 0 && a->height > 0 &&
+	       a->x + a->width <= sc->s.width &&
+	       a->y + a->height <= sc->s.height;
+}
+
+/* Copy the cached pixels of an area into the render buffer */
+static void image_cache_put_area(struct screen *sc, const struct surface *area,
+				 const void *data)
+{
+	struct fb_info *info = sc->info;
+	size_t rowlen = area->width * (info->bits_per_pixel >> 3);
+	void *buf = gui_screen_render_buffer(sc);
+	int y;
+
+	buf += area->y * info->line_length +
+	       area->x * (info->bits_per_pixel >> 3);
+
+	for (y = 0; y < area->height; y++) {
+		memcpy(buf, data, rowlen);
+		data += rowlen;
+		buf += info->line_length;
+	}
+}
+
+static int image_cache_load(struct screen *sc, const char *cache,
+			    const struct image_cache_key *key)
+{
+	struct image_cache_header hdr;
+	void *data = NULL;
+	int fd, ret;
+
+	fd = open(cache, O_RDONLY);
+	if (fd < 0)
+		return fd;
+
+	ret = read_full(fd, &hdr, sizeof(hdr));
+	if (ret < (int)sizeof(hdr)) {
+		ret = ret < 0 ? ret : -ENODATA;
+		goto out;
+	}
+
+	if (hdr.magic != IMAGE_CACHE_MAGIC ||
+	    hdr.version != IMAGE_CACHE_VERSION ||
+	    hdr.header_crc != image_cache_header_crc(&hdr) ||
+	    memcmp(&hdr.key, key, sizeof(*key)) ||
+	    !image_cache_area_valid(sc, &hdr.area) ||
+	    hdr.data_size != hdr.area.width * hdr.area.height *
+			     (key->bits_per_pixel >> 3)) {
+		ret = -ESTALE;
+		goto out;
+	}
+
+	/*
+	 * Don't read into the render buffer directly: on a short read or
+	 * a torn cache write the image is rendered again, and alpha
+	 * blending on top of garbage would end up in the cache as well.
+	 */
+	data = malloc(hdr.data_size);
+	if (!data) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ret = read_full(fd, data, hdr.data_size);
+	if (ret < (int)hdr.data_size) {
+		ret = ret < 0 ? ret : -ENODATA;
+		goto out;
+	}
+
+	if (crc32(0, data, hdr.data_size) != hdr.data_crc) {
+		ret = -EILSEQ;
+		goto out;
+	}
+
+	image_cache_put_area(sc, &hdr.area, data);
+	ret = 0;
+out:
+	free(data);
+	close(fd);
+
+	return ret;
+}
+
+static int image_cache_open_write(const char *cache)
+{
+	struct stat s;
+	int fd, ret;
+
+	/* partitions can't be truncated, but may have to be erased */
+	if (stat(cache, &s) || S_ISREG(s.st_mode))
+		return open(cache, O_WRONLY | O_CREAT | O_TRUNC);
+
+	fd = open(cache, O_WRONLY);
+	if (fd < 0)
+		return fd;
+
+	ret = erase(fd, ERASE_SIZE_ALL, 0, ERASE_TO_WRITE);
+	if (ret && ret != -ENOSYS) {
+		close(fd);
+		return ret;
+	}
+
+	return fd;
+}
+
+static int image_cache_save(struct screen *sc, const char *cache,
+			    const struct image_cache_key *key,
+			    const struct surface *area)
+{
+	struct fb_info *info = sc->info;
+	size_t rowlen = area->width * (info->bits_per_pixel >> 3);
+	struct image_cache_header hdr = {
+		.magic = IMAGE_CACHE_MAGIC,
+		.version = IMAGE_CACHE_VERSION,
+		.key = *key,
+		.area = *area,
+		.data_size = rowlen * area->height,
+	};
+	void *buf, *data, *p;
+	int fd, y, ret;
+
+	if (!image_cache_area_valid(sc, area))
+		return -EINVAL;
+
+	data = malloc(sizeof(hdr) + hdr.data_size);
+	if (!data)
+		return -ENOMEM;
+
+	buf = gui_screen_render_buffer(sc);
+	buf += area->y * info->line_length +
+	       area->x * (info->bits_per_pixel >> 3);
+
+	p = data + sizeof(hdr);
+	for (y = 0; y < area->height; y++) {
+		memcpy(p, buf, rowlen);
+		p += rowlen;
+		buf += info->line_length;
+	}
+
+	hdr.data_crc = crc32(0, data + sizeof(hdr), hdr.data_size);
+	hdr.header_crc = image_cache_header_crc(&hdr);
+	memcpy(data, &hdr, sizeof(hdr));
+
+	fd = image_cache_open_write(cache);
+	if (fd < 0) {
+		ret = fd;
+		goto out;
+	}
+
+	ret = write_full(fd, data, sizeof(hdr) + hdr.data_size);
+	if (ret > 0)
+		ret = 0;
+
+	close(fd);
+out:
+	free(data);
+
+	return ret;
+}
+
+/**
+ * image_renderer_file_cached - render an image file using a cache
+ * @sc: the screen
+ * @s: requested position and size, see image_renderer_area()
+ * @file: the image file
+ * @cache: file or partition to cache the rendered image in
+ * @cookie: arbitrary value that is part of the cache key. Callers pass
+ *          everything else the rendered pixels depend on, like the
+ *          background colour alpha blended images are drawn on.
+ *
+ * Return: 0 for success or a negative error code. Failing to update the
+ * cache is not an error.
+ */
+int image_renderer_file_cached(struct screen *sc, struct surface *s,
+			       const char *file, const char *cache,
+			       u64 cookie)
+{
+	struct image_cache_key key;
+	struct surface area;
+	struct image *img;
+	size_t size;
+	void *data;
+	int ret;
+
+	ret = read_file_2(file, &size, &data, FILESIZE_MAX);
+	if (ret) {
+		printf("unable to read %s: %pe\n", file, ERR_PTR(ret));
+		return ret;
+	}
+
+	image_cache_key_init(&key, sc, s, data, size, cookie);
+
+	ret = image_cache_load(sc, cache, &key);
+	if (!ret) {
+		free(data);
+		return 0;
+	}
+
+	pr_debug("%s: cache miss: %pe\n", cache, ERR_PTR(ret));
+
+	img = image_renderer_open_buf(data, size);
+	if (IS_ERR(img))
+		return PTR_ERR(img);
+
+	ret = image_renderer_image(sc, s, img);
+	if (ret >= 0) {
+		image_renderer_area(sc, s, img, &area);
+
+		ret = image_cache_save(sc, cache, &key, &area);
+		if (ret)
+			pr_warn("%s: failed to update cache: %pe\n",
+				cache, ERR_PTR(ret));
+		ret = 0;
+	}
+
+	image_renderer_close(img);
+
+	return ret;
+}
@@ -29,20 +29,16 @@ static struct image_renderer *get_renderer(void* buf, size_t bufsize)
 	return NULL;
 }
 
-struct image *image_renderer_open(const char* file)
+/*
+ * Open an image from a buffer allocated with malloc. The buffer is
+ * owned by the image afterwards, also in the error case.
+ */
+struct image *image_renderer_open_buf(void *data, size_t size)
 {
-	void *data;
-	size_t size;
 	struct image_renderer *ir;
 	struct image *img;
 	int ret;
 
-	ret = read_file_2(file, &size, &data, FILESIZE_MAX);
-	if (ret) {
-		printf("unable to read %s: %pe\n", file, ERR_PTR(ret));
-		return ERR_PTR(ret);
-	}
-
 	ir = get_renderer(data, size);
 	if (!ir) {
 		ret = -ENOENT;
@@ -64,6 +60,21 @@ struct image *image_renderer_open(const char* file)
 	return ERR_PTR(ret);
 }
 
+struct image *image_renderer_open(const char* file)
+{
+	void *data;
+	size_t size;
+	int ret;
+
+	ret = read_file_2(file, &size, &data, FILESIZE_MAX);
+	if (ret) {
+		printf("unable to read %s: %pe\n", file, ERR_PTR(ret));
+		return ERR_PTR(ret);
+	}
+
+	return image_renderer_open_buf(data, size);
+}
+
 void image_renderer_close(struct image *img)
 {
 	if (!img)
@@ -74,6 +85,33 @@ void image_renderer_close(struct image *img)
 	free(img);
 }
 
+/**
+ * image_renderer_area - get the screen area an image is rendered to
+ * @sc: the screen
+ * @s: requested position and size, negative values for defaults
+ * @img: the image
+ * @area: returns the area, clipped to the screen
+ *
+ * By default images are centered on the screen at their native size.
+ */
+void image_renderer_area(struct screen *sc, struct surface *s,
+			 struct image *img, struct surface *area)
+{
+	area->width = s->width < 0 ? img->width : s->width;
+	area->height = s->height < 0 ? img->height : s->height;
+	area->x = s->x;
+	area->y = s->y;
+
+	if (area->x < 0)
+		area->x = max((sc->s.width - area->width) / 2, 0);
+
+	if (area->y < 0)
+		area->y = max((sc->s.height - area->height) / 2, 0);
+
+	area->width = min(area->width, sc->s.width - area->x);
+	area->height = min(area->height, sc->s.height - area->y);
+}
+
 int image_renderer_image(struct screen *sc, struct surface *s, struct image *img)
 {
 	return img->ir->renderer(sc, s, img);
@@ -40,36 +40,15 @@ void png_uncompress_exit(void)
 
 static int png_renderer(struct screen *sc, struct surface *s, struct image *img)
 {
+	struct surface area;
 	void *buf;
-	int width = s->width;
-	int height = s->height;
-	int startx = s->x;
-	int starty = s->y;
 
-	if (s->width < 0)
-		width = img->width;
-
-	if (s->height < 0)
-		height = img->height;
-
-	if (startx < 0) {
-		startx = (sc->s.width - width) / 2;
-		if (startx < 0)
-			startx = 0;
-	}
-
-	if (starty < 0) {
-		starty = (sc->s.height - height) / 2;
-		if (starty < 0)
-			starty = 0;
-	}
-
-	width = min(width, sc->s.width - startx);
-	height = min(height, sc->s.height - starty);
+	image_renderer_area(sc, s, img, &area);
 
 	buf = gui_screen_render_buffer(sc);
 
-	gu_rgba_blend(sc->info, img, buf, height, width, startx, starty, true);
+	gu_rgba_blend(sc->info, img, buf, area.height, area.width,
+		      area.x, area.y, true);
 
 	return img->height;
 }
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Ring buffer of binary log records
+ *
+ * Records are written back to back and wrap around at the end of the
+ * buffer, overwriting the oldest records when the buffer is full. There
+ * is only a single writer and nothing is ever allocated, so this can be
+ * used before malloc is available and in the PBL.
+ */
+
+#include <common.h>
+#include <logbuf.h>
+#include <linux/string.h>
+
+#define LOG_ENTRY_HDR	sizeof(struct log_entry)
+#define LOG_ENTRY_ALIGN	8
+
+static inline struct log_entry *logbuf_entry(const struct logbuf *lb, u32 off)
+{
+	return (void *)lb + off;
+}
+
+/* offset of the record at @off, following a wrap if needed */
+static u32 logbuf_wrap(const struct logbuf *lb, u32 off)
+{
+	if (off + LOG_ENTRY_HDR > lb->size || !logbuf_entry(lb, off)->size)
+		return sizeof(*lb);
+
+	return off;
+}
+
+/**
+ * logbuf_init - initialize a log ring buffer
+ * @buf: memory for the buffer, must be 8 byte aligned
+ * @size: size of @buf
+ *
+ * Return: the buffer, which is the same as @buf
+ */
+struct logbuf *logbuf_init(void *buf, size_t size)
+{
+	struct logbuf *lb = buf;
+
+	memset(lb, 0, sizeof(*lb));
+
+	lb->magic = LOGBUF_MAGIC;
+	lb->version = LOGBUF_VERSION;
+	lb->size = ALIGN_DOWN(size, LOG_ENTRY_ALIGN);
+	lb->head = lb->tail = sizeof(*lb);
+
+	return lb;
+}
+
+/**
+ * logbuf_valid - check if memory contains a valid log ring buffer
+ * @lb: the buffer
+ * @size: size of the memory @lb points to
+ */
+bool logbuf_valid(const struct logbuf *lb, size_t size)
+{
+	return size >= sizeof(*lb) && lb->magic == LOGBUF_MAGIC &&
+	       lb->version == LOGBUF_VERSION && lb->size <= size &&
+	       lb->head >= sizeof(*lb) && lb->head < lb->size &&
+	       lb->tail >= sizeof(*lb) && lb->tail <= lb->size;
+}
+
+void logbuf_drop_oldest(struct logbuf *lb)
+{
+	struct log_entry *e;
+
+	if (!lb->num)
+		return;
+
+	e = logbuf_entry(lb, logbuf_wrap(lb, lb->head));
+
+	lb->head = logbuf_wrap(lb, (void *)e - (void *)lb + e->size);
+	lb->num--;
+	lb->dropped++;
+
+	if (!lb->num)
+		lb->head = lb->tail = sizeof(*lb);
+}
+
+/*
+ * Find room for a record of @size bytes, dropping old records as needed.
+ * The tail never catches up with the head, so that head == tail always
+ * means the buffer is empty.
+ */
+static u32 logbuf_reserve(struct logbuf *lb, u32 size)
+{
+	while (lb->num) {
+		if (lb->tail > lb->head) {
+			if (lb->tail + size <= lb->size)
+				return lb->tail;
+
+			if (sizeof(*lb) + size < lb->head) {
+				if (lb->tail + LOG_ENTRY_HDR <= lb->size)
+					logbuf_entry(lb, lb->tail)->size = 0;
+				return sizeof(*lb);
+			}
+		} else if (lb->tail + size < lb->head) {
+			return lb->tail;
+		}
+
+		logbuf_drop_oldest(lb);
+	}
+
+	return lb->tail;
+}
+
+/**
+ * logbuf_add - add a message to a log ring buffer
+ * @lb: the buffer
+ * @timestamp: timestamp of the message
+ * @level: log level of the message
+ * @flags: LOG_ENTRY_* flags
+ * @msg: the message
+ *
+ * Messages not fitting into a quarter of the buffer are truncated.
+ *
+ * Return: the new record
+ */
+struct log_entry *logbuf_add(struct logbuf *lb, u64 timestamp, int level,
+			     unsigned int flags, const char *msg)
+{
+	size_t maxlen = min_t(size_t, (lb->size - sizeof(*lb)) / 4, U16_MAX) -
+			LOG_ENTRY_HDR - LOG_ENTRY_ALIGN;
+	size_t len = strlen(msg);
+	struct log_entry *e;
+	u32 size, off;
+
+	if (len > maxlen) {
+		len = maxlen;
+		flags |= LOG_ENTRY_TRUNCATED;
+	}
+
+	size = ALIGN(LOG_ENTRY_HDR + len + 1, LOG_ENTRY_ALIGN);
+
+	off = logbuf_reserve(lb, size);
+
+	e = logbuf_entry(lb, off);
+	e->timestamp = timestamp;
+	e->size = size;
+	e->level = level;
+	e->flags = flags;
+	memcpy(e->msg, msg, len);
+	e->msg[len] = '\0';
+
+	lb->tail = off + size;
+	lb->num++;
+
+	return e;
+}
+
+struct log_entry *logbuf_first(const struct logbuf *lb)
+{
+	if (!lb->num)
+		return NULL;
+
+	return logbuf_entry(lb, logbuf_wrap(lb, lb->head));
+}
+
+struct log_entry *logbuf_next(const struct logbuf *lb,
+			      const struct log_entry *e)
+{
+	u32 off = (void *)e - (void *)lb + e->size;
+
+	if (off == lb->tail)
+		return NULL;
+
+	off = logbuf_wrap(lb, off);
+	if (off == lb->tail)
+		return NULL;
+
+	return logbuf_entry(lb, off);
+}
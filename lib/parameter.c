@@ -27,6 +27,7 @@
 #include <string.h>
 #include <globalvar.h>
 #include <linux/err.h>
+#include <linux/hash.h>
 #include <file-list.h>
 #include <stringlist.h>
 
@@ -49,19 +50,80 @@ const char *get_param_type(struct param_d *param)
 	return param_type_string[param->type];
 }
 
+/*
+ * All parameters are additionally hashed by their object and name, so
+ * looking up one of the many globalvars doesn't have to walk the list.
+ */
+#define PARAM_HASH_BITS	10
+
+static struct hlist_head param_hash[1 << PARAM_HASH_BITS];
+
+static struct hlist_head *param_bucket(struct bobject *bobj, const char *name)
+{
+	u32 hash = hash_ptr(bobj, 32);
+
+	while (*name)
+		hash = hash * 31 + *name++;
+
+	return &param_hash[hash_32(hash, PARAM_HASH_BITS)];
+}
+
 struct param_d *get_param_by_name(bobject_t _bobj, const char *name)
 {
 	struct bobject *bobj = _bobj.bobj;
 	struct param_d *p;
 
+	hlist_for_each_entry(p, param_bucket(bobj, name), hnode) {
+		if (p->bobj == bobj && !strcmp(p->name, name))
+			return p;
+	}
+
+	return NULL;
+}
+
+/**
+ * param_first_with_prefix - find the first parameter starting with a prefix
+ * @param bobj	The barebox object
+ * @param prefix	The prefix
+ *
+ * The parameter list is sorted by name, so all parameters starting with
+ * @prefix follow the returned one.
+ */
+struct param_d *param_first_with_prefix(bobject_t _bobj, const char *prefix)
+{
+	struct bobject *bobj = _bobj.bobj;
+	size_t len = strlen(prefix);
+	struct param_d *p;
+
 	list_for_each_entry(p, &bobj->parameters, list) {
-		if (!strcmp(p->name, name))
+		int cmp = strncmp(p->name, prefix, len);
+
+		if (!cmp)
 			return p;
+		if (cmp > 0)
+			break;
 	}
 
 	return NULL;
 }
 
+/**
+ * param_next_with_prefix - get the parameter following @p if it starts with @prefix
+ * @param p	The current parameter
+ * @param prefix	The prefix
+ */
+struct param_d *param_next_with_prefix(struct param_d *p, const char *prefix)
+{
+	if (list_is_last(&p->list, &p->bobj->parameters))
+		return NULL;
+
+	p = list_next_entry(p, list);
+	if (strncmp(p->name, prefix, strlen(prefix)))
+		return NULL;
+
+	return p;
+}
+
 /**
  * bobject_get_param - get the value of a parameter
  * @param bobj	The barebox object
@@ -180,6 +242,7 @@ static int __bobject_add_param(struct param_d *param, struct bobject *bobj,
 	param->flags = flags;
 	param->bobj = bobj;
 	list_add_sort(&param->list, &bobj->parameters, compare);
+	hlist_add_head(&param->hnode, param_bucket(bobj, param->name));
 
 	if (!bobj->local)
 		dev_param_init_from_nv(bobj_to_dev(bobj), name);
@@ -1103,6 +1166,7 @@ void param_remove(struct param_d *p)
 {
 	p->set(p->bobj, p, NULL);
 	list_del(&p->list);
+	hlist_del(&p->hnode);
 	free_const(p->name);
 	free(p);
 }
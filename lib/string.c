@@ -19,6 +19,7 @@
 #include <asm/word-at-a-time.h>
 #include <malloc.h>
 #include <asm-generic/sections.h>
+#include <linux/instruction_pointer.h>
 
 #ifndef __HAVE_ARCH_STRCASECMP
 int strcasecmp(const char *s1, const char *s2)
@@ -435,7 +436,12 @@ static __always_inline char *__memdup_nul(const char *s, size_t len)
 #ifndef __HAVE_ARCH_STRDUP
 char * strdup(const char *s)
 {
-	return s ? __memdup_nul(s, strlen(s)) : NULL;
+	if (!s)
+		return NULL;
+
+	malloc_profile_caller(_RET_IP_);
+
+	return __memdup_nul(s, strlen(s));
 }
 #endif
 EXPORT_SYMBOL(strdup);
@@ -443,7 +449,12 @@ EXPORT_SYMBOL(strdup);
 #ifndef __HAVE_ARCH_STRNDUP
 char *strndup(const char *s, size_t n)
 {
-	return s ? __memdup_nul(s, strnlen(s, n)) : NULL;
+	if (!s)
+		return NULL;
+
+	malloc_profile_caller(_RET_IP_);
+
+	return __memdup_nul(s, strnlen(s, n));
 }
 
 #endif
@@ -985,6 +996,8 @@ void *memdup(const void *orig, size_t size)
 {
 	void *buf;
 
+	malloc_profile_caller(_RET_IP_);
+
 	buf = malloc(size);
 	if (!buf)
 		return NULL;
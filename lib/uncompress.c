@@ -26,6 +26,7 @@
 #include <malloc.h>
 #include <fs.h>
 #include <libfile.h>
+#include <bootprofile.h>
 
 static void *uncompress_buf;
 static unsigned long uncompress_size;
@@ -79,6 +80,7 @@ int uncompress(unsigned char *inbuf, long len,
 	int ret;
 	char *err;
 	void *uncompress_buf_free = NULL;
+	u64 start = bootprofile_start();
 
 	if (inbuf) {
 		ft = file_detect_compression_type(inbuf, len);
@@ -142,6 +144,9 @@ int uncompress(unsigned char *inbuf, long len,
 
 	ret = compfn(inbuf, len, fill ? uncompress_fill : NULL,
 			flush, output, pos, error_fn);
+
+	bootprofile_event(BOOTPROFILE_DECOMPRESS, file_type_to_short_string(ft),
+			  start, ret);
 err:
 	free(uncompress_buf_free);
 
@@ -191,13 +196,40 @@ int uncompress_buf_to_fd(const void *input, size_t input_len,
 			  NULL, NULL, error_fn);
 }
 
+static ssize_t uncompress_buf_to_buf_parallel(const void *input,
+					      size_t input_len, void **buf,
+					      void(*error_fn)(char *x))
+{
+	switch (file_detect_compression_type(input, input_len)) {
+#ifdef CONFIG_XZ_DECOMPRESS
+	case filetype_xz_compressed:
+		return unxz_parallel(input, input_len, buf, error_fn);
+#endif
+#ifdef CONFIG_ZSTD_DECOMPRESS
+	case filetype_zstd_compressed:
+		return unzstd_parallel(input, input_len, buf, error_fn);
+#endif
+	default:
+		return -ENOTSUPP;
+	}
+}
+
 ssize_t uncompress_buf_to_buf(const void *input, size_t input_len,
 			      void **buf, void(*error_fn)(char *x))
 {
 	size_t size;
+	ssize_t len;
 	int fd, ret;
 	void *p;
 
+	/*
+	 * Formats with an index of independently compressed chunks are
+	 * decompressed straight into the output buffer, on all CPUs.
+	 */
+	len = uncompress_buf_to_buf_parallel(input, input_len, buf, error_fn);
+	if (len != -ENOTSUPP)
+		return len;
+
 	fd = open("/tmp", O_TMPFILE | O_RDWR);
 	if (fd < 0)
 		return -ENODEV;
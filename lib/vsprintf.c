@@ -25,6 +25,7 @@
 
 #include <common.h>
 #include <pbl.h>
+#include <linux/instruction_pointer.h>
 
 /* we use this so that we can do without the ctype library */
 #define is_digit(c)	((c) >= '0' && (c) <= '9')
@@ -964,6 +965,8 @@ int vasprintf(char **strp, const char *fmt, va_list ap)
 	if (IN_PBL)
 		return -1;
 
+	malloc_profile_caller(_RET_IP_);
+
 	va_copy(aq, ap);
 	len = vsnprintf(NULL, 0, fmt, aq);
 	va_end(aq);
@@ -985,6 +988,8 @@ char *bvasprintf(const char *fmt, va_list ap)
 	char *p;
 	int len;
 
+	malloc_profile_caller(_RET_IP_);
+
 	len = vasprintf(&p, fmt, ap);
 	if (len < 0)
 		return NULL;
@@ -998,6 +1003,8 @@ int asprintf(char **strp, const char *fmt, ...)
 	va_list ap;
 	int len;
 
+	malloc_profile_caller(_RET_IP_);
+
 	va_start(ap, fmt);
 	len = vasprintf(strp, fmt, ap);
 	va_end(ap);
@@ -22,6 +22,7 @@
 #include <talloc.h>
 #include <module.h>
 #include <wchar.h>
+#include <linux/instruction_pointer.h>
 
 static void __noreturn enomem_panic(size_t size)
 {
@@ -38,6 +39,8 @@ void *xmalloc(size_t size)
 {
 	void *p = NULL;
 
+	malloc_profile_caller(_RET_IP_);
+
 	if (!(p = malloc(size)))
 		enomem_panic(size);
 
@@ -60,6 +63,8 @@ void *xrealloc(void *ptr, size_t size)
 {
 	void *p = NULL;
 
+	malloc_profile_caller(_RET_IP_);
+
 	if (!(p = realloc(ptr, size)))
 		enomem_panic(size);
 
@@ -69,7 +74,11 @@ EXPORT_SYMBOL(xrealloc);
 
 void *xzalloc(size_t size)
 {
-	void *ptr = xmalloc(size);
+	void *ptr;
+
+	malloc_profile_caller(_RET_IP_);
+
+	ptr = xmalloc(size);
 	memset(ptr, 0, size);
 	return ptr;
 }
@@ -90,6 +99,8 @@ char *xstrdup(const char *s)
 	if (!s)
 		return NULL;
 
+	malloc_profile_caller(_RET_IP_);
+
 	p = strdup(s);
 	if (!p)
 		enomem_panic(strlen(s) + 1);
@@ -113,6 +124,7 @@ char *xstrndup(const char *s, size_t n)
 		t++;
 	}
 	n -= m;
+	malloc_profile_caller(_RET_IP_);
 	t = xmalloc(n + 1);
 	t[n] = '\0';
 
@@ -122,7 +134,11 @@ EXPORT_SYMBOL(xstrndup);
 
 void* xmemalign(size_t alignment, size_t bytes)
 {
-	void *p = memalign(alignment, bytes);
+	void *p;
+
+	malloc_profile_caller(_RET_IP_);
+
+	p = memalign(alignment, bytes);
 	if (!p)
 		enomem_panic(bytes);
 
@@ -132,7 +148,11 @@ EXPORT_SYMBOL(xmemalign);
 
 void *xmemdup(const void *orig, size_t size)
 {
-	void *buf = xmalloc(size);
+	void *buf;
+
+	malloc_profile_caller(_RET_IP_);
+
+	buf = xmalloc(size);
 
 	memcpy(buf, orig, size);
 
@@ -144,6 +164,8 @@ char *xvasprintf(const char *fmt, va_list ap)
 {
 	char *p;
 
+	malloc_profile_caller(_RET_IP_);
+
 	p = bvasprintf(fmt, ap);
 	if (!p)
 		enomem_panic(0);
@@ -156,6 +178,8 @@ char *xasprintf(const char *fmt, ...)
 	va_list ap;
 	char *p;
 
+	malloc_profile_caller(_RET_IP_);
+
 	va_start(ap, fmt);
 	p = xvasprintf(fmt, ap);
 	va_end(ap);
@@ -20,6 +20,7 @@
 #include <environment.h>
 #include <linux/ctype.h>
 #include <linux/stat.h>
+#include <bootprofile.h>
 
 DEFINE_DEV_CLASS(eth_class, "eth");
 
@@ -255,6 +256,7 @@ int eth_send(struct eth_device *edev, void *packet, int length)
 	slice_acquire(eth_device_slice(edev));
 
 	led_trigger_network(LED_TRIGGER_NET_TX);
+	bootprofile_instant(BOOTPROFILE_NET_TX, eth_name(edev), length);
 
 	ret = eth_send_raw(edev, packet, length);
 
@@ -283,6 +285,7 @@ static void eth_do_work(struct eth_device *edev)
 
 	list_for_each_entry_safe(q, tmp, &edev->send_queue, list) {
 		led_trigger_network(LED_TRIGGER_NET_TX);
+		bootprofile_instant(BOOTPROFILE_NET_TX, eth_name(edev), q->length);
 		eth_send_raw(edev, q->data, q->length);
 		list_del(&q->list);
 		free(q->data);
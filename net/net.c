@@ -28,6 +28,7 @@
 #include <machine_id.h>
 #include <linux/ctype.h>
 #include <linux/err.h>
+#include <bootprofile.h>
 
 static unsigned int net_ip_id;
 
@@ -811,6 +812,7 @@ int net_receive(struct eth_device *edev, unsigned char *pkt, int len)
 	int ret;
 
 	led_trigger_network(LED_TRIGGER_NET_RX);
+	bootprofile_instant(BOOTPROFILE_NET_RX, eth_name(edev), len);
 
 	if (len < ETHER_HDR_SIZE) {
 		ret = 0;
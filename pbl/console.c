@@ -4,6 +4,8 @@
 #include <debug_ll.h>
 #include <asm/sections.h>
 #include <linux/err.h>
+#include <logbuf.h>
+#include <pbl/handoff-data.h>
 
 /*
  * Put these in the data section so that they survive the clearing of the
@@ -71,6 +73,36 @@ int printf(const char *fmt, ...)
 	return i;
 }
 
+#ifdef CONFIG_PBL_LOGBUF
+static u64 pbl_logbuf_mem[CONFIG_PBL_LOGBUF_SIZE / sizeof(u64)];
+static struct logbuf *pbl_logbuf;
+
+static void pbl_log(int level, const char *str)
+{
+	size_t size;
+
+	if (!pbl_logbuf) {
+		/*
+		 * The handoff entry survives the PBL being moved and
+		 * re-entered, but it then refers to the buffer at the old
+		 * location. Don't log in this case.
+		 */
+		if (handoff_data_get_entry(HANDOFF_DATA_PBL_LOG, &size))
+			return;
+
+		pbl_logbuf = logbuf_init(pbl_logbuf_mem, sizeof(pbl_logbuf_mem));
+		handoff_data_add(HANDOFF_DATA_PBL_LOG, pbl_logbuf,
+				 sizeof(pbl_logbuf_mem));
+	}
+
+	logbuf_add(pbl_logbuf, 0, level, LOG_ENTRY_PBL, str);
+}
+#else
+static inline void pbl_log(int level, const char *str)
+{
+}
+#endif
+
 int pr_print(int level, const char *fmt, ...)
 {
 	va_list args;
@@ -81,6 +113,7 @@ int pr_print(int level, const char *fmt, ...)
 	i = vsnprintf(printbuffer, sizeof(printbuffer), fmt, args);
 	va_end(args);
 
+	pbl_log(level, printbuffer);
 	console_puts(CONSOLE_STDERR, printbuffer);
 
 	return i;
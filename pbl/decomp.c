@@ -31,6 +31,13 @@
 #include "../../../lib/decompress_unxz.c"
 #endif
 
+#ifdef CONFIG_IMAGE_COMPRESSION_ZSTD
+/* the zstd sources export their API, which means nothing in the PBL */
+#undef EXPORT_SYMBOL
+#define EXPORT_SYMBOL(sym)
+#include "../../../lib/decompress_unzstd.c"
+#endif
+
 #ifdef CONFIG_IMAGE_COMPRESSION_NONE
 STATIC int decompress(u8 *input, int in_len,
 				int (*fill) (void *, unsigned int),
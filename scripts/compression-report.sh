@@ -0,0 +1,82 @@
+#!/bin/sh
+# SPDX-License-Identifier: GPL-2.0-only
+#
+# Compress a binary with every algorithm supported for the PBL image and
+# report compressed size and decompression throughput. The throughput is
+# measured on the build host, so only the relation between the
+# algorithms is meaningful, not the absolute numbers.
+#
+# usage: compression-report.sh <barebox.bin>
+
+in="$1"
+
+if [ ! -f "$in" ]; then
+	echo "usage: $0 <file>" >&2
+	exit 1
+fi
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+size=$(wc -c < "$in")
+runs=10
+
+now_ns() {
+	date +%s%N
+}
+
+# report <name> <compressed file> <decompress command...>
+report() {
+	name=$1
+	file=$2
+	shift 2
+
+	csize=$(wc -c < "$file")
+
+	start=$(now_ns)
+	i=0
+	while [ $i -lt $runs ]; do
+		"$@" < "$file" > /dev/null || return
+		i=$((i + 1))
+	done
+	ns=$(($(now_ns) - start))
+	[ $ns -gt 0 ] || ns=1
+
+	printf '%-8s %10d %5d.%d%% %10d\n' "$name" "$csize" \
+		$((csize * 100 / size)) $((csize * 1000 / size % 10)) \
+		$((size * runs * 1000000000 / ns / 1048576))
+}
+
+# try <name> <compress command> -- <decompress command>
+try() {
+	name=$1
+	shift
+
+	comp=
+	while [ "$1" != "--" ]; do
+		comp="$comp $1"
+		shift
+	done
+	shift
+
+	command -v "$1" > /dev/null 2>&1 || {
+		printf '%-8s %s not found\n' "$name" "$1"
+		return
+	}
+
+	$comp < "$in" > "$tmp/$name" 2> /dev/null || {
+		printf '%-8s compression failed\n' "$name"
+		return
+	}
+
+	report "$name" "$tmp/$name" "$@"
+}
+
+printf '%-8s %10s %7s %10s\n' codec bytes ratio "MiB/s"
+printf '%-8s %10d %5d.0%% %10s\n' none "$size" 100 -
+
+try lz4 ${LZ4:-lz4} -l --best -- ${LZ4:-lz4} -dc
+try lzo ${KLZOP:-lzop} -9 -- ${KLZOP:-lzop} -dc
+try gzip ${KGZIP:-gzip} -n -9 -- ${KGZIP:-gzip} -dc
+try xz sh ${srctree:-.}/scripts/xz_wrap.sh -- ${XZ:-xz} -dc
+try zstd ${ZSTD:-zstd} -22 --ultra -- ${ZSTD:-zstd} -dc
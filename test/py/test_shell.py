@@ -80,3 +80,55 @@ def test_cmd_clk(barebox, barebox_config):
     assert regions >= 0
 
     assert count_dicts_in_command_output(barebox, 'clk_dump -vj') == regions
+
+
+def run_script(barebox, script, args=""):
+    return barebox.run_check(f"sh {script} {args}".rstrip())
+
+
+def test_shell_script_args(barebox, barebox_config):
+    skip_disabled(barebox_config, "CONFIG_CMD_ECHO_E")
+
+    script = "/tmp/test-args.sh"
+    barebox.run_check(f"echo -e -o {script} 'echo $# $1\\necho done'")
+
+    # run each twice, so that cached scripts are exercised as well
+    for _ in range(2):
+        assert run_script(barebox, script, "a") == ["1 a", "done"]
+        assert run_script(barebox, script, "b c") == ["2 b", "done"]
+        assert run_script(barebox, script) == ["0", "done"]
+
+    barebox.run_check(f"rm {script}")
+
+
+def test_shell_script_getopt(barebox, barebox_config):
+    skip_disabled(barebox_config, "CONFIG_CMD_ECHO_E", "CONFIG_CMD_GETOPT")
+
+    script = "/tmp/test-getopt.sh"
+    barebox.run_check(f"echo -e -o {script} "
+                      "'while getopt \"vn:\" opt; do\\n"
+                      "echo opt $opt $OPTARG\\n"
+                      "done\\n"
+                      "echo args $# $1'")
+
+    for _ in range(2):
+        assert run_script(barebox, script, "-v -n 3 foo") == \
+            ["opt v", "opt n 3", "args 1 foo"]
+        assert run_script(barebox, script, "foo") == ["args 1 foo"]
+        assert run_script(barebox, script) == ["args 0"]
+
+    barebox.run_check(f"rm {script}")
+
+
+def test_find_cmd(barebox, barebox_config):
+    skip_disabled(barebox_config, "CONFIG_CMD_HELP")
+
+    stdout = barebox.run_check("help help")
+    assert any(line.startswith("help - ") for line in stdout)
+
+    _, _, returncode = barebox.run("help no-such-command")
+    assert returncode == 1
+
+    stdout, _, returncode = barebox.run("no-such-command")
+    assert returncode != 0
+    assert stdout[0].startswith("Unknown command 'no-such-command'")
@@ -0,0 +1,51 @@
+# SPDX-License-Identifier: GPL-2.0-only
+
+import re
+import pytest
+
+from .helper import skip_disabled
+
+
+def udcbench(barebox, test, size):
+    stdout = barebox.run_check(f"udcbench -s {size} {test}")
+
+    results = [m for line in stdout
+               if (m := re.match(r"^(.+): (\d+) bytes in \d+ ms, \d+ KiB/s$", line))]
+    assert len(results) == 1, stdout
+    match = results[0]
+    assert int(match.group(2)) == size
+
+    eps = [line for line in stdout if line.strip().startswith("ep 0x")]
+    assert len(eps) == 2, stdout
+
+    return match.group(1)
+
+
+@pytest.fixture
+def usbgadget(barebox, barebox_config):
+    skip_disabled(barebox_config, "CONFIG_CMD_UDCBENCH", "CONFIG_CMD_USBGADGET")
+
+    yield lambda args: barebox.run_check(f"usbgadget {args}")
+
+    barebox.run("usbgadget -d")
+
+
+def test_udcbench_fastboot(barebox, barebox_config, usbgadget):
+    skip_disabled(barebox_config, "CONFIG_USB_GADGET_FASTBOOT")
+
+    usbgadget("-A /tmp/udcbench.img(img)")
+
+    assert udcbench(barebox, "fastboot", 1024 * 1024) == "fastboot download"
+
+
+def test_udcbench_ums(barebox, barebox_config, usbgadget):
+    skip_disabled(barebox_config, "CONFIG_USB_GADGET_MASS_STORAGE",
+                  "CONFIG_CMD_MEMSET")
+
+    barebox.run_check("memset -d /tmp/udcbench.img 0 0 0x200000")
+    usbgadget("-S /tmp/udcbench.img(ums)")
+
+    assert udcbench(barebox, "ums-write", 1024 * 1024) == "ums write"
+    assert udcbench(barebox, "ums-read", 1024 * 1024) == "ums read"
+
+    barebox.run_check("rm /tmp/udcbench.img")
@@ -6,6 +6,10 @@
 #include <bselftest.h>
 #include <clock.h>
 #include <digest.h>
+#include <crc.h>
+#include <stdlib.h>
+#include <linux/sizes.h>
+#include <asm/unaligned.h>
 
 BSELFTEST_GLOBALS();
 
@@ -168,11 +172,31 @@ static void test_digests_sha12(const char *suffix)
 }
 
 
+/*
+ * Accelerated implementations only register if the CPU supports them,
+ * so don't count their absence as failure.
+ */
+static bool digest_driver_registered(const char *algo, const char *suffix)
+{
+	struct digest *d;
+
+	d = digest_alloc(digest_suffix(algo, suffix));
+	if (!d)
+		return false;
+
+	digest_free(d);
+	return true;
+}
+
 static void test_digests_sha35(const char *suffix)
 {
 	bool cond;
 
 	cond = !strcmp(suffix, "generic") ? IS_ENABLED(CONFIG_DIGEST_SHA384_GENERIC) :
+	       !strcmp(suffix, "neon") ? IS_ENABLED(CONFIG_DIGEST_SHA512_ARM_NEON) &&
+					 digest_driver_registered("sha384", suffix) :
+	       !strcmp(suffix, "ce")  ? IS_ENABLED(CONFIG_DIGEST_SHA512_ARM64_CE) &&
+					digest_driver_registered("sha384", suffix) :
 	       IS_ENABLED(CONFIG_HAVE_DIGEST_SHA384);
 
 	test_digest(cond, digest_suffix("sha384", suffix),
@@ -185,6 +209,10 @@ static void test_digests_sha35(const char *suffix)
 
 
 	cond = !strcmp(suffix, "generic") ? IS_ENABLED(CONFIG_DIGEST_SHA512_GENERIC) :
+	       !strcmp(suffix, "neon") ? IS_ENABLED(CONFIG_DIGEST_SHA512_ARM_NEON) &&
+					 digest_driver_registered("sha512", suffix) :
+	       !strcmp(suffix, "ce")  ? IS_ENABLED(CONFIG_DIGEST_SHA512_ARM64_CE) &&
+					digest_driver_registered("sha512", suffix) :
 	       IS_ENABLED(CONFIG_HAVE_DIGEST_SHA512);
 
 	test_digest(cond, digest_suffix("sha512", suffix),
@@ -196,6 +224,86 @@ static void test_digests_sha35(const char *suffix)
 				   "60a5a68aa0017e3446433349b42592b74713d7787628a58e400b7f588b9bd69b"));
 }
 
+static void test_digest_crc32(const char *suffix)
+{
+	bool cond;
+
+	cond = !strcmp(suffix, "generic") ? IS_ENABLED(CONFIG_DIGEST_CRC32_GENERIC) :
+	       !strcmp(suffix, "ce")  ? IS_ENABLED(CONFIG_DIGEST_CRC32_ARM64_CE) :
+	       !strcmp(suffix, "pclmul")  ? IS_ENABLED(CONFIG_DIGEST_CRC32_X86_PCLMUL) :
+	       IS_ENABLED(CONFIG_DIGEST_CRC32_GENERIC);
+
+	test_digest(cond, digest_suffix("crc32", suffix),
+		TEST_CASE(zeroes7, "9d6cdf7e"),
+		TEST_CASE(one32,   "e8d05007"),
+		TEST_CASE(inc4097, "d1169ca1"));
+}
+
+#define CRC32_BENCH_SIZE	SZ_1M
+
+/*
+ * Accelerated CRC32 implementations usually have separate code paths for
+ * the head, bulk and tail of a buffer, so compare them and crc32(), which
+ * dispatches to the architecture implementation, against the table based
+ * crc32_le_base() for all combinations of misalignment and a range of
+ * lengths.
+ */
+static void test_crc32_backend(bool option, const char *driver)
+{
+	struct digest *d;
+	u8 *buf, md[4];
+	unsigned off, len;
+	u32 crc;
+	u64 seed = 0xc3c32;
+	u64 start;
+
+	total_tests++;
+
+	if (!option) {
+		skipped_tests++;
+		return;
+	}
+
+	d = digest_alloc(driver);
+	if (!d) {
+		/* not supported by this CPU */
+		skipped_tests++;
+		return;
+	}
+
+	buf = malloc(CRC32_BENCH_SIZE);
+	if (WARN_ON(!buf)) {
+		failed_tests++;
+		goto out;
+	}
+
+	randbuf_r(&seed, buf, CRC32_BENCH_SIZE);
+
+	for (off = 0; off < 16; off++) {
+		for (len = 1; len < 1024; len += (len < 160 ? 1 : 61)) {
+			digest_digest(d, buf + off, len, md);
+			crc = ~crc32_le_base(~0U, buf + off, len);
+			if (get_unaligned_be32(md) == crc &&
+			    crc32(0, buf + off, len) == crc)
+				continue;
+
+			printf("%s: mismatch at offset %u, length %u\n",
+			       driver, off, len);
+			failed_tests++;
+			goto out;
+		}
+	}
+
+	start = get_time_ns();
+	digest_digest(d, buf, CRC32_BENCH_SIZE, md);
+	if (__is_defined(DEBUG))
+		printf("%s:\t %u bytes in %lluns\n", driver, CRC32_BENCH_SIZE,
+		       get_time_ns() - start);
+out:
+	free(buf);
+	digest_free(d);
+}
+
 static void test_digests(void)
 {
 	int i;
@@ -210,10 +318,20 @@ static void test_digests(void)
 		test_digests_sha12("asm");
 
 	test_digests_sha35("generic");
+	if (IS_ENABLED(CONFIG_ARM32))
+		test_digests_sha35("neon");
+	if (IS_ENABLED(CONFIG_ARM64))
+		test_digests_sha35("ce");
+
+	test_digest_crc32("generic");
+
+	test_crc32_backend(IS_ENABLED(CONFIG_DIGEST_CRC32_GENERIC), "crc32-generic");
+	test_crc32_backend(IS_ENABLED(CONFIG_DIGEST_CRC32_ARM64_CE), "crc32-ce");
+	test_crc32_backend(IS_ENABLED(CONFIG_DIGEST_CRC32_X86_PCLMUL), "crc32-pclmul");
 
 	test_digest_md5("");
 	test_digests_sha12("");
 	test_digests_sha35("");
-
+	test_digest_crc32("");
 }
 bselftest(core, test_digests);
@@ -4,6 +4,7 @@
 
 #include <common.h>
 #include <environment.h>
+#include <globalvar.h>
 #include <bselftest.h>
 #include <linux/sizes.h>
 
@@ -80,3 +81,42 @@ static void test_envvar(void)
 	unsetenv("__TEST_VAR1");
 }
 bselftest(core, test_envvar);
+
+static void test_globalvar(void)
+{
+	char *match;
+
+	if (!IS_ENABLED(CONFIG_GLOBALVAR)) {
+		pr_info("built without globalvar support: Skipping tests\n");
+		skipped_tests++;
+		return;
+	}
+
+	globalvar_add_simple("selftest.b", "2");
+	globalvar_add_simple("selftest.a", "1");
+	globalvar_add_simple("selftestx", "3");
+	globalvar_add_simple("selftest", "4");
+
+	expect_getenv("global.selftest.a", "1");
+	expect_getenv("global.selftest.b", "2");
+	expect_getenv("global.selftest.c", NULL);
+
+	total_tests++;
+	match = globalvar_get_match("selftest.", " ");
+	if (strcmp(match, "1 2")) {
+		failed_tests++;
+		printf("%s: failure: got \"%s\" for prefix selftest.\n",
+		       __func__, match);
+	}
+	free(match);
+
+	globalvar_remove("selftest.a");
+	expect_getenv("global.selftest.a", NULL);
+	expect_getenv("global.selftest.b", "2");
+
+	globalvar_remove("selftest*");
+	expect_getenv("global.selftest.b", NULL);
+	expect_getenv("global.selftestx", NULL);
+	expect_getenv("global.selftest", NULL);
+}
+bselftest(core, test_globalvar);
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <common.h>
+#include <bselftest.h>
+#include <malloc.h>
+#include <memtest.h>
+#include <linux/sizes.h>
+
+BSELFTEST_GLOBALS();
+
+/*
+ * Two chunks for the engine, the second one covering both the unrolled
+ * loop and the remainder loop.
+ */
+#define TEST_WORDS	(SZ_1M / sizeof(unsigned long) + 7)
+#define TEST_SIZE	(TEST_WORDS * sizeof(unsigned long))
+
+static unsigned int inject_pass;
+static unsigned long inject_word;
+
+static void memtest_flip_bit(unsigned long *words, unsigned long num_words,
+			     unsigned int pass)
+{
+	if (pass == inject_pass && inject_word < num_words)
+		words[inject_word] ^= BIT(pass % BITS_PER_LONG);
+}
+
+static int memtest_run(unsigned long *buf, unsigned flags)
+{
+	return mem_test_moving_inversions((resource_size_t)(uintptr_t)buf,
+					  (resource_size_t)(uintptr_t)buf + TEST_SIZE - 1,
+					  flags);
+}
+
+static void test_memtest_pass(unsigned long *buf, unsigned flags)
+{
+	int ret;
+
+	total_tests++;
+
+	ret = memtest_run(buf, flags);
+	if (ret) {
+		printf("memtest flags 0x%x failed on good memory: %pe\n",
+		       flags, ERR_PTR(ret));
+		failed_tests++;
+		return;
+	}
+
+	/* the last pattern is all zeroes and must reach every word */
+	if (memchr_inv(buf, 0, TEST_SIZE)) {
+		printf("memtest flags 0x%x did not fill the whole buffer\n", flags);
+		failed_tests++;
+	}
+}
+
+static void test_memtest_fail(unsigned long *buf, unsigned flags,
+			      unsigned int pass, unsigned long word)
+{
+	int ret;
+
+	total_tests++;
+
+	inject_pass = pass;
+	inject_word = word;
+	mem_test_pass_hook = memtest_flip_bit;
+
+	ret = memtest_run(buf, flags);
+
+	mem_test_pass_hook = NULL;
+
+	if (ret != -EIO) {
+		printf("memtest flags 0x%x: bit flip after pass %u in word %lu: expected %pe, got %pe\n",
+		       flags, pass, word, ERR_PTR(-EIO), ERR_PTR(ret));
+		failed_tests++;
+	}
+}
+
+static void test_memtest_flags(unsigned long *buf, unsigned flags,
+			       unsigned int num_patterns)
+{
+	static const unsigned long words[] = {
+		0, 1, SZ_1M / sizeof(unsigned long) + 2, TEST_WORDS - 1,
+	};
+	int i;
+
+	test_memtest_pass(buf, flags);
+
+	/* a flip is found by the next pass, the last pattern is not checked */
+	for (i = 0; i < ARRAY_SIZE(words); i++) {
+		test_memtest_fail(buf, flags, 0, words[i]);
+		test_memtest_fail(buf, flags, num_patterns - 2, words[i]);
+	}
+
+	/* and the engine must recover once memory is good again */
+	test_memtest_pass(buf, flags);
+}
+
+static void test_memtest(void)
+{
+	unsigned long *buf;
+
+	buf = malloc(TEST_SIZE);
+	if (!buf) {
+		skipped_tests++;
+		return;
+	}
+
+	test_memtest_flags(buf, 0, 3);
+	test_memtest_flags(buf, MEMTEST_EXTENDED, 7);
+	test_memtest_flags(buf, MEMTEST_OFFLOAD, 3);
+	test_memtest_flags(buf, MEMTEST_EXTENDED | MEMTEST_OFFLOAD, 7);
+
+	free(buf);
+}
+bselftest(core, test_memtest);
@@ -110,6 +110,50 @@ static void test_of_property_strings(struct device_node *root)
 	assert_equal(np3, np4);
 }
 
+/*
+ * Modify an unflattened tree and a heap allocated copy of it the same
+ * way. This mixes memory owned by the tree with memory allocated later
+ * on, which must all be freed correctly when the trees are deleted.
+ */
+static void test_of_modify_unflattened(struct device_node *unflattened)
+{
+	struct device_node *copy = of_dup(unflattened);
+	struct device_node *roots[] = { unflattened, copy };
+	struct device_node *np;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(roots); i++) {
+		np = of_find_node_by_path_from(roots[i], "/np1");
+		of_append_property(np, "property-single", "bee", 4);
+		of_prepend_property(np, "property-multi", "sea", 4);
+		of_rename_property(np, "property-single", "property-renamed");
+
+		/* replace values owned by the tree, then a heap allocated one */
+		np = of_find_node_by_path_from(roots[i], "/np2");
+		of_set_property(np, "property-single", "bee", 4, 0);
+		of_set_property(np, "property-multi", "sea", 4, 0);
+		of_set_property(np, "property-multi", "ayy", 4, 0);
+
+		np = of_find_node_by_path_from(roots[i], "/node1/node21");
+		of_delete_node(np);
+
+		np = of_find_node_by_path_from(roots[i], "/node2");
+		of_property_write_u32(np, "property1", 3);
+		of_new_node(np, "node22");
+	}
+
+	assert_equal(unflattened, copy);
+
+	total_tests++;
+	np = of_find_node_by_path_from(unflattened, "/np2");
+	if (!np || strcmp(of_get_property(np, "property-single", NULL) ?: "", "bee")) {
+		pr_warn("replacing a property value of an unflattened tree failed\n");
+		failed_tests++;
+	}
+
+	of_delete_node(copy);
+}
+
 static void __init test_of_manipulation(void)
 {
 	extern char __dtb_of_manipulation_start[], __dtb_of_manipulation_end[];
@@ -126,6 +170,8 @@ static void __init test_of_manipulation(void)
 
 	assert_equal(root, expected);
 
+	test_of_modify_unflattened(expected);
+
 	of_delete_node(root);
 	of_delete_node(expected);
 }
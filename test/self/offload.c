@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <common.h>
+#include <bselftest.h>
+#include <crypto/sha.h>
+#include <digest.h>
+#include <malloc.h>
+#include <offload.h>
+#include <stdlib.h>
+#include <linux/sizes.h>
+
+BSELFTEST_GLOBALS();
+
+#define NUM_JOBS	32
+#define JOB_SIZE	SZ_64K
+
+struct sum_job {
+	struct offload_job job;
+	const u32 *buf;
+	size_t n;
+	u32 sum;
+};
+
+static int sum_fn(struct offload_job *job)
+{
+	struct sum_job *sj = container_of(job, struct sum_job, job);
+	size_t i;
+
+	for (i = 0; i < sj->n; i++)
+		sj->sum += sj->buf[i];
+
+	return sj->n;
+}
+
+static void test_offload_jobs(const u32 *buf)
+{
+	struct sum_job *jobs;
+	unsigned int i;
+
+	jobs = xzalloc(NUM_JOBS * sizeof(*jobs));
+
+	for (i = 0; i < NUM_JOBS; i++) {
+		jobs[i].buf = buf + i * JOB_SIZE / sizeof(u32);
+		jobs[i].n = JOB_SIZE / sizeof(u32);
+
+		offload_job_init(&jobs[i].job, sum_fn);
+		offload_job_submit(&jobs[i].job);
+	}
+
+	for (i = 0; i < NUM_JOBS; i++) {
+		u32 sum = 0;
+		size_t j;
+		int ret;
+
+		total_tests++;
+
+		ret = offload_job_wait(&jobs[i].job);
+
+		for (j = 0; j < jobs[i].n; j++)
+			sum += jobs[i].buf[j];
+
+		if (ret != jobs[i].n || jobs[i].sum != sum) {
+			failed_tests++;
+			printf("job %u: ret %d sum 0x%08x, expected %zu 0x%08x\n",
+			       i, ret, jobs[i].sum, jobs[i].n, sum);
+		}
+	}
+
+	free(jobs);
+}
+
+static void test_offload_digest(const u8 *buf)
+{
+	struct offload_digest_job dj[4];
+	u8 expect[SHA256_DIGEST_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(dj); i++) {
+		dj[i].d = digest_alloc("sha256");
+		if (!dj[i].d) {
+			skipped_tests++;
+			goto out;
+		}
+
+		dj[i].buf = buf + i * SZ_256K;
+		dj[i].len = SZ_256K;
+		dj[i].out = xmalloc(SHA256_DIGEST_SIZE);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(dj); i++)
+		offload_digest_submit(&dj[i]);
+
+	for (i = 0; i < ARRAY_SIZE(dj); i++) {
+		total_tests++;
+
+		if (offload_job_wait(&dj[i].job)) {
+			failed_tests++;
+			printf("digest job %u failed\n", i);
+			continue;
+		}
+
+		digest_digest(dj[i].d, dj[i].buf, dj[i].len, expect);
+		if (memcmp(dj[i].out, expect, SHA256_DIGEST_SIZE)) {
+			failed_tests++;
+			printf("digest job %u: %*phN, expected %*phN\n", i,
+			       SHA256_DIGEST_SIZE, dj[i].out,
+			       SHA256_DIGEST_SIZE, expect);
+		}
+	}
+
+out:
+	while (i--) {
+		free(dj[i].out);
+		digest_free(dj[i].d);
+	}
+}
+
+static void test_offload_memset(u8 *buf, size_t len)
+{
+	size_t i = 0;
+
+	total_tests++;
+
+	offload_memset(buf + 1, 0xa5, len - 2);
+
+	if (buf[0] == 0xa5 || buf[len - 1] == 0xa5)
+		goto fail;
+
+	for (i = 1; i < len - 1; i++)
+		if (buf[i] != 0xa5)
+			goto fail;
+
+	return;
+fail:
+	failed_tests++;
+	printf("offload_memset() mismatch at offset %zu\n", i);
+}
+
+static void test_offload(void)
+{
+	u64 seed = 0x1337;
+	size_t len = NUM_JOBS * JOB_SIZE;
+	u8 *buf;
+
+	pr_debug("distributing jobs over %u CPUs\n", offload_num_cpus());
+
+	buf = malloc(len);
+	if (!buf) {
+		skipped_tests++;
+		return;
+	}
+
+	randbuf_r(&seed, buf, len);
+	buf[0] = buf[len - 1] = 0;
+
+	test_offload_jobs((const u32 *)buf);
+	test_offload_digest(buf);
+	test_offload_memset(buf, len);
+
+	free(buf);
+}
+bselftest(core, test_offload);